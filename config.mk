@@ -56,9 +56,20 @@ ARCH_C_SOURCES += \
 	$(R_PATH)/src/system_stm32f4xx.c \
 	$(R_PATH)/src/hw_init.c \
 	$(R_PATH)/src/device/device_impl.c \
+	$(R_PATH)/src/device/dma_impl.c \
 	$(R_PATH)/src/device/gpio_impl.c \
+	$(R_PATH)/src/device/exti_impl.c \
+	$(R_PATH)/src/device/waveform_impl.c \
+	$(R_PATH)/src/device/capture_impl.c \
+	$(R_PATH)/src/device/timebase_impl.c \
+	$(R_PATH)/src/device/rtc_impl.c \
 	$(R_PATH)/src/device/usart_impl.c \
 	$(R_PATH)/src/device/i2c_impl.c \
 	$(R_PATH)/src/device/i2s_impl.c \
 	$(R_PATH)/src/device/spi_impl.c \
-	$(R_PATH)/src/device/cpu_impl.c
+	$(R_PATH)/src/device/spi_nor_impl.c \
+	$(R_PATH)/src/device/cpu_impl.c \
+	$(R_PATH)/src/audio/dsp.c \
+	$(R_PATH)/src/audio/mixer.c \
+	$(R_PATH)/src/audio/resampler.c \
+	$(R_PATH)/src/audio/drift.c
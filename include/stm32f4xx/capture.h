@@ -0,0 +1,96 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_CAPTURE_H_
+#define INCLUDE_STM32F4XX_CAPTURE_H_
+
+#include <stdint.h>
+
+#include "include/stm32f4xx/errors.h"
+
+#include "stm32f4xx.h"
+
+/**
+ * @brief Parallel bus capture
+ *
+ * Every capture/compare 3 event of TIM1 makes DMA2 stream 6 (channel 6) copy the IDR register
+ * of a port into a circular buffer. The event comes either from the timer itself at a fixed
+ * period or from an edge on the TIM1_CH3 pin (PE13), which then acts as the bus clock. Buffers
+ * must be in SRAM, the DMA cannot reach the CCM.
+ *
+ * Because of an STM32F40x erratum DMA2 must not serve GPIO and APB2 peripherals at the same time,
+ * so a capture can't start while SPI1 has a DMA transfer running, and SPI1 DMA transfers are
+ * refused while a capture runs (see dma2_port).
+ */
+
+// TIM1 runs from the APB2 timer clock, which is SystemCoreClock with the clock tree of hw_init()
+#define CAPTURE_NS_TO_TICKS(ns_)    ((uint32_t)(((uint64_t)(ns_) * SystemCoreClock) / 1000000000ULL))
+
+enum capture_width {
+    CAPTURE_WIDTH_8,    // Pins 0-7 or 8-15 of the port, one byte per sample
+    CAPTURE_WIDTH_16,   // Whole port, one half word per sample
+};
+
+enum capture_clock {
+    CAPTURE_CLOCK_TIMER,    // One sample every period
+    CAPTURE_CLOCK_RISING,   // One sample on each rising edge of PE13
+    CAPTURE_CLOCK_FALLING,  // One sample on each falling edge of PE13
+};
+
+struct capture_config {
+    GPIO_TypeDef        *port;
+    uint32_t            ahb1_grp1_periph;
+    uint32_t            first_pin;  // 0 or 8 with CAPTURE_WIDTH_8, 0 otherwise
+    enum capture_width  width;
+    enum capture_clock  clock;
+    uint32_t            period;     // Timer ticks between samples with CAPTURE_CLOCK_TIMER, at least 2
+};
+
+/**
+ * @brief Called from the DMA interrupt each time half of the buffer was filled. samples points
+ * into the buffer and stays valid until the DMA comes back to it, half a buffer later
+ *
+ * @param arg as given to capture_start
+ * @param samples first sample of the half
+ * @param count samples in the half
+ */
+typedef void (*capture_callback)(void *arg, const void *samples, uint32_t count);
+
+/**
+ * @brief Configures the bus pins as inputs and starts capturing until capture_stop
+ *
+ * @param config what and how to capture
+ * @param buffer samples of one or two bytes according to config->width
+ * @param samples size of buffer in samples. Must be even and up to 65534
+ * @param callback called with each filled half
+ * @param arg passed to callback
+ * @return int32_t E_SUCCESS, E_DEVICE_BUSY if a capture is running or DMA2 serves SPI1, or error code
+ */
+int32_t capture_start(const struct capture_config * const config, void *buffer, uint32_t samples,
+    capture_callback callback, void *arg);
+
+/**
+ * @brief Stops capturing
+ */
+void capture_stop(void);
+
+/**
+ * @brief Index in the buffer of the next sample to be written, to find where a trigger happened
+ *
+ * @return uint32_t sample index
+ */
+uint32_t capture_position(void);
+
+/**
+ * @brief Halves overwritten before their callback could run, since capture_start
+ *
+ * @return uint32_t overruns
+ */
+uint32_t capture_overruns(void);
+
+#endif // INCLUDE_STM32F4XX_CAPTURE_H_
@@ -0,0 +1,135 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_CPU_H_
+#define INCLUDE_STM32F4XX_CPU_H_
+
+#include <stdint.h>
+
+#include "include/device/cpu.h"
+#include "include/stm32f4xx/dwt.h"
+
+#include "stm32f4xx.h"
+
+/**
+ * @brief Cycle counting of code regions with DWT->CYCCNT
+ *
+ * Each region has an ID, an index in a static table of CPU_PROF_SLOTS entries. A probe costs a
+ * counter read at the start and a short update with interrupts masked at the end, so probes can
+ * stay in ISRs and hot paths of production builds and can be recorded from any context. Cycles
+ * of interrupts that preempt a region are counted in it.
+ */
+
+// Number of regions that can be profiled
+#define CPU_PROF_SLOTS  32
+
+struct cpu_prof_stats {
+    uint32_t    count;
+    uint32_t    min;
+    uint32_t    max;
+    uint32_t    mean;
+    uint64_t    total;
+};
+
+struct cpu_prof_slot {
+    uint32_t    count;
+    uint32_t    min;
+    uint32_t    max;
+    uint64_t    total;
+};
+
+extern struct cpu_prof_slot cpu_prof_table[CPU_PROF_SLOTS];
+
+/**
+ * @brief Called by stm32f4xx_cpu_prof_dump for each region that was recorded
+ */
+typedef void (*cpu_prof_dump_callback)(void *arg, uint32_t id, const struct cpu_prof_stats * const stats);
+
+/**
+ * @brief Starts the cycle counter if it is not running yet
+ */
+static inline void stm32f4xx_cpu_prof_enable(void)
+{
+    dwt_init();
+}
+
+/**
+ * @brief Cycles counted since the counter was enabled. Wraps every 2^32 cycles (~25 s)
+ */
+static inline uint32_t stm32f4xx_cpu_cycles(void)
+{
+    return dwt_cycles();
+}
+
+/**
+ * @brief Start of a region
+ *
+ * @return uint32_t to be passed to stm32f4xx_cpu_prof_end
+ */
+static inline uint32_t stm32f4xx_cpu_prof_begin(void)
+{
+    return dwt_cycles();
+}
+
+/**
+ * @brief End of a region, records the cycles since start
+ *
+ * @param id region ID, below CPU_PROF_SLOTS. Other IDs are ignored
+ * @param start returned by stm32f4xx_cpu_prof_begin
+ */
+static inline void stm32f4xx_cpu_prof_end(uint32_t id, uint32_t start)
+{
+    uint32_t cycles = dwt_cycles() - start;
+
+    if (id >= CPU_PROF_SLOTS) return;
+
+    struct cpu_prof_slot *slot = &cpu_prof_table[id];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (slot->count == 0 || cycles < slot->min) slot->min = cycles;
+    if (cycles > slot->max) slot->max = cycles;
+    slot->total += cycles;
+    slot->count++;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Profiles the statement or block that follows. Leaving it with break, goto or return
+ * skips the recording
+ */
+#define CPU_PROF_SCOPE(id_) \
+    for (uint32_t prof_start_ = stm32f4xx_cpu_prof_begin(), prof_once_ = 1; prof_once_; \
+        prof_once_ = 0, stm32f4xx_cpu_prof_end((id_), prof_start_))
+
+/**
+ * @brief Statistics of a region
+ *
+ * @param id region ID
+ * @param stats where to store them. All zero if the region was never recorded
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t stm32f4xx_cpu_prof_get(uint32_t id, struct cpu_prof_stats * const stats);
+
+/**
+ * @brief Forgets what was recorded for a region
+ *
+ * @param id region ID
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t stm32f4xx_cpu_prof_reset(uint32_t id);
+
+/**
+ * @brief Calls callback with the statistics of every region recorded at least once, in ID order
+ *
+ * @param callback receives each region. Runs in the caller's context
+ * @param arg passed to callback
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t stm32f4xx_cpu_prof_dump(cpu_prof_dump_callback callback, void *arg);
+
+#endif // INCLUDE_STM32F4XX_CPU_H_
@@ -0,0 +1,163 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_DEVICE_H_
+#define INCLUDE_STM32F4XX_DEVICE_H_
+
+#include <stdint.h>
+
+#include "include/errors.h"
+#include "include/device/device.h"
+
+/**
+ * @brief Devices of the board, as X(id, name, struct tag, object, init function)
+ *
+ * Every other table of the registry is generated from this one, so adding a device here is all
+ * it takes. Names must have distinct device_hash() values.
+ */
+#define STM32F4XX_DEVICES(X)                                                    \
+    X(CPU,          DEFAULT_CPU,    cpu,            stm32f4xx_cpu,  DEVICE_NO_INIT) \
+    X(USART2,       DEFAULT_USART,  usart_device,   usart2,         device_init)    \
+    X(LED,          DEFAULT_LED,    gpio_device,    led_gpio,       device_init)    \
+    X(I2C1,         "i2c1",         i2c_device,     i2c1,           device_init)    \
+    X(I2S2,         "i2s2",         i2s_device,     i2s2,           device_init)    \
+    X(I2S3,         "i2s3",         i2s_device,     i2s3,           device_init)    \
+    X(SPI1,         "spi1",         spi_device,     spi1,           device_init)    \
+    X(SPI2_SLAVE,   "spi2_slave",   spi_device,     spi2_slave,     device_init)    \
+    X(SPI_NOR1,     "spi_nor1",     spi_nor_device, spi_nor1,       spi_nor_init)
+
+// For devices with nothing to initialize
+#define DEVICE_NO_INIT(device_)     E_SUCCESS
+
+#define DEVICE_ID_ENUM(id_, name_, type_, object_, init_)   DEVICE_ID_##id_,
+
+enum device_id {
+    STM32F4XX_DEVICES(DEVICE_ID_ENUM)
+    DEVICE_COUNT
+};
+
+#undef DEVICE_ID_ENUM
+
+enum device_class {
+    DEVICE_CLASS_CPU,
+    DEVICE_CLASS_USART,
+    DEVICE_CLASS_GPIO,
+    DEVICE_CLASS_I2C,
+    DEVICE_CLASS_I2S,
+    DEVICE_CLASS_SPI,
+    DEVICE_CLASS_SPI_NOR,
+};
+
+// Capabilities of a device
+#define DEVICE_CAP_DMA          (1UL << 0)  // Transfers run on DMA
+#define DEVICE_CAP_IRQ          (1UL << 1)  // Transfers are interrupt driven
+#define DEVICE_CAP_FULL_DUPLEX  (1UL << 2)  // Sends and receives at the same time
+#define DEVICE_CAP_CRC          (1UL << 3)  // Hardware CRC of transfers
+#define DEVICE_CAP_SLAVE        (1UL << 4)  // Clocked by the other end of the bus
+
+/**
+ * @brief What a device is, without initializing it. Use device_get_by_id or device_open with id
+ * to get the device itself
+ */
+struct device_descriptor {
+    enum device_id      id;
+    const char          *name;
+    enum device_class   class;
+    uint32_t            instance;       // Peripheral number, e.g. 2 for USART2
+    uint32_t            caps;           // DEVICE_CAP_x
+    uint32_t            max_speed_hz;   // Fastest bus clock reachable with the clock tree of hw_init()
+};
+
+/**
+ * @brief FNV-1a hash of a device name. With a literal name the compiler folds it to a constant,
+ * so lookups with device_get_by_hash() do no string work at run time
+ *
+ * @param name device name
+ * @return uint32_t hash
+ */
+static inline uint32_t device_hash(const char *name)
+{
+    uint32_t hash = 2166136261UL;
+
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Gets a device by its ID. This is only a lookup: the device is neither initialized nor
+ * clocked by it. Open it with device_open before use and close it with device_close when done
+ *
+ * @param id DEVICE_ID_x
+ * @return const void* the device or NULL if id is out of range
+ */
+const void *device_get_by_id(enum device_id id);
+
+/**
+ * @brief Gets a device by the hash of its name, like device_get_by_id
+ *
+ * @param hash device_hash() of the name
+ * @return const void* the device or NULL if no name has this hash
+ */
+const void *device_get_by_hash(uint32_t hash);
+
+/**
+ * @brief Takes a reference to a device. The first open ever initializes it, later ones turn its
+ * peripheral clock back on if the last close gated it. Devices built on another one (a flash on
+ * a SPI bus) open it too
+ *
+ * Devices that are different modes of one peripheral (i2s2 and spi2_slave) exclude each other.
+ * One of them can only be opened once the other is closed and its clock gated. It is then
+ * initialized again, and so is the other one when it is next opened.
+ *
+ * @param id DEVICE_ID_x
+ * @param device receives the device, may be NULL
+ * @return int32_t E_SUCCESS, E_INVALID_PARAMETER, E_DEVICE_BUSY if its peripheral is used by
+ * another device or the error of its initialization
+ */
+int32_t device_open(enum device_id id, const void ** const device);
+
+/**
+ * @brief Drops a reference taken by device_open. The peripheral clock is gated when no device
+ * using it is open anymore. The device must be idle: no transfer or stream may be running
+ *
+ * @param id DEVICE_ID_x
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER if the device is not open
+ */
+int32_t device_close(enum device_id id);
+
+/**
+ * @brief Describes a device
+ *
+ * @param id DEVICE_ID_x
+ * @return const struct device_descriptor* the descriptor or NULL if id is out of range
+ */
+const struct device_descriptor *device_describe(enum device_id id);
+
+/**
+ * @brief Walks the descriptors of every device, in ID order
+ *
+ * @param prev descriptor returned by the previous call, NULL to get the first one
+ * @return const struct device_descriptor* next descriptor or NULL after the last one
+ */
+const struct device_descriptor *device_next(const struct device_descriptor *prev);
+
+/**
+ * @brief Walks the descriptors of the devices of one class, in ID order
+ *
+ * @param class the class
+ * @param prev descriptor returned by the previous call, NULL to get the first one
+ * @return const struct device_descriptor* next descriptor or NULL after the last one
+ */
+const struct device_descriptor *device_next_of_class(enum device_class class,
+    const struct device_descriptor *prev);
+
+#endif // INCLUDE_STM32F4XX_DEVICE_H_
@@ -0,0 +1,153 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_DMA_H_
+#define INCLUDE_STM32F4XX_DMA_H_
+
+#include <stdint.h>
+
+#include "include/stm32f4xx/errors.h"
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_dma.h"
+
+/**
+ * @brief Stream interrupt flags, normalized to the layout of stream 0 in LISR
+ */
+#define DMA_FLAG_FE     (1UL << 0)  // FIFO error
+#define DMA_FLAG_DME    (1UL << 2)  // Direct mode error
+#define DMA_FLAG_TE     (1UL << 3)  // Transfer error
+#define DMA_FLAG_HT     (1UL << 4)  // Half transfer
+#define DMA_FLAG_TC     (1UL << 5)  // Transfer complete
+#define DMA_FLAG_ALL    (DMA_FLAG_FE | DMA_FLAG_DME | DMA_FLAG_TE | DMA_FLAG_HT | DMA_FLAG_TC)
+#define DMA_FLAG_ERRORS (DMA_FLAG_FE | DMA_FLAG_DME | DMA_FLAG_TE)
+
+// Polls of dma_stop_stream() for callers that have no timeout of their own. A stream is released
+// once the current data beat ends, well within this
+#define DMA_STOP_TIMEOUT    1000
+
+// NVIC priority of DMA interrupts. Must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define DMA_IRQ_PRIORITY    5
+
+/**
+ * @brief Called from the stream interrupt with the flags that were raised, already cleared
+ */
+typedef void (*dma_handler)(void *arg, uint32_t flags);
+
+/**
+ * @brief Describes one DMA stream/channel pair tied to a peripheral request
+ */
+struct dma_stream {
+    DMA_TypeDef *dma;
+    uint32_t    stream;     // LL_DMA_STREAM_x
+    uint32_t    channel;    // LL_DMA_CHANNEL_x
+    IRQn_Type   irqn;
+};
+
+static inline uint32_t dma_flag_shift(uint32_t stream)
+{
+    static const uint8_t shift[4] = {0, 6, 16, 22};
+    return shift[stream & 0x03];
+}
+
+/**
+ * @brief Reads the interrupt flags of a stream
+ *
+ * @param dma DMA1 or DMA2
+ * @param stream LL_DMA_STREAM_x
+ * @return uint32_t combination of DMA_FLAG_x
+ */
+static inline uint32_t dma_get_flags(DMA_TypeDef *dma, uint32_t stream)
+{
+    uint32_t isr = (stream < LL_DMA_STREAM_4) ? dma->LISR : dma->HISR;
+    return (isr >> dma_flag_shift(stream)) & DMA_FLAG_ALL;
+}
+
+/**
+ * @brief Clears the interrupt flags of a stream
+ *
+ * @param dma DMA1 or DMA2
+ * @param stream LL_DMA_STREAM_x
+ * @param flags combination of DMA_FLAG_x
+ */
+static inline void dma_clear_flags(DMA_TypeDef *dma, uint32_t stream, uint32_t flags)
+{
+    uint32_t mask = (flags & DMA_FLAG_ALL) << dma_flag_shift(stream);
+    if (stream < LL_DMA_STREAM_4)   dma->LIFCR = mask;
+    else                            dma->HIFCR = mask;
+}
+
+/**
+ * @brief Disables a stream and waits until the hardware releases it
+ *
+ * @param dma DMA1 or DMA2
+ * @param stream LL_DMA_STREAM_x
+ * @param timeout in busy-wait iterations
+ * @return int32_t E_SUCCESS or E_TIMEOUT if the stream is still enabled. Its flags are left as they are
+ */
+static inline int32_t dma_stop_stream(DMA_TypeDef *dma, uint32_t stream, uint32_t timeout)
+{
+    uint32_t t = timeout;
+
+    LL_DMA_DisableStream(dma, stream);
+    while (LL_DMA_IsEnabledStream(dma, stream)) {
+        if (t-- == 0) return E_TIMEOUT;
+    }
+    dma_clear_flags(dma, stream, DMA_FLAG_ALL);
+
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Routes the interrupt of a stream to handler and enables it in the NVIC
+ *
+ * Setting the handler also claims the stream until dma_clear_handler() is called, so it must be
+ * done before the stream is touched.
+ *
+ * @param stream the stream
+ * @param handler function called from the interrupt
+ * @param arg passed to handler
+ * @return int32_t E_SUCCESS, E_INVALID_PARAMETER or E_DEVICE_BUSY if the stream has a handler
+ */
+int32_t dma_set_handler(const struct dma_stream * const stream, dma_handler handler, void *arg);
+
+/**
+ * @brief Disables the interrupt of a stream and forgets its handler
+ *
+ * @param stream the stream
+ */
+void dma_clear_handler(const struct dma_stream * const stream);
+
+/**
+ * @brief Kind of peripheral a DMA2 stream accesses
+ *
+ * STM32F40x errata: DMA2 may corrupt data when it serves requests for AHB peripherals (e.g. GPIO)
+ * and for APB2 peripherals at the same time. Users of DMA2 claim the kind they access so only one
+ * kind is in use at any time.
+ */
+enum dma2_port {
+    DMA2_PORT_APB2, // SPI1, USART1/6, ADC...
+    DMA2_PORT_AHB,  // GPIO, as used by waveform and capture
+};
+
+/**
+ * @brief Claims DMA2 for a transfer to or from port. Can be called from interrupt context
+ *
+ * @param port the kind of peripheral that will be accessed
+ * @return int32_t E_SUCCESS or E_DEVICE_BUSY if the other kind is in use
+ */
+int32_t dma2_port_acquire(enum dma2_port port);
+
+/**
+ * @brief Releases a claim taken with dma2_port_acquire(). Can be called from interrupt context
+ *
+ * @param port the kind of peripheral given to dma2_port_acquire()
+ */
+void dma2_port_release(enum dma2_port port);
+
+#endif // INCLUDE_STM32F4XX_DMA_H_
@@ -0,0 +1,73 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_DRIFT_H_
+#define INCLUDE_STM32F4XX_DRIFT_H_
+
+#include <stdint.h>
+
+#include "include/stm32f4xx/resampler.h"
+
+// Default loop gains, see struct drift
+#define DRIFT_DEFAULT_KP        64
+#define DRIFT_DEFAULT_KI_SHIFT  10
+
+// Largest correction applied by default, in parts per million
+#define DRIFT_DEFAULT_MAX_PPM   1000
+
+/**
+ * @brief Keeps a stream from a producer with its own clock (e.g. a host over USART or USB) in
+ * step with the I2S clock
+ *
+ * The producer pushes its frames through a resampler into a ring drained by the I2S, typically a
+ * mixer source. If the producer clock is faster the ring slowly fills up, if it is slower it
+ * drains. Once per block the fill level is given to drift_update(), which runs a PI controller
+ * that nudges the resampler step so the fill stays around the target.
+ */
+struct drift {
+    struct resampler    *rs;
+    uint32_t            nominal_step;   // Q8.24
+    int32_t             max_delta;      // Q8.24
+    int32_t             target;         // Frames, Q8
+    int32_t             level;          // Low-passed fill level, frames, Q8
+    int32_t             integral;
+    int32_t             kp;             // Step change (Q24) per 1/256 frame of error
+    uint32_t            ki_shift;       // Integral term is integral >> ki_shift
+    int32_t             delta;          // Last correction, Q8.24
+};
+
+/**
+ * @brief Starts tracking with the current step of rs as the nominal ratio
+ *
+ * @param drift tracker
+ * @param rs resampler whose step is adjusted
+ * @param target_fill fill level to hold, in frames. Usually half of the ring
+ * @param max_ppm largest correction allowed, up to 10000
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t drift_init(struct drift * const drift, struct resampler * const rs, uint32_t target_fill,
+    uint32_t max_ppm);
+
+/**
+ * @brief Feeds one fill level measurement and updates the resampler step. Call at a steady pace,
+ * e.g. after each block was resampled
+ *
+ * @param drift tracker
+ * @param fill frames waiting in the ring right now
+ */
+void drift_update(struct drift * const drift, uint32_t fill);
+
+/**
+ * @brief Correction currently applied
+ *
+ * @param drift tracker
+ * @return int32_t correction in parts per million. Positive means the producer is faster
+ */
+int32_t drift_ppm(const struct drift * const drift);
+
+#endif // INCLUDE_STM32F4XX_DRIFT_H_
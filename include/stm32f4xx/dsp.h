@@ -0,0 +1,157 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_DSP_H_
+#define INCLUDE_STM32F4XX_DSP_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Fixed-point block processing for the I2S path
+ *
+ * Samples are Q15 (int16_t). Functions that work on a single channel take a stride, so
+ * interleaved stereo is processed with stride 2 starting at buf (left) or buf + 1 (right).
+ * On Cortex-M4 the Armv7E-M SIMD instructions are used. Everywhere else a portable C
+ * implementation gives bit-exact results.
+ */
+
+/**
+ * @brief Biquad coefficients in Q14 (range [-2, 2)). Feedback coefficients are stored negated:
+ * y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] + a1*y[n-1] + a2*y[n-2]
+ */
+struct dsp_biquad_coeffs {
+    int16_t b0;
+    int16_t b1;
+    int16_t b2;
+    int16_t a1;
+    int16_t a2;
+};
+
+struct dsp_biquad_state {
+    int16_t x1;
+    int16_t x2;
+    int16_t y1;
+    int16_t y2;
+};
+
+/**
+ * @brief Cascade of biquads (direct form I). state has one entry per stage and must be zeroed
+ * before first use
+ */
+struct dsp_biquad {
+    const struct dsp_biquad_coeffs  *coeffs;
+    struct dsp_biquad_state         *state;
+    uint32_t                        stages;
+};
+
+/**
+ * @brief FIR filter. taps are Q15 in reverse order (h[num_taps - 1] first) and num_taps must be
+ * even; pad with a zero tap if needed. history holds 2 * num_taps samples and must be zeroed
+ * before first use
+ */
+struct dsp_fir {
+    const int16_t   *taps;
+    uint32_t        num_taps;
+    int16_t         *history;
+    uint32_t        pos;
+};
+
+struct dsp_meter {
+    int16_t     peak;   // Largest absolute sample
+    int16_t     rms;
+};
+
+/**
+ * @brief dst = saturate(dst + src)
+ *
+ * @param dst accumulator
+ * @param src samples to add
+ * @param samples number of samples
+ */
+void dsp_mix_q15(int16_t *dst, const int16_t *src, uint32_t samples);
+
+/**
+ * @brief dst = saturate(dst + src * gain)
+ *
+ * @param dst accumulator
+ * @param src samples to add
+ * @param samples number of samples
+ * @param gain Q15
+ */
+void dsp_mix_gain_q15(int16_t *dst, const int16_t *src, uint32_t samples, int16_t gain);
+
+/**
+ * @brief buf = buf * gain, in place
+ *
+ * @param buf samples
+ * @param samples number of samples
+ * @param gain Q15
+ */
+void dsp_gain_q15(int16_t *buf, uint32_t samples, int16_t gain);
+
+/**
+ * @brief Runs one channel through a biquad cascade, in place
+ *
+ * @param bq the cascade
+ * @param buf first sample of the channel
+ * @param frames number of samples of the channel
+ * @param stride distance between two samples of the channel
+ */
+void dsp_biquad_q15(const struct dsp_biquad * const bq, int16_t *buf, uint32_t frames, uint32_t stride);
+
+/**
+ * @brief Runs one channel through a FIR filter. in and out may be the same buffer
+ *
+ * @param fir the filter
+ * @param in first input sample of the channel
+ * @param out first output sample of the channel
+ * @param frames number of samples of the channel
+ * @param stride distance between two samples of the channel, in and out
+ */
+void dsp_fir_q15(struct dsp_fir * const fir, const int16_t *in, int16_t *out, uint32_t frames, uint32_t stride);
+
+/**
+ * @brief Saturated Q15 dot product of two vectors
+ *
+ * @param a first vector
+ * @param b second vector
+ * @param length number of elements. Must be even
+ * @return int16_t saturate(sum(a[i] * b[i]) >> 15)
+ */
+int16_t dsp_dot_q15(const int16_t *a, const int16_t *b, uint32_t length);
+
+/**
+ * @brief Widens Q15 samples to the 32-bit I2S layout (two uint16_t per sample, most significant
+ * half first) used by I2S_FORMAT_24BIT and I2S_FORMAT_32BIT
+ *
+ * @param in Q15 samples
+ * @param out 2 * samples uint16_t
+ * @param samples number of samples
+ */
+void dsp_q15_to_i2s32(const int16_t *in, uint16_t *out, uint32_t samples);
+
+/**
+ * @brief Narrows samples in the 32-bit I2S layout to Q15, truncating
+ *
+ * @param in 2 * samples uint16_t
+ * @param out Q15 samples
+ * @param samples number of samples
+ */
+void dsp_i2s32_to_q15(const uint16_t *in, int16_t *out, uint32_t samples);
+
+/**
+ * @brief Peak and RMS level of one channel
+ *
+ * @param buf first sample of the channel
+ * @param frames number of samples of the channel
+ * @param stride distance between two samples of the channel
+ * @param meter where to store the levels
+ */
+void dsp_meter_q15(const int16_t *buf, uint32_t frames, uint32_t stride, struct dsp_meter * const meter);
+
+#endif // INCLUDE_STM32F4XX_DSP_H_
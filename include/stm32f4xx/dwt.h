@@ -0,0 +1,37 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_DWT_H_
+#define INCLUDE_STM32F4XX_DWT_H_
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+
+/**
+ * @brief Starts the DWT cycle counter if it is not running yet
+ */
+static inline void dwt_init(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+/**
+ * @brief Current value of the cycle counter. Wraps every 2^32 cycles (~25 s at 168 MHz), so
+ * differences between two readings are always correct below that
+ */
+static inline uint32_t dwt_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+#endif // INCLUDE_STM32F4XX_DWT_H_
@@ -0,0 +1,32 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_ERRORS_H_
+#define INCLUDE_STM32F4XX_ERRORS_H_
+
+#include "include/errors.h"
+
+/**
+ * @brief Error codes that only exist for this architecture. They live far from
+ * the generic codes in include/errors.h so both sets never collide.
+ */
+#define E_ARCH_ERROR_BASE   (-0x100)
+
+#ifndef E_CRC_MISMATCH
+#define E_CRC_MISMATCH      (E_ARCH_ERROR_BASE - 1)
+#endif
+
+#ifndef E_DMA_ERROR
+#define E_DMA_ERROR         (E_ARCH_ERROR_BASE - 2)
+#endif
+
+#ifndef E_DEVICE_BUSY
+#define E_DEVICE_BUSY       (E_ARCH_ERROR_BASE - 3)
+#endif
+
+#endif // INCLUDE_STM32F4XX_ERRORS_H_
@@ -0,0 +1,87 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_EXTI_H_
+#define INCLUDE_STM32F4XX_EXTI_H_
+
+#include <stdint.h>
+
+#include "include/stm32f4xx/errors.h"
+
+#include "stm32f4xx.h"
+
+// Events that may wait to be read. Must be a power of two
+#define EXTI_EVENT_QUEUE_LEN    32
+
+// NVIC priority of the EXTI lines and of the debounce timer. All of them share it so they never
+// preempt each other while pushing events
+#define EXTI_IRQ_PRIORITY       6
+
+enum exti_edge {
+    EXTI_EDGE_RISING,
+    EXTI_EDGE_FALLING,
+    EXTI_EDGE_BOTH,
+};
+
+/**
+ * @brief A GPIO input that raises events. The EXTI line is the pin number, so only one port can
+ * use each pin number at a time
+ */
+struct exti_input {
+    GPIO_TypeDef    *port;
+    uint32_t        pin;                // 0 to 15
+    uint32_t        ahb1_grp1_periph;
+    uint32_t        pull;               // LL_GPIO_PULL_x
+    enum exti_edge  edge;
+    uint32_t        debounce_ms;        // 0 reports every edge right away
+};
+
+struct exti_event {
+    uint32_t    timestamp;  // timebase_us() when the edge happened
+    uint8_t     line;       // Pin number
+    uint8_t     level;      // Pin level once stable
+};
+
+/**
+ * @brief Configures the pin and its EXTI line and starts reporting events
+ *
+ * With debounce the line is masked on the first edge and the pin is sampled between debounce_ms
+ * and debounce_ms + 1 later, as the debounce timer ticks every ms independently of the edge. An
+ * event, stamped with the time of the first edge, is only reported if the pin then still is at
+ * the level the edge leads to.
+ *
+ * @param input the input
+ * @return int32_t E_SUCCESS, E_DEVICE_BUSY if the line is taken or error code
+ */
+int32_t exti_input_enable(const struct exti_input * const input);
+
+/**
+ * @brief Stops reporting events of an input
+ *
+ * @param input the input
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t exti_input_disable(const struct exti_input * const input);
+
+/**
+ * @brief Blocks until an event of any input is available
+ *
+ * @param event where to store it
+ * @param timeout in ticks
+ * @return int32_t E_SUCCESS, E_TIMEOUT or E_NOT_INITIALIZED
+ */
+int32_t exti_wait_event(struct exti_event * const event, uint32_t timeout);
+
+/**
+ * @brief Events dropped because the queue was full
+ *
+ * @return uint32_t dropped events
+ */
+uint32_t exti_overflows(void);
+
+#endif // INCLUDE_STM32F4XX_EXTI_H_
@@ -0,0 +1,105 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_GPIO_H_
+#define INCLUDE_STM32F4XX_GPIO_H_
+
+#include <stdint.h>
+
+#include "include/device/gpio.h"
+#include "include/stm32f4xx/errors.h"
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_gpio.h"
+#include "stm32f4xx_ll_bus.h"
+
+/**
+ * @brief A run of adjacent pins of one port handled as a single value, e.g. a parallel bus.
+ * Bit 0 of the value is pin shift of the port
+ */
+struct gpio_group {
+    GPIO_TypeDef    *port;
+    uint32_t        mask;               // Pins of the group, as in LL_GPIO_PIN_x
+    uint32_t        shift;
+    uint32_t        ahb1_grp1_periph;
+    uint32_t        mode;               // LL_GPIO_MODE_OUTPUT or LL_GPIO_MODE_INPUT
+};
+
+/**
+ * @brief Initializer of a group of width pins starting at pin first of GPIO port (A to I)
+ */
+#define GPIO_GROUP(port_, first_, width_, mode_) {                         \
+    .port = GPIO##port_,                                                    \
+    .mask = ((1UL << (width_)) - 1) << (first_),                            \
+    .shift = (first_),                                                      \
+    .ahb1_grp1_periph = LL_AHB1_GRP1_PERIPH_GPIO##port_,                    \
+    .mode = (mode_)                                                         \
+}
+
+/**
+ * @brief Declares a group, e.g. GPIO_GROUP_DECLARE(data_bus, E, 0, 8, LL_GPIO_MODE_OUTPUT)
+ */
+#define GPIO_GROUP_DECLARE(name_, port_, first_, width_, mode_) \
+    const struct gpio_group name_ = GPIO_GROUP(port_, first_, width_, mode_)
+
+/**
+ * @brief Enables the port clock and configures every pin of the group (push-pull, very high
+ * speed, no pull). Outputs start low
+ *
+ * @param group the group
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t stm32f4xx_gpio_group_init(const struct gpio_group * const group);
+
+/**
+ * @brief Sets and clears pins of a port in a single BSRR store. A pin in both masks is set
+ *
+ * @param port GPIO port
+ * @param set pins to drive high
+ * @param reset pins to drive low
+ */
+static inline void gpio_port_write(GPIO_TypeDef *port, uint32_t set, uint32_t reset)
+{
+    port->BSRR = ((reset & 0xffff) << 16) | (set & 0xffff);
+}
+
+/**
+ * @brief Reads every input of a port at once
+ *
+ * @param port GPIO port
+ * @return uint32_t IDR
+ */
+static inline uint32_t gpio_port_read(GPIO_TypeDef *port)
+{
+    return port->IDR;
+}
+
+/**
+ * @brief Drives the whole group to value in a single BSRR store, so all pins change together
+ *
+ * @param group the group
+ * @param value new value, bit 0 being the first pin
+ */
+static inline void gpio_group_write(const struct gpio_group * const group, uint32_t value)
+{
+    uint32_t bits = value << group->shift;
+    group->port->BSRR = ((~bits & group->mask) << 16) | (bits & group->mask);
+}
+
+/**
+ * @brief Reads the group from IDR
+ *
+ * @param group the group
+ * @return uint32_t value, bit 0 being the first pin
+ */
+static inline uint32_t gpio_group_read(const struct gpio_group * const group)
+{
+    return (group->port->IDR & group->mask) >> group->shift;
+}
+
+#endif // INCLUDE_STM32F4XX_GPIO_H_
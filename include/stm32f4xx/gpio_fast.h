@@ -0,0 +1,75 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_GPIO_FAST_H_
+#define INCLUDE_STM32F4XX_GPIO_FAST_H_
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+
+/**
+ * @brief Fast path for pins known at compile time
+ *
+ * Port and pin are constants, so gpio_fast_<name>_write() compiles to a single store to BSRR and
+ * gpio_fast_<name>_read() to a single load from IDR, with no indirect call and no descriptor to
+ * dereference. Pins must have been configured before, e.g. by their gpio_device init.
+ *
+ * The pin table is an X-macro of X(name, port letter, pin number). Define GPIO_FAST_PINS before
+ * including this header to use another table.
+ */
+
+// Board LED. led_gpio in gpio_impl.c is built from it too
+#define GPIO_FAST_LED_PORT  F
+#define GPIO_FAST_LED_PIN   6
+
+#ifndef GPIO_FAST_PINS
+#define GPIO_FAST_PINS(X)   \
+    X(led, GPIO_FAST_LED_PORT, GPIO_FAST_LED_PIN)
+#endif
+
+// Port letters may come from other macros, so they are expanded before being pasted
+#define GPIO_FAST_CONCAT(a_, b_)        a_##b_
+#define GPIO_FAST_PASTE(a_, b_)         GPIO_FAST_CONCAT(a_, b_)
+#define GPIO_FAST_PORT(port_)           GPIO_FAST_PASTE(GPIO, port_)
+#define GPIO_FAST_BIT(pin_)             (1UL << (pin_))
+
+// Single store to BSRR. value_ is evaluated once
+#define GPIO_FAST_WRITE(port_, pin_, value_) \
+    (GPIO_FAST_PORT(port_)->BSRR = (value_) ? GPIO_FAST_BIT(pin_) : (GPIO_FAST_BIT(pin_) << 16))
+
+#define GPIO_FAST_HIGH(port_, pin_)     (GPIO_FAST_PORT(port_)->BSRR = GPIO_FAST_BIT(pin_))
+#define GPIO_FAST_LOW(port_, pin_)      (GPIO_FAST_PORT(port_)->BSRR = GPIO_FAST_BIT(pin_) << 16)
+#define GPIO_FAST_READ(port_, pin_)     ((GPIO_FAST_PORT(port_)->IDR >> (pin_)) & 0x01)
+
+#define GPIO_FAST_DEFINE(name_, port_, pin_)                                \
+    static inline void gpio_fast_##name_##_write(int32_t value)             \
+    {                                                                       \
+        GPIO_FAST_WRITE(port_, pin_, value);                                \
+    }                                                                       \
+    static inline void gpio_fast_##name_##_high(void)                       \
+    {                                                                       \
+        GPIO_FAST_HIGH(port_, pin_);                                        \
+    }                                                                       \
+    static inline void gpio_fast_##name_##_low(void)                        \
+    {                                                                       \
+        GPIO_FAST_LOW(port_, pin_);                                         \
+    }                                                                       \
+    static inline void gpio_fast_##name_##_toggle(void)                     \
+    {                                                                       \
+        /* Through BSRR so other pins of the port are never rewritten */    \
+        GPIO_FAST_WRITE(port_, pin_, !(GPIO_FAST_PORT(port_)->ODR & GPIO_FAST_BIT(pin_))); \
+    }                                                                       \
+    static inline int32_t gpio_fast_##name_##_read(void)                    \
+    {                                                                       \
+        return GPIO_FAST_READ(port_, pin_);                                 \
+    }
+
+GPIO_FAST_PINS(GPIO_FAST_DEFINE)
+
+#endif // INCLUDE_STM32F4XX_GPIO_FAST_H_
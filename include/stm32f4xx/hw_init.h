@@ -0,0 +1,60 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_HW_INIT_H_
+#define INCLUDE_STM32F4XX_HW_INIT_H_
+
+#include <stdint.h>
+
+#include "include/hw_init.h"
+
+// Sample rate PLLI2S is tuned for at boot
+#define HW_INIT_I2S_DEFAULT_SAMPLE_RATE 48000
+
+// Largest sample rate error accepted by hw_init_i2s_clock, in parts per million (0.1%). Every
+// rate from 8 kHz to 96 kHz fits. With the master clock output 176.4 kHz (0.2%) and 192 kHz
+// (2.3%) do not, without it every rate up to 192 kHz does
+#define HW_INIT_I2S_MAX_ERROR_PPM       1000
+
+/**
+ * @brief Picks PLLI2S N and R giving the smallest error for sample_rate and programs them
+ *
+ * PLLI2S is shared by every I2S instance, so all of them must be stopped and will run from the
+ * new clock afterwards.
+ *
+ * @param sample_rate in Hz
+ * @param mclk_output 1 if the master clock output is enabled (Fs = I2SCLK / (256 * prescaler))
+ * @param channel_bits 16 or 32 (Fs = I2SCLK / (2 * channel_bits * prescaler)) without master clock
+ * @param prescaler receives the I2S prescaler (2 * I2SDIV + ODD) to program in the I2S
+ * @return int32_t E_SUCCESS, E_INVALID_PARAMETER if the rate can't be reached within
+ * HW_INIT_I2S_MAX_ERROR_PPM or E_TIMEOUT
+ */
+int32_t hw_init_i2s_clock(uint32_t sample_rate, uint32_t mclk_output, uint32_t channel_bits,
+    uint32_t * const prescaler);
+
+/**
+ * @brief How one step of hw_init_late_config went. Times are DWT cycles counted from the start of
+ * hw_init_late_config
+ */
+struct hw_init_boot_record {
+    const char  *name;
+    int32_t     status;     // E_SUCCESS, error of the step or E_NOT_INITIALIZED if a dependency failed
+    uint32_t    start;      // When the step was started
+    uint32_t    init;       // Cycles spent in its init function
+    uint32_t    ready;      // When it was ready to be used by the steps depending on it
+};
+
+/**
+ * @brief Per step boot times of the last hw_init_late_config, in the order steps were started
+ *
+ * @param records receives the records
+ * @return uint32_t number of records
+ */
+uint32_t hw_init_boot_report(const struct hw_init_boot_record ** const records);
+
+#endif // INCLUDE_STM32F4XX_HW_INIT_H_
@@ -0,0 +1,234 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_I2S_H_
+#define INCLUDE_STM32F4XX_I2S_H_
+
+#include <stdint.h>
+
+#include "include/device/i2s.h"
+#include "include/stm32f4xx/errors.h"
+
+enum i2s_format {
+    I2S_FORMAT_16BIT,           // 16-bit data in a 16-bit channel
+    I2S_FORMAT_16BIT_EXTENDED,  // 16-bit data in a 32-bit channel
+    I2S_FORMAT_24BIT,           // 24-bit data in a 32-bit channel
+    I2S_FORMAT_32BIT,           // 32-bit data in a 32-bit channel
+};
+
+enum i2s_standard {
+    I2S_STANDARD_PHILIPS,
+    I2S_STANDARD_MSB,           // Left justified
+    I2S_STANDARD_LSB,           // Right justified
+    I2S_STANDARD_PCM_SHORT,
+    I2S_STANDARD_PCM_LONG,
+};
+
+/**
+ * @brief Runtime configuration of an I2S master
+ *
+ * All I2S instances share PLLI2S, which is retuned to get as close as possible to sample_rate.
+ * An instance starts with the last configuration applied to any instance, so that PLLI2S is left
+ * as it is, or with HW_INIT_I2S_DEFAULT_SAMPLE_RATE, 16-bit Philips and MCK if there is none.
+ */
+struct i2s_config {
+    uint32_t            sample_rate;    // In Hz, from 8000 to 192000
+    enum i2s_format     format;
+    enum i2s_standard   standard;
+    uint32_t            mclk_output;    // 1 to output MCK (256 * sample_rate)
+};
+
+// Callback cycle histogram: bin n counts callbacks of [2^(n + 8), 2^(n + 9)) cycles. The first
+// bin also holds shorter ones and the last bin longer ones
+#define I2S_HISTOGRAM_BINS  16
+#define I2S_HISTOGRAM_SHIFT 8
+
+/**
+ * @brief Stream health counters, updated for stm32f4xx_i2s_stream_start(),
+ * stm32f4xx_i2s_write_block() and stm32f4xx_i2s_duplex_start()
+ */
+struct i2s_stats {
+    uint32_t callbacks;
+    uint32_t underruns;         // Halves the DMA got back to before the callback refilled them
+    uint32_t min_headroom;      // Fewest frames left before the DMA reached a refilled half
+    uint32_t dma_errors;
+    uint32_t max_cycles;        // Longest callback, CPU cycles
+    uint32_t histogram[I2S_HISTOGRAM_BINS];
+};
+
+enum i2s_poll_op {
+    I2S_POLL_UNDERRUNS,         // uint32_t
+    I2S_POLL_MIN_HEADROOM,      // uint32_t, frames. UINT32_MAX until the first callback
+    I2S_POLL_DMA_ERRORS,        // uint32_t
+    I2S_POLL_STATS,             // struct i2s_stats
+};
+
+/**
+ * @brief Called from interrupt context with the half of the stream buffer that was just sent
+ *
+ * The callback must fill block with frames new stereo frames (interleaved left/right samples)
+ * before the DMA gets back to it, i.e. within the time it takes to play frames frames. Samples
+ * are uint16_t for I2S_FORMAT_16BIT and I2S_FORMAT_16BIT_EXTENDED. For I2S_FORMAT_24BIT and
+ * I2S_FORMAT_32BIT each sample takes two uint16_t, most significant half first.
+ */
+typedef void (*i2s_stream_callback)(void *arg, void *block, uint32_t frames);
+
+/**
+ * @brief Called from interrupt context in full-duplex mode with a block just captured
+ *
+ * The callback must write frames output frames to out, which will be played right after the
+ * block being played now. in and out use the layout described for i2s_stream_callback, cover
+ * the same frames of the stream and may be processed in place by copying in to out first.
+ * Latency from capture to playback is therefore half of the buffer plus processing.
+ */
+typedef void (*i2s_process_callback)(void *arg, const void *in, void *out, uint32_t frames);
+
+/**
+ * @brief Starts playing buffer in a loop using circular DMA
+ *
+ * buffer is split in two halves. While one is played the other is handed to callback to be
+ * refilled. Both halves are filled by callback before playback starts. i2s_write_op must not
+ * be used while streaming.
+ *
+ * @param i2s I2S device
+ * @param buffer interleaved stereo buffer
+ * @param frames number of stereo frames in buffer. Must be even and fit 65535 uint16_t
+ * @param callback called for each half that needs new samples
+ * @param arg passed to callback
+ * @return int32_t E_SUCCESS or error code
+ */
+int32_t stm32f4xx_i2s_stream_start(const struct i2s_device * const i2s, void *buffer, uint32_t frames,
+    i2s_stream_callback callback, void *arg);
+
+/**
+ * @brief Stops a stream started with stm32f4xx_i2s_stream_start()
+ *
+ * @param i2s I2S device
+ * @return int32_t E_SUCCESS
+ */
+int32_t stm32f4xx_i2s_stream_stop(const struct i2s_device * const i2s);
+
+/**
+ * @brief Starts full-duplex operation: the I2S master transmits tx_buffer while its I2Sx_ext block
+ * receives into rx_buffer on the same clocks
+ *
+ * Both buffers are circular, split in two halves and walked in lock step by two DMA streams.
+ * Every time a half of rx_buffer is filled, callback turns it into the matching half of
+ * tx_buffer. Playback starts with silence. The ext_SD input is PC2 for i2s2 and PC11 for i2s3.
+ *
+ * @param i2s I2S device
+ * @param tx_buffer playback buffer
+ * @param rx_buffer capture buffer, same size as tx_buffer
+ * @param frames number of stereo frames in each buffer. Must be even and fit 65535 uint16_t
+ * @param callback called for each captured half
+ * @param arg passed to callback
+ * @return int32_t E_SUCCESS, E_DEVICE_BUSY or error code
+ */
+int32_t stm32f4xx_i2s_duplex_start(const struct i2s_device * const i2s, void *tx_buffer, void *rx_buffer,
+    uint32_t frames, i2s_process_callback callback, void *arg);
+
+/**
+ * @brief Stops full-duplex operation started with stm32f4xx_i2s_duplex_start()
+ *
+ * @param i2s I2S device
+ * @return int32_t E_SUCCESS
+ */
+int32_t stm32f4xx_i2s_duplex_stop(const struct i2s_device * const i2s);
+
+/**
+ * @brief Changes sample rate, data format and standard. GPIOs are left untouched
+ *
+ * Since PLLI2S is shared this fails while any I2S instance is streaming. An I2S stopped with
+ * stm32f4xx_i2s_stop() stays stopped.
+ *
+ * @param i2s I2S device
+ * @param config the new configuration
+ * @return int32_t E_SUCCESS, E_DEVICE_BUSY, E_INVALID_PARAMETER if the sample rate can't be
+ * reached or an error code
+ */
+int32_t stm32f4xx_i2s_configure(const struct i2s_device * const i2s, const struct i2s_config * const config);
+
+/**
+ * @brief Copies the current configuration
+ *
+ * @param i2s I2S device
+ * @param config where to store it
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t stm32f4xx_i2s_get_config(const struct i2s_device * const i2s, struct i2s_config * const config);
+
+/**
+ * @brief Stops clocking the bus. Must not be streaming
+ *
+ * @param i2s I2S device
+ * @return int32_t E_SUCCESS or E_DEVICE_BUSY
+ */
+int32_t stm32f4xx_i2s_stop(const struct i2s_device * const i2s);
+
+/**
+ * @brief Restarts an I2S stopped with stm32f4xx_i2s_stop()
+ *
+ * @param i2s I2S device
+ * @return int32_t E_SUCCESS
+ */
+int32_t stm32f4xx_i2s_start(const struct i2s_device * const i2s);
+
+/**
+ * @brief Queues a block of interleaved stereo frames to be played by DMA and returns
+ *
+ * Frames use the layout described for i2s_stream_callback. The block is not copied by this
+ * function: data must stay valid until it was played, i.e. until stm32f4xx_i2s_blocks_done()
+ * has moved past it or stm32f4xx_i2s_flush() returned. The first block starts a stream on an
+ * internal DMA buffer, so stm32f4xx_i2s_stream_start() can't be used at the same time. Silence
+ * is played while no block is queued. stm32f4xx_i2s_stream_stop() stops it and drops pending
+ * blocks.
+ *
+ * @param i2s I2S device
+ * @param data interleaved frames
+ * @param frames number of stereo frames in data
+ * @param timeout in ticks, to wait for room in the queue
+ * @return int32_t frames queued, E_TIMEOUT, E_DEVICE_BUSY or error code
+ */
+int32_t stm32f4xx_i2s_write_block(const struct i2s_device * const i2s, const void *data, uint32_t frames,
+    uint32_t timeout);
+
+/**
+ * @brief Waits until every block queued by stm32f4xx_i2s_write_block() was handed to the DMA
+ *
+ * @param i2s I2S device
+ * @param timeout in ticks
+ * @return int32_t E_SUCCESS or E_TIMEOUT
+ */
+int32_t stm32f4xx_i2s_flush(const struct i2s_device * const i2s, uint32_t timeout);
+
+/**
+ * @brief Number of blocks from stm32f4xx_i2s_write_block() fully consumed since boot. Wraps around
+ *
+ * @param i2s I2S device
+ * @return uint32_t blocks consumed
+ */
+uint32_t stm32f4xx_i2s_blocks_done(const struct i2s_device * const i2s);
+
+/**
+ * @brief Reads stream health counters, in the style of usart_poll_op
+ *
+ * @param i2s I2S device
+ * @param op what to read
+ * @param answer where to store it, of the type given next to each i2s_poll_op
+ * @return int32_t E_SUCCESS, E_INVALID_PARAMETER or E_POLLOP_INVALID
+ */
+int32_t stm32f4xx_i2s_poll(const struct i2s_device * const i2s, enum i2s_poll_op op, void *answer);
+
+/**
+ * @brief Zeroes the stream health counters
+ *
+ * @param i2s I2S device
+ */
+void stm32f4xx_i2s_reset_stats(const struct i2s_device * const i2s);
+
+#endif // INCLUDE_STM32F4XX_I2S_H_
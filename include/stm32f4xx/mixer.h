@@ -0,0 +1,113 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_MIXER_H_
+#define INCLUDE_STM32F4XX_MIXER_H_
+
+#include <stdint.h>
+
+#include "include/device/i2s.h"
+#include "include/stm32f4xx/errors.h"
+
+// Maximum number of sources mixed at the same time
+#define MIXER_MAX_SOURCES   4
+
+// Q15 gain that leaves a source untouched
+#define MIXER_GAIN_UNITY    INT16_MAX
+
+/**
+ * @brief Software mixer that owns the stream buffer of one I2S
+ *
+ * Each source is a single-producer single-consumer ring of interleaved 16-bit stereo frames.
+ * One task writes to it with mixer_source_write() and the I2S half-transfer interrupt reads from
+ * it, so no locks are taken on either side. Every half, all sources are mixed with their own gain
+ * and saturation into the half that was just played. A source starts playing when written and
+ * stops once its ring runs dry. If it runs dry before mixer_source_finish() was called, that
+ * half is counted as an underrun. The missing part is filled with silence.
+ */
+
+/**
+ * @brief Starts streaming to i2s with the mixer as the only producer. i2s must be configured
+ * with I2S_FORMAT_16BIT
+ *
+ * @param i2s I2S device
+ * @param buffer DMA buffer of frames stereo frames
+ * @param frames number of frames in buffer, see stm32f4xx_i2s_stream_start()
+ * @return int32_t E_SUCCESS, E_DEVICE_BUSY or error code
+ */
+int32_t mixer_start(const struct i2s_device * const i2s, int16_t *buffer, uint32_t frames);
+
+/**
+ * @brief Stops the stream started by mixer_start(). Sources stay open
+ *
+ * @return int32_t E_SUCCESS or E_NOT_INITIALIZED
+ */
+int32_t mixer_stop(void);
+
+/**
+ * @brief Opens a source
+ *
+ * @param ring storage for the ring, owned by the mixer until mixer_source_close()
+ * @param frames size of ring in stereo frames. Must be a power of two
+ * @param gain Q15 gain
+ * @return int32_t source id or error code
+ */
+int32_t mixer_source_open(int16_t *ring, uint32_t frames, int16_t gain);
+
+/**
+ * @brief Closes a source. Frames not played yet are dropped
+ *
+ * @param id source id
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t mixer_source_close(int32_t id);
+
+/**
+ * @brief Copies frames into a source without blocking. Only one task may write to each source
+ *
+ * @param id source id
+ * @param data interleaved stereo frames
+ * @param frames number of frames in data
+ * @return int32_t frames copied, which is less than frames if the ring is full, or error code
+ */
+int32_t mixer_source_write(int32_t id, const int16_t *data, uint32_t frames);
+
+/**
+ * @brief Tells the mixer the last frame of a sound was written, so running dry is not an underrun
+ *
+ * @param id source id
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t mixer_source_finish(int32_t id);
+
+/**
+ * @brief Frames that can be written to a source right now
+ *
+ * @param id source id
+ * @return int32_t free frames or error code
+ */
+int32_t mixer_source_space(int32_t id);
+
+/**
+ * @brief Changes the gain of a source. Takes effect on the next half
+ *
+ * @param id source id
+ * @param gain Q15 gain
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t mixer_source_set_gain(int32_t id, int16_t gain);
+
+/**
+ * @brief Number of halves a playing source could not fill before it was finished
+ *
+ * @param id source id
+ * @return int32_t underruns or error code
+ */
+int32_t mixer_source_underruns(int32_t id);
+
+#endif // INCLUDE_STM32F4XX_MIXER_H_
@@ -0,0 +1,88 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_RESAMPLER_H_
+#define INCLUDE_STM32F4XX_RESAMPLER_H_
+
+#include <stdint.h>
+
+#include "include/stm32f4xx/errors.h"
+
+// Longest filter of all quality tiers
+#define RESAMPLER_MAX_TAPS  16
+
+// 1.0 in the Q8.24 format of the resampling step
+#define RESAMPLER_ONE       (1UL << 24)
+
+/**
+ * @brief Quality/CPU tiers. Cost per output frame is proportional to the number of taps
+ */
+enum resampler_quality {
+    RESAMPLER_QUALITY_LOW,      // Linear interpolation, 2 taps x 64 phases
+    RESAMPLER_QUALITY_MEDIUM,   // Kaiser windowed sinc, 8 taps x 128 phases
+    RESAMPLER_QUALITY_HIGH,     // Kaiser windowed sinc, 16 taps x 256 phases
+};
+
+/**
+ * @brief Polyphase resampler for interleaved 16-bit stereo
+ *
+ * The fractional read position advances by step (input frames per output frame, Q8.24) and picks
+ * the nearest filter phase from a coefficient table kept in flash. Filters cut at 90% of the input
+ * Nyquist frequency, which is meant for upsampling sources to the I2S rate. Downsampling works
+ * but is not band limited to the output rate.
+ */
+struct resampler {
+    const int16_t   *table;
+    uint32_t        taps;
+    uint32_t        phase_shift;    // Turns the Q24 fraction into a phase index
+    uint32_t        step;           // Q8.24
+    uint32_t        frac;           // Q8.24, position of the next output after the newest input,
+                                    // plus half a phase so the phase index is rounded
+    uint32_t        pos;            // Next history slot
+    int16_t         history[2][2 * RESAMPLER_MAX_TAPS];
+};
+
+/**
+ * @brief Prepares a resampler
+ *
+ * @param rs resampler
+ * @param in_rate source sample rate in Hz
+ * @param out_rate output sample rate in Hz
+ * @param quality quality tier
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER if the ratio is above 8 or a rate is 0
+ */
+int32_t resampler_init(struct resampler * const rs, uint32_t in_rate, uint32_t out_rate,
+    enum resampler_quality quality);
+
+/**
+ * @brief Converts as many frames as possible from in to out
+ *
+ * Stops when out is full or in is used up. Input left over must be passed again on the next call.
+ *
+ * @param rs resampler
+ * @param in interleaved stereo input
+ * @param in_frames frames available in in
+ * @param consumed receives how many frames of in were used
+ * @param out interleaved stereo output
+ * @param out_frames room in out, in frames
+ * @return int32_t frames written to out
+ */
+int32_t resampler_process(struct resampler * const rs, const int16_t *in, uint32_t in_frames,
+    uint32_t * const consumed, int16_t *out, uint32_t out_frames);
+
+/**
+ * @brief Changes the step while running, e.g. to follow clock drift. Takes effect on the next
+ * output frame without any discontinuity
+ *
+ * @param rs resampler
+ * @param step input frames per output frame, Q8.24
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER if step is 0 or above 8
+ */
+int32_t resampler_set_step(struct resampler * const rs, uint32_t step);
+
+#endif // INCLUDE_STM32F4XX_RESAMPLER_H_
@@ -0,0 +1,50 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_RTC_H_
+#define INCLUDE_STM32F4XX_RTC_H_
+
+#include <stdint.h>
+
+#include "include/stm32f4xx/errors.h"
+
+/**
+ * @brief Calendar on the RTC, clocked by the 32.768 kHz LSE crystal
+ *
+ * Times are Unix timestamps between 2000 and 2099, the range of the RTC calendar. Calendar
+ * registers are read directly (shadow registers bypassed), so a read never waits for the
+ * RTC to synchronize with the APB clock.
+ */
+
+/**
+ * @brief Starts the LSE without waiting for it. Keeps the calendar if the RTC was already running
+ * from LSE on the backup domain
+ */
+void rtc_start(void);
+
+/**
+ * @brief Current time. Lock-free and safe from interrupts once the RTC runs
+ *
+ * @param seconds receives the Unix timestamp
+ * @param micros receives the microseconds within the second, with the RTC resolution of
+ * 1 / 256 s. May be NULL
+ * @return int32_t E_SUCCESS or E_NOT_INITIALIZED if the LSE is not running yet or the
+ * calendar was never set
+ */
+int32_t rtc_get_timestamp(uint32_t * const seconds, uint32_t * const micros);
+
+/**
+ * @brief Sets the calendar
+ *
+ * @param seconds Unix timestamp
+ * @return int32_t E_SUCCESS, E_INVALID_PARAMETER if not between 2000 and 2099,
+ * E_NOT_INITIALIZED if the LSE is not running yet or E_TIMEOUT
+ */
+int32_t rtc_set_timestamp(uint32_t seconds);
+
+#endif // INCLUDE_STM32F4XX_RTC_H_
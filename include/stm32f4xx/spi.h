@@ -0,0 +1,202 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_SPI_H_
+#define INCLUDE_STM32F4XX_SPI_H_
+
+#include <stdint.h>
+
+#include "include/device/spi.h"
+#include "include/stm32f4xx/errors.h"
+
+// Busy-wait iterations for a bus held by the caller to go idle. At most the last frame is still
+// going out: 16 bits at the slowest SCK
+#define SPI_IDLE_TIMEOUT    10000
+
+/**
+ * @brief Per-bus counters. Times are in CPU cycles (see cpu get_clock_in_hz)
+ */
+struct spi_stats {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint64_t bus_cycles;        // Time the bus was held
+    uint64_t wait_cycles;       // Time spent waiting for the bus
+    uint32_t queue_depth;       // Tasks waiting for the bus right now
+    uint32_t queue_depth_max;   // High-water mark of queue_depth
+    uint32_t dma_errors;
+};
+
+enum spi_crc_width {
+    SPI_CRC_8BIT,   // 8-bit frames, 8-bit CRC
+    SPI_CRC_16BIT,  // 16-bit frames, 16-bit CRC. Buffers are handled as uint16_t
+};
+
+/**
+ * @brief Per-transaction configuration of the SPI hardware CRC unit
+ *
+ * The CRC unit computes the CRC over every frame sent and received. The CRC of the
+ * transmitted data is appended by hardware after the last frame and the CRC sent by
+ * the other side is checked against the received data.
+ *
+ * CRC-16/XMODEM used on SD card data blocks is polynomial 0x1021 with SPI_CRC_16BIT.
+ * CRC-7 (SD commands) can be checked as an 8-bit CRC with polynomial 0x12, which
+ * yields the CRC-7 shifted left by one, but the stop bit is not appended by hardware.
+ */
+struct spi_crc_config {
+    uint16_t            polynomial;
+    enum spi_crc_width  width;
+};
+
+/**
+ * @brief Performs a full-duplex transaction using DMA with the hardware CRC unit
+ *
+ * If transaction->write_data is NULL 0xff is clocked out. If transaction->read_data is
+ * NULL the received data is discarded and the received CRC is not checked. When both are
+ * present write_size and read_size must match. Sizes are in bytes.
+ *
+ * @param spi SPI device
+ * @param transaction the transaction to perform
+ * @param crc CRC configuration for this transaction
+ * @param timeout in busy-wait iterations, and in ticks to wait for the bus
+ * @return int32_t E_SUCCESS, E_CRC_MISMATCH if the received CRC is wrong, E_DEVICE_BUSY if DMA2
+ * serves GPIO (see stm32f4xx_spi_dma_start()) or an error code
+ */
+int32_t stm32f4xx_spi_transact_crc(const struct spi_device * const spi, struct spi_transaction * const transaction,
+    const struct spi_crc_config * const crc, uint32_t timeout);
+
+/**
+ * @brief Changes the SCK prescaler of a SPI master. Must not be called while a transfer is running
+ *
+ * @param spi SPI device
+ * @param prescaler one of LL_SPI_BAUDRATEPRESCALER_DIVx
+ * @param timeout in busy-wait iterations for the last frame to go out
+ * @return int32_t E_SUCCESS or E_TIMEOUT if the bus stays busy. The prescaler is then unchanged
+ */
+int32_t stm32f4xx_spi_set_prescaler(const struct spi_device * const spi, uint32_t prescaler, uint32_t timeout);
+
+/**
+ * @brief Reads the SCK prescaler of a SPI master
+ *
+ * @param spi SPI device
+ * @return uint32_t one of LL_SPI_BAUDRATEPRESCALER_DIVx
+ */
+uint32_t stm32f4xx_spi_get_prescaler(const struct spi_device * const spi);
+
+/**
+ * @brief Starts a full-duplex DMA transfer and returns immediately
+ *
+ * Buffers follow the same rules as stm32f4xx_spi_transact_crc() and must stay valid until
+ * stm32f4xx_spi_dma_wait() returns. Sizes are limited to 65535 bytes. The caller must hold the
+ * bus with stm32f4xx_spi_lock().
+ *
+ * SPI1 runs on DMA2, so it is refused while waveform or capture are running (see dma2_port).
+ *
+ * @param spi SPI device
+ * @param transaction the transaction to perform
+ * @return int32_t E_SUCCESS, E_INVALID_PARAMETER or E_DEVICE_BUSY if DMA2 serves GPIO
+ */
+int32_t stm32f4xx_spi_dma_start(const struct spi_device * const spi, struct spi_transaction * const transaction);
+
+/**
+ * @brief Waits for the transfer started by stm32f4xx_spi_dma_start() and releases the DMA streams
+ *
+ * @param spi SPI device
+ * @param timeout in busy-wait iterations
+ * @return int32_t E_SUCCESS, E_TIMEOUT or E_DMA_ERROR
+ */
+int32_t stm32f4xx_spi_dma_wait(const struct spi_device * const spi, uint32_t timeout);
+
+/**
+ * @brief Tells if a transfer started by stm32f4xx_spi_dma_start() is still running
+ *
+ * @param spi SPI device
+ * @return int32_t 1 if running, 0 otherwise
+ */
+int32_t stm32f4xx_spi_dma_busy(const struct spi_device * const spi);
+
+/**
+ * @brief Called from interrupt context every time half of the slave buffer is filled
+ *
+ * block points inside the buffer given to stm32f4xx_spi_slave_start() and is only valid until the
+ * DMA wraps around and starts filling it again, i.e. for the time it takes to receive size bytes.
+ */
+typedef void (*spi_slave_callback)(void *arg, const void *block, uint32_t size);
+
+/**
+ * @brief Starts receiving as a slave into buffer using circular DMA
+ *
+ * buffer is split in two halves. While one is being filled the other one is handed to callback,
+ * so no data is copied by the driver.
+ *
+ * The slave is receive-only and this is its only data path: the write, read and transact
+ * operations of a slave device return E_INVALID_PARAMETER.
+ *
+ * @param spi a slave SPI device (spi2_slave)
+ * @param buffer receive buffer
+ * @param size size of buffer in bytes. Must be even and up to 65534
+ * @param callback called for each filled half
+ * @param arg passed to callback
+ * @return int32_t E_SUCCESS, E_DEVICE_BUSY if the slave or I2S2 full-duplex is running or error code
+ */
+int32_t stm32f4xx_spi_slave_start(const struct spi_device * const spi, void *buffer, uint32_t size,
+    spi_slave_callback callback, void *arg);
+
+/**
+ * @brief Stops a slave started with stm32f4xx_spi_slave_start()
+ *
+ * @param spi a slave SPI device
+ * @return int32_t E_SUCCESS
+ */
+int32_t stm32f4xx_spi_slave_stop(const struct spi_device * const spi);
+
+/**
+ * @brief Number of times data was lost since the slave was started, either by a SPI overrun or
+ * because the callback did not run before a half was overwritten
+ *
+ * @param spi a slave SPI device
+ * @return uint32_t number of overruns
+ */
+uint32_t stm32f4xx_spi_slave_overruns(const struct spi_device * const spi);
+
+/**
+ * @brief Takes exclusive use of the bus. Needed around stm32f4xx_spi_dma_start() and for
+ * sequences that must not be interleaved with other users, e.g. while a chip select is asserted
+ *
+ * @param spi SPI device
+ * @param timeout in ticks
+ * @return int32_t E_SUCCESS, E_TIMEOUT or E_NOT_INITIALIZED
+ */
+int32_t stm32f4xx_spi_lock(const struct spi_device * const spi, uint32_t timeout);
+
+/**
+ * @brief Releases the bus taken with stm32f4xx_spi_lock()
+ *
+ * @param spi SPI device
+ */
+void stm32f4xx_spi_unlock(const struct spi_device * const spi);
+
+/**
+ * @brief Copies the bus counters
+ *
+ * @param spi SPI device
+ * @param stats where to store them
+ * @return int32_t E_SUCCESS or E_INVALID_PARAMETER
+ */
+int32_t stm32f4xx_spi_get_stats(const struct spi_device * const spi, struct spi_stats * const stats);
+
+/**
+ * @brief Zeroes the bus counters. Waits for the bus to be free, so it must not be called while
+ * holding it with stm32f4xx_spi_lock()
+ *
+ * @param spi SPI device
+ * @param timeout in ticks, to wait for the bus
+ * @return int32_t E_SUCCESS or E_TIMEOUT. The counters are then left as they are
+ */
+int32_t stm32f4xx_spi_reset_stats(const struct spi_device * const spi, uint32_t timeout);
+
+#endif // INCLUDE_STM32F4XX_SPI_H_
@@ -0,0 +1,147 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_SPI_NOR_H_
+#define INCLUDE_STM32F4XX_SPI_NOR_H_
+
+#include <stdint.h>
+
+#include "include/device/spi.h"
+#include "include/stm32f4xx/errors.h"
+
+#define SPI_NOR_PAGE_SIZE       256
+#define SPI_NOR_READAHEAD_SIZE  512
+
+enum spi_nor_erase {
+    SPI_NOR_ERASE_4K,
+    SPI_NOR_ERASE_64K,
+    SPI_NOR_ERASE_CHIP
+};
+
+struct spi_nor_device {
+    const struct spi_device *spi;
+    const void *priv;
+};
+
+/**
+ * @brief Initializes the chip select line and wakes the flash up. SPI must already be initialized
+ *
+ * @param nor NOR flash device
+ * @return int32_t E_SUCCESS or error code
+ */
+int32_t spi_nor_init(const struct spi_nor_device * const nor);
+
+/**
+ * @brief Reads the JEDEC ID (manufacturer, memory type, capacity)
+ *
+ * @param nor NOR flash device
+ * @param id 3 bytes long buffer
+ * @param timeout in busy-wait iterations
+ * @return int32_t E_SUCCESS or error code
+ */
+int32_t spi_nor_read_id(const struct spi_nor_device * const nor, uint8_t id[3], uint32_t timeout);
+
+/**
+ * @brief Random read using fast-read (0x0B) and DMA
+ *
+ * @param nor NOR flash device
+ * @param addr address in flash
+ * @param data where to store data
+ * @param size how many bytes to read
+ * @param timeout in busy-wait iterations
+ * @return int32_t number of bytes read or error code
+ */
+int32_t spi_nor_read(const struct spi_nor_device * const nor, uint32_t addr, void *data, uint32_t size,
+    uint32_t timeout);
+
+/**
+ * @brief Opens a sequential read stream at addr and starts fetching the first block
+ *
+ * Each block is fetched with its own fast-read command, the next one as soon as the previous one
+ * is handed out. The SPI bus is therefore held from here until the end of the flash is reached or
+ * the stream is closed, and other users of the bus wait until then. The bus mutex belongs to the
+ * calling task, so only that task may call spi_nor_stream_next() and spi_nor_stream_close().
+ *
+ * @param nor NOR flash device
+ * @param addr address in flash
+ * @param timeout in busy-wait iterations
+ * @return int32_t E_SUCCESS or error code
+ */
+int32_t spi_nor_stream_open(const struct spi_nor_device * const nor, uint32_t addr, uint32_t timeout);
+
+/**
+ * @brief Returns the next block of the stream and starts fetching the following one. Must be
+ * called by the task that opened the stream
+ *
+ * The block is read in place from the driver's double buffer, much like memory-mapped flash. It
+ * remains valid until the next call to spi_nor_stream_next() or spi_nor_stream_close().
+ *
+ * @param nor NOR flash device
+ * @param data receives a pointer to the block
+ * @param timeout in busy-wait iterations
+ * @return int32_t block size in bytes, 0 at the end of the flash or error code
+ */
+int32_t spi_nor_stream_next(const struct spi_nor_device * const nor, const void **data, uint32_t timeout);
+
+/**
+ * @brief Closes the sequential read stream and releases the SPI bus, if it is still held. Must be
+ * called by the task that opened the stream
+ *
+ * @param nor NOR flash device
+ * @param timeout in busy-wait iterations
+ * @return int32_t E_SUCCESS or error code
+ */
+int32_t spi_nor_stream_close(const struct spi_nor_device * const nor, uint32_t timeout);
+
+/**
+ * @brief Programs data, page by page, using DMA
+ *
+ * The function returns as soon as the last page has been handed to the flash, so its program
+ * time overlaps with whatever the caller does next. data can be reused when this function returns.
+ *
+ * @param nor NOR flash device
+ * @param addr address in flash
+ * @param data data to program
+ * @param size size of data
+ * @param timeout in busy-wait iterations, per page
+ * @return int32_t number of bytes programmed or error code
+ */
+int32_t spi_nor_program(const struct spi_nor_device * const nor, uint32_t addr, const void *data, uint32_t size,
+    uint32_t timeout);
+
+/**
+ * @brief Starts an erase and returns immediately. Use spi_nor_is_busy() or spi_nor_wait_ready()
+ * to know when it ends
+ *
+ * @param nor NOR flash device
+ * @param addr any address inside the block to erase. Ignored on SPI_NOR_ERASE_CHIP
+ * @param type erase granularity
+ * @param timeout in busy-wait iterations, to wait for a previous operation
+ * @return int32_t E_SUCCESS or error code
+ */
+int32_t spi_nor_erase(const struct spi_nor_device * const nor, uint32_t addr, enum spi_nor_erase type,
+    uint32_t timeout);
+
+/**
+ * @brief Tells if the flash is still programming or erasing
+ *
+ * @param nor NOR flash device
+ * @return int32_t 1 if busy, 0 if ready or error code
+ */
+int32_t spi_nor_is_busy(const struct spi_nor_device * const nor);
+
+/**
+ * @brief Waits for the flash to finish programming or erasing
+ *
+ * @param nor NOR flash device
+ * @param timeout in status register polls
+ * @return int32_t E_SUCCESS or E_TIMEOUT
+ */
+int32_t spi_nor_wait_ready(const struct spi_nor_device * const nor, uint32_t timeout);
+
+#endif // INCLUDE_STM32F4XX_SPI_NOR_H_
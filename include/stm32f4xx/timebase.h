@@ -0,0 +1,76 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_TIMEBASE_H_
+#define INCLUDE_STM32F4XX_TIMEBASE_H_
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_bus.h"
+#include "stm32f4xx_ll_tim.h"
+
+// Free-running 32-bit timer used for timestamps
+#define TIMEBASE_TIM    TIM5
+
+// NVIC priority of the overflow interrupt. Highest, so no reader can ever preempt it halfway.
+// It makes no FreeRTOS calls
+#define TIMEBASE_IRQ_PRIORITY   0
+
+// Times TIMEBASE_TIM wrapped around, incremented by its interrupt
+extern volatile uint32_t timebase_overflows;
+
+/**
+ * @brief Starts TIM5 counting microseconds if it is not running yet
+ *
+ * APB1 runs at HCLK / 4, so its timers are clocked at HCLK / 2.
+ */
+static inline void timebase_init(void)
+{
+    if (LL_TIM_IsEnabledCounter(TIMEBASE_TIM)) return;
+
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM5);
+    LL_TIM_SetPrescaler(TIMEBASE_TIM, (SystemCoreClock / 2 / 1000000) - 1);
+    LL_TIM_SetAutoReload(TIMEBASE_TIM, 0xffffffff);
+    LL_TIM_GenerateEvent_UPDATE(TIMEBASE_TIM);
+    LL_TIM_ClearFlag_UPDATE(TIMEBASE_TIM);
+    LL_TIM_EnableIT_UPDATE(TIMEBASE_TIM);
+    NVIC_SetPriority(TIM5_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), TIMEBASE_IRQ_PRIORITY, 0));
+    NVIC_EnableIRQ(TIM5_IRQn);
+    LL_TIM_EnableCounter(TIMEBASE_TIM);
+}
+
+/**
+ * @brief Microseconds since timebase_init(). Wraps every 2^32 us (~71 minutes), so differences
+ * between two readings are always correct below that
+ */
+static inline uint32_t timebase_us(void)
+{
+    return TIMEBASE_TIM->CNT;
+}
+
+/**
+ * @brief Microseconds since timebase_init(), on 64 bits so it never wraps. Lock-free and safe from
+ * any interrupt, including with interrupts disabled
+ */
+static inline uint64_t timebase_us64(void)
+{
+    uint32_t high, low, wrapped;
+
+    do {
+        high = timebase_overflows;
+        low = TIMEBASE_TIM->CNT;
+        // Wrapped, but the interrupt could not run yet because we are masking it. A low count
+        // tells the wrap happened before CNT was read
+        wrapped = LL_TIM_IsActiveFlag_UPDATE(TIMEBASE_TIM) && low < 0x80000000UL;
+    } while (high != timebase_overflows);
+
+    return ((uint64_t)(high + wrapped) << 32) | low;
+}
+
+#endif // INCLUDE_STM32F4XX_TIMEBASE_H_
@@ -0,0 +1,91 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef INCLUDE_STM32F4XX_WAVEFORM_H_
+#define INCLUDE_STM32F4XX_WAVEFORM_H_
+
+#include <stdint.h>
+
+#include "include/stm32f4xx/errors.h"
+
+#include "stm32f4xx.h"
+
+/**
+ * @brief Timer-paced GPIO waveforms
+ *
+ * Every update event of TIM8 makes DMA2 stream 1 (channel 7) copy the next word of a buffer to
+ * the BSRR register of a port, so pins change with timer accuracy and no CPU involvement. Words
+ * are BSRR values: the low half sets pins, the high half resets them and a zero word changes
+ * nothing. Buffers must be in SRAM, the DMA cannot reach the CCM.
+ *
+ * Because of an STM32F40x erratum DMA2 must not serve GPIO and APB2 peripherals at the same time,
+ * so a waveform can't start while SPI1 has a DMA transfer running, and SPI1 DMA transfers are
+ * refused while a waveform plays (see dma2_port).
+ */
+
+// Word that sets pins (GPIO_PIN_x mask)
+#define WAVEFORM_SET(pins_)         ((uint32_t)(pins_))
+// Word that resets pins (GPIO_PIN_x mask)
+#define WAVEFORM_RESET(pins_)       ((uint32_t)(pins_) << 16)
+
+// TIM8 runs from the APB2 timer clock, which is SystemCoreClock with the clock tree of hw_init()
+#define WAVEFORM_NS_TO_TICKS(ns_)   ((uint32_t)(((uint64_t)(ns_) * SystemCoreClock) / 1000000000ULL))
+
+/**
+ * @brief Called from the DMA interrupt when a buffer was played, to fill it again
+ *
+ * @param arg as given to waveform_stream
+ * @param buffer the buffer to fill
+ * @param words capacity of the buffer
+ * @return uint32_t words written. Less than words ends the waveform after them
+ */
+typedef uint32_t (*waveform_refill)(void *arg, uint32_t *buffer, uint32_t words);
+
+/**
+ * @brief Plays a buffer once
+ *
+ * @param port the port whose BSRR is written
+ * @param words BSRR words
+ * @param count number of words, up to 65535
+ * @param period timer ticks between two words, at least 2. See WAVEFORM_NS_TO_TICKS
+ * @return int32_t E_SUCCESS, E_DEVICE_BUSY if a waveform is playing or DMA2 serves SPI1, or error code
+ */
+int32_t waveform_play(GPIO_TypeDef *port, const uint32_t *words, uint32_t count, uint32_t period);
+
+/**
+ * @brief Plays a sequence of any length through two buffers in DMA double buffer mode
+ *
+ * refill is called for both buffers before starting, then from the interrupt each time a buffer
+ * was played while the other one plays. After a short refill the rest of that buffer is cleared
+ * to zero words and the waveform ends once its last word was played.
+ *
+ * @param port the port whose BSRR is written
+ * @param buffers two buffers of count words each
+ * @param count words per buffer, up to 65535
+ * @param period timer ticks between two words, at least 2. See WAVEFORM_NS_TO_TICKS
+ * @param refill fills buffers
+ * @param arg passed to refill
+ * @return int32_t E_SUCCESS, E_DEVICE_BUSY if a waveform is playing or DMA2 serves SPI1, or error code
+ */
+int32_t waveform_stream(GPIO_TypeDef *port, uint32_t * const buffers[2], uint32_t count, uint32_t period,
+    waveform_refill refill, void *arg);
+
+/**
+ * @brief Blocks until the waveform playing ends
+ *
+ * @param timeout in ticks
+ * @return int32_t E_SUCCESS, E_DMA_ERROR if the transfer failed, E_TIMEOUT or E_NOT_INITIALIZED
+ */
+int32_t waveform_wait(uint32_t timeout);
+
+/**
+ * @brief Stops the waveform right away. Pins keep the level of the last word played
+ */
+void waveform_stop(void);
+
+#endif // INCLUDE_STM32F4XX_WAVEFORM_H_
@@ -0,0 +1,66 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/drift.h"
+
+#include "include/errors.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Fill level low-pass: level += (fill - level) >> DRIFT_LEVEL_SHIFT
+#define DRIFT_LEVEL_SHIFT   4
+
+static int32_t drift_clamp(int32_t x, int32_t limit)
+{
+    if (x > limit) return limit;
+    if (x < -limit) return -limit;
+    return x;
+}
+
+int32_t drift_init(struct drift * const drift, struct resampler * const rs, uint32_t target_fill,
+    uint32_t max_ppm)
+{
+    if (drift == NULL || rs == NULL || target_fill > (INT32_MAX >> 8) || max_ppm > 10000)
+        return E_INVALID_PARAMETER;
+
+    drift->rs = rs;
+    drift->nominal_step = rs->step;
+    drift->max_delta = (int32_t)(((uint64_t)rs->step * max_ppm) / 1000000);
+    drift->target = (int32_t)(target_fill << 8);
+    drift->level = drift->target;
+    drift->integral = 0;
+    drift->kp = DRIFT_DEFAULT_KP;
+    drift->ki_shift = DRIFT_DEFAULT_KI_SHIFT;
+    drift->delta = 0;
+
+    return E_SUCCESS;
+}
+
+void drift_update(struct drift * const drift, uint32_t fill)
+{
+    // Fill moves by a whole block every time the consumer runs, so only its average matters
+    drift->level += ((int32_t)(fill << 8) - drift->level) >> DRIFT_LEVEL_SHIFT;
+    int32_t error = drift->level - drift->target;
+
+    // Integral is bounded so it alone can reach the limit, but never wind up past it
+    int32_t limit = drift->max_delta << drift->ki_shift;
+    drift->integral = drift_clamp(drift->integral + error, limit);
+
+    // A fuller ring means the producer is ahead: eat more input per output frame
+    int64_t delta = (int64_t)error * drift->kp + (drift->integral >> drift->ki_shift);
+    drift->delta = (int32_t)(delta > drift->max_delta ? drift->max_delta :
+        delta < -drift->max_delta ? -drift->max_delta : delta);
+
+    resampler_set_step(drift->rs, drift->nominal_step + drift->delta);
+}
+
+int32_t drift_ppm(const struct drift * const drift)
+{
+    return (int32_t)(((int64_t)drift->delta * 1000000) / drift->nominal_step);
+}
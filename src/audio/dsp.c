@@ -0,0 +1,213 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/dsp.h"
+
+#include <stdint.h>
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+#include "stm32f4xx.h"
+
+#define dsp_qadd16(a, b)        __QADD16((a), (b))
+#define dsp_smlald(a, b, acc)   ((int64_t)__SMLALD((a), (b), (uint64_t)(acc)))
+#define dsp_ssat16(x)           __SSAT((x), 16)
+#define dsp_pkhbt(lo, hi)       __PKHBT((lo), (hi), 16)
+#define dsp_read_q15x2(p)       __UNALIGNED_UINT32_READ(p)
+#define dsp_write_q15x2(p, v)   __UNALIGNED_UINT32_WRITE((p), (v))
+
+#else
+
+// Portable versions of the Armv7E-M instructions, with the same results bit by bit
+
+static inline int32_t dsp_ssat16(int32_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return x;
+}
+
+static inline uint32_t dsp_pkhbt(uint32_t lo, uint32_t hi)
+{
+    return (lo & 0x0000ffff) | ((hi << 16) & 0xffff0000);
+}
+
+static inline uint32_t dsp_qadd16(uint32_t a, uint32_t b)
+{
+    int32_t lo = dsp_ssat16((int16_t)a + (int16_t)b);
+    int32_t hi = dsp_ssat16((int16_t)(a >> 16) + (int16_t)(b >> 16));
+    return dsp_pkhbt(lo, hi);
+}
+
+static inline int64_t dsp_smlald(uint32_t a, uint32_t b, int64_t acc)
+{
+    return acc + (int16_t)a * (int16_t)b + (int16_t)(a >> 16) * (int16_t)(b >> 16);
+}
+
+static inline uint32_t dsp_read_q15x2(const void *p)
+{
+    const uint16_t *s = (const uint16_t *)p;
+    return s[0] | ((uint32_t)s[1] << 16);
+}
+
+static inline void dsp_write_q15x2(void *p, uint32_t v)
+{
+    uint16_t *s = (uint16_t *)p;
+    s[0] = (uint16_t)v;
+    s[1] = (uint16_t)(v >> 16);
+}
+
+#endif
+
+static inline int32_t dsp_ssat16_64(int64_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return (int32_t)x;
+}
+
+/**
+ * @brief Scales both halves of a packed pair by a Q15 gain
+ */
+static inline uint32_t dsp_scale_q15x2(uint32_t x, int16_t gain)
+{
+    int32_t lo = dsp_ssat16(((int16_t)x * gain) >> 15);
+    int32_t hi = dsp_ssat16(((int16_t)(x >> 16) * gain) >> 15);
+    return dsp_pkhbt(lo, hi);
+}
+
+static uint32_t dsp_isqrt(uint32_t x)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+void dsp_mix_q15(int16_t *dst, const int16_t *src, uint32_t samples)
+{
+    for (; samples >= 2; samples -= 2, dst += 2, src += 2)
+        dsp_write_q15x2(dst, dsp_qadd16(dsp_read_q15x2(dst), dsp_read_q15x2(src)));
+
+    if (samples) *dst = dsp_ssat16(*dst + *src);
+}
+
+void dsp_mix_gain_q15(int16_t *dst, const int16_t *src, uint32_t samples, int16_t gain)
+{
+    for (; samples >= 2; samples -= 2, dst += 2, src += 2)
+        dsp_write_q15x2(dst, dsp_qadd16(dsp_read_q15x2(dst), dsp_scale_q15x2(dsp_read_q15x2(src), gain)));
+
+    if (samples) *dst = dsp_ssat16(*dst + dsp_ssat16((*src * gain) >> 15));
+}
+
+void dsp_gain_q15(int16_t *buf, uint32_t samples, int16_t gain)
+{
+    for (; samples >= 2; samples -= 2, buf += 2)
+        dsp_write_q15x2(buf, dsp_scale_q15x2(dsp_read_q15x2(buf), gain));
+
+    if (samples) *buf = dsp_ssat16((*buf * gain) >> 15);
+}
+
+void dsp_biquad_q15(const struct dsp_biquad * const bq, int16_t *buf, uint32_t frames, uint32_t stride)
+{
+    for (uint32_t s = 0; s < bq->stages; s++) {
+        const struct dsp_biquad_coeffs *c = &bq->coeffs[s];
+        struct dsp_biquad_state *st = &bq->state[s];
+        uint32_t b0b1 = dsp_pkhbt(c->b0, c->b1);
+        uint32_t b2a1 = dsp_pkhbt(c->b2, c->a1);
+        int32_t x1 = st->x1, x2 = st->x2, y1 = st->y1, y2 = st->y2;
+        int16_t *p = buf;
+
+        for (uint32_t i = 0; i < frames; i++, p += stride) {
+            int32_t x0 = *p;
+            // Five Q15 x Q14 products can reach 2^32, so the sum is kept in 64 bits as in CMSIS
+            int64_t acc = dsp_smlald(dsp_pkhbt(x0, x1), b0b1, 0);
+            acc = dsp_smlald(dsp_pkhbt(x2, y1), b2a1, acc);
+            acc += c->a2 * y2;
+
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = dsp_ssat16_64(acc >> 14);
+            *p = (int16_t)y1;
+        }
+
+        st->x1 = x1;
+        st->x2 = x2;
+        st->y1 = y1;
+        st->y2 = y2;
+    }
+}
+
+void dsp_fir_q15(struct dsp_fir * const fir, const int16_t *in, int16_t *out, uint32_t frames, uint32_t stride)
+{
+    uint32_t n = fir->num_taps;
+    uint32_t pos = fir->pos;
+
+    for (uint32_t i = 0; i < frames; i++, in += stride, out += stride) {
+        // Every sample is stored twice so the window is always contiguous
+        fir->history[pos] = *in;
+        fir->history[pos + n] = *in;
+
+        // Oldest sample first, newest at history[pos + n]
+        *out = dsp_dot_q15(&fir->history[pos + 1], fir->taps, n);
+        if (++pos == n) pos = 0;
+    }
+
+    fir->pos = pos;
+}
+
+int16_t dsp_dot_q15(const int16_t *a, const int16_t *b, uint32_t length)
+{
+    int64_t acc = 0;
+
+    for (uint32_t k = 0; k < length; k += 2)
+        acc = dsp_smlald(dsp_read_q15x2(&a[k]), dsp_read_q15x2(&b[k]), acc);
+
+    return (int16_t)dsp_ssat16_64(acc >> 15);
+}
+
+void dsp_q15_to_i2s32(const int16_t *in, uint16_t *out, uint32_t samples)
+{
+    for (uint32_t i = 0; i < samples; i++, out += 2) {
+        out[0] = (uint16_t)in[i];
+        out[1] = 0;
+    }
+}
+
+void dsp_i2s32_to_q15(const uint16_t *in, int16_t *out, uint32_t samples)
+{
+    for (uint32_t i = 0; i < samples; i++, in += 2) out[i] = (int16_t)in[0];
+}
+
+void dsp_meter_q15(const int16_t *buf, uint32_t frames, uint32_t stride, struct dsp_meter * const meter)
+{
+    uint64_t sum = 0;
+    int32_t peak = 0;
+
+    for (uint32_t i = 0; i < frames; i++, buf += stride) {
+        int32_t x = *buf;
+        int32_t mag = x < 0 ? -x : x;
+        if (mag > peak) peak = mag;
+        sum += (uint32_t)(x * x);
+    }
+
+    meter->peak = (int16_t)dsp_ssat16(peak);
+    meter->rms = frames ? (int16_t)dsp_ssat16(dsp_isqrt((uint32_t)(sum / frames))) : 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/mixer.h"
+
+#include "include/errors.h"
+#include "include/stm32f4xx/i2s.h"
+#include "include/stm32f4xx/dsp.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f4xx.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Samples per stereo frame
+#define FRAME_SAMPLES   2
+
+struct mixer_source {
+    int16_t             *ring;
+    uint32_t            size;       // In samples, power of two
+    volatile uint32_t   head;       // Free running, only written by the producer
+    volatile uint32_t   tail;       // Free running, only written by the mixer
+    volatile int16_t    gain;
+    volatile uint32_t   playing;
+    volatile uint32_t   finishing;
+    volatile uint32_t   underruns;
+};
+
+struct mixer_state {
+    const struct i2s_device *i2s;
+    struct mixer_source     sources[MIXER_MAX_SOURCES];
+};
+
+static struct mixer_state mixer;
+
+static struct mixer_source *mixer_get_source(int32_t id)
+{
+    if (id < 0 || id >= MIXER_MAX_SOURCES || mixer.sources[id].ring == NULL) return NULL;
+    return &mixer.sources[id];
+}
+
+static void mixer_add(int16_t *out, const int16_t *in, uint32_t samples, int16_t gain)
+{
+    if (gain == MIXER_GAIN_UNITY)   dsp_mix_q15(out, in, samples);
+    else                            dsp_mix_gain_q15(out, in, samples, gain);
+}
+
+static void mixer_callback(void *arg, void *block, uint32_t frames)
+{
+    int16_t *out = (int16_t *)block;
+    uint32_t samples = frames * FRAME_SAMPLES;
+
+    for (uint32_t i = 0; i < samples; i++) out[i] = 0;
+
+    for (int i = 0; i < MIXER_MAX_SOURCES; i++) {
+        struct mixer_source *source = &mixer.sources[i];
+        if (source->ring == NULL || source->playing == 0) continue;
+
+        uint32_t tail = source->tail;
+        uint32_t available = source->head - tail;
+        uint32_t count = available < samples ? available : samples;
+        uint32_t offset = tail & (source->size - 1);
+        uint32_t first = source->size - offset;
+        if (first > count) first = count;
+
+        __DMB(); // Samples must be read only after head
+        mixer_add(out, &source->ring[offset], first, source->gain);
+        mixer_add(&out[first], source->ring, count - first, source->gain);
+        __DMB();
+        source->tail = tail + count;
+
+        if (count < samples) {
+            if (source->finishing == 0) source->underruns++;
+            source->playing = 0;
+        }
+    }
+}
+
+int32_t mixer_start(const struct i2s_device * const i2s, int16_t *buffer, uint32_t frames)
+{
+    struct i2s_config config;
+    int32_t ret;
+
+    if (mixer.i2s != NULL) {
+        ret = E_DEVICE_BUSY;
+        goto exit;
+    }
+
+    if ((ret = stm32f4xx_i2s_get_config(i2s, &config)) != E_SUCCESS) goto exit;
+    if (config.format != I2S_FORMAT_16BIT) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = stm32f4xx_i2s_stream_start(i2s, buffer, frames, mixer_callback, NULL)) != E_SUCCESS) goto exit;
+    mixer.i2s = i2s;
+
+    exit:
+    return ret;
+}
+
+int32_t mixer_stop(void)
+{
+    if (mixer.i2s == NULL) return E_NOT_INITIALIZED;
+
+    stm32f4xx_i2s_stream_stop(mixer.i2s);
+    mixer.i2s = NULL;
+
+    return E_SUCCESS;
+}
+
+int32_t mixer_source_open(int16_t *ring, uint32_t frames, int16_t gain)
+{
+    int32_t ret = E_DEVICE_BUSY;
+
+    if (ring == NULL || frames == 0 || (frames & (frames - 1)) != 0) return E_INVALID_PARAMETER;
+
+    taskENTER_CRITICAL();
+    for (int32_t i = 0; i < MIXER_MAX_SOURCES; i++) {
+        struct mixer_source *source = &mixer.sources[i];
+        if (source->ring != NULL) continue;
+
+        source->size = frames * FRAME_SAMPLES;
+        source->head = 0;
+        source->tail = 0;
+        source->gain = gain;
+        source->playing = 0;
+        source->finishing = 0;
+        source->underruns = 0;
+        source->ring = ring;
+        ret = i;
+        break;
+    }
+    taskEXIT_CRITICAL();
+
+    return ret;
+}
+
+int32_t mixer_source_close(int32_t id)
+{
+    struct mixer_source *source = mixer_get_source(id);
+
+    if (source == NULL) return E_INVALID_PARAMETER;
+
+    taskENTER_CRITICAL();
+    source->playing = 0;
+    source->ring = NULL;
+    taskEXIT_CRITICAL();
+
+    return E_SUCCESS;
+}
+
+int32_t mixer_source_write(int32_t id, const int16_t *data, uint32_t frames)
+{
+    struct mixer_source *source = mixer_get_source(id);
+
+    if (source == NULL || data == NULL) return E_INVALID_PARAMETER;
+
+    uint32_t head = source->head;
+    uint32_t space = source->size - (head - source->tail);
+    uint32_t count = frames * FRAME_SAMPLES;
+    if (count > space) count = space;
+
+    uint32_t offset = head & (source->size - 1);
+    for (uint32_t i = 0; i < count; i++) source->ring[(offset + i) & (source->size - 1)] = data[i];
+
+    __DMB(); // Samples must be visible before head
+    source->head = head + count;
+    source->finishing = 0;
+    if (count) source->playing = 1;
+
+    return count / FRAME_SAMPLES;
+}
+
+int32_t mixer_source_finish(int32_t id)
+{
+    struct mixer_source *source = mixer_get_source(id);
+
+    if (source == NULL) return E_INVALID_PARAMETER;
+    source->finishing = 1;
+
+    return E_SUCCESS;
+}
+
+int32_t mixer_source_space(int32_t id)
+{
+    struct mixer_source *source = mixer_get_source(id);
+
+    if (source == NULL) return E_INVALID_PARAMETER;
+
+    return (source->size - (source->head - source->tail)) / FRAME_SAMPLES;
+}
+
+int32_t mixer_source_set_gain(int32_t id, int16_t gain)
+{
+    struct mixer_source *source = mixer_get_source(id);
+
+    if (source == NULL) return E_INVALID_PARAMETER;
+    source->gain = gain;
+
+    return E_SUCCESS;
+}
+
+int32_t mixer_source_underruns(int32_t id)
+{
+    struct mixer_source *source = mixer_get_source(id);
+
+    if (source == NULL) return E_INVALID_PARAMETER;
+
+    return source->underruns;
+}
@@ -0,0 +1,569 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/resampler.h"
+
+#include "include/errors.h"
+#include "include/stm32f4xx/dsp.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define RESAMPLER_MAX_STEP  (8 * RESAMPLER_ONE)
+
+/*
+ * Coefficient tables, Q15, one row of taps per phase. Row p interpolates at p / phases of a frame
+ * past the center of the window. Taps are in history order (oldest first) and every row sums to
+ * 1.0 so DC goes through unchanged.
+ */
+
+static const int16_t resampler_table_low[64 * 2] = {
+    32767, 0,
+    32256, 512,
+    31744, 1024,
+    31232, 1536,
+    30720, 2048,
+    30208, 2560,
+    29696, 3072,
+    29184, 3584,
+    28672, 4096,
+    28160, 4608,
+    27648, 5120,
+    27136, 5632,
+    26624, 6144,
+    26112, 6656,
+    25600, 7168,
+    25088, 7680,
+    24576, 8192,
+    24064, 8704,
+    23552, 9216,
+    23040, 9728,
+    22528, 10240,
+    22016, 10752,
+    21504, 11264,
+    20992, 11776,
+    20480, 12288,
+    19968, 12800,
+    19456, 13312,
+    18944, 13824,
+    18432, 14336,
+    17920, 14848,
+    17408, 15360,
+    16896, 15872,
+    16384, 16384,
+    15872, 16896,
+    15360, 17408,
+    14848, 17920,
+    14336, 18432,
+    13824, 18944,
+    13312, 19456,
+    12800, 19968,
+    12288, 20480,
+    11776, 20992,
+    11264, 21504,
+    10752, 22016,
+    10240, 22528,
+    9728, 23040,
+    9216, 23552,
+    8704, 24064,
+    8192, 24576,
+    7680, 25088,
+    7168, 25600,
+    6656, 26112,
+    6144, 26624,
+    5632, 27136,
+    5120, 27648,
+    4608, 28160,
+    4096, 28672,
+    3584, 29184,
+    3072, 29696,
+    2560, 30208,
+    2048, 30720,
+    1536, 31232,
+    1024, 31744,
+    512, 32256
+};
+
+static const int16_t resampler_table_medium[128 * 8] = {
+    646, -1688, 2786, 29371, 2786, -1688, 646, -91,
+    628, -1622, 2570, 29371, 3005, -1754, 664, -94,
+    610, -1556, 2358, 29365, 3227, -1821, 682, -97,
+    592, -1491, 2148, 29355, 3452, -1888, 700, -100,
+    574, -1425, 1940, 29339, 3680, -1955, 718, -103,
+    556, -1360, 1736, 29318, 3910, -2022, 736, -106,
+    539, -1296, 1535, 29291, 4143, -2089, 754, -109,
+    521, -1232, 1337, 29261, 4378, -2156, 771, -112,
+    503, -1168, 1142, 29224, 4617, -2223, 789, -116,
+    486, -1105, 950, 29182, 4857, -2289, 806, -119,
+    468, -1042, 762, 29134, 5100, -2356, 824, -122,
+    451, -980, 576, 29082, 5346, -2423, 841, -125,
+    433, -918, 394, 29025, 5593, -2489, 858, -128,
+    416, -857, 215, 28961, 5844, -2555, 875, -131,
+    399, -796, 39, 28893, 6096, -2621, 892, -134,
+    382, -736, -134, 28821, 6350, -2686, 908, -137,
+    366, -677, -303, 28741, 6607, -2751, 925, -140,
+    349, -618, -469, 28659, 6865, -2816, 941, -143,
+    333, -560, -632, 28570, 7126, -2880, 957, -146,
+    317, -503, -791, 28478, 7388, -2944, 972, -149,
+    301, -446, -947, 28379, 7653, -3007, 987, -152,
+    285, -390, -1100, 28276, 7919, -3069, 1002, -155,
+    269, -335, -1249, 28167, 8187, -3131, 1017, -157,
+    254, -281, -1395, 28055, 8456, -3192, 1031, -160,
+    238, -227, -1537, 27936, 8727, -3252, 1045, -162,
+    223, -175, -1676, 27815, 8999, -3312, 1059, -165,
+    209, -123, -1811, 27685, 9273, -3370, 1072, -167,
+    194, -72, -1943, 27554, 9548, -3428, 1085, -170,
+    180, -22, -2072, 27418, 9824, -3485, 1097, -172,
+    166, 27, -2197, 27276, 10102, -3541, 1109, -174,
+    152, 75, -2319, 27129, 10381, -3595, 1121, -176,
+    138, 123, -2437, 26979, 10660, -3649, 1132, -178,
+    125, 169, -2552, 26824, 10941, -3701, 1142, -180,
+    112, 215, -2663, 26665, 11222, -3753, 1152, -182,
+    99, 259, -2771, 26502, 11504, -3803, 1162, -184,
+    87, 303, -2875, 26331, 11787, -3851, 1171, -185,
+    75, 345, -2976, 26160, 12071, -3899, 1179, -187,
+    63, 387, -3074, 25983, 12355, -3945, 1187, -188,
+    51, 428, -3168, 25802, 12639, -3989, 1194, -189,
+    39, 467, -3259, 25618, 12924, -4032, 1201, -190,
+    28, 506, -3346, 25429, 13209, -4074, 1207, -191,
+    17, 543, -3430, 25237, 13494, -4114, 1212, -191,
+    7, 580, -3510, 25039, 13779, -4152, 1217, -192,
+    -3, 616, -3588, 24839, 14064, -4189, 1221, -192,
+    -13, 650, -3662, 24635, 14349, -4223, 1225, -193,
+    -23, 684, -3732, 24427, 14634, -4256, 1227, -193,
+    -33, 716, -3800, 24217, 14919, -4288, 1229, -192,
+    -42, 748, -3864, 24001, 15203, -4317, 1231, -192,
+    -51, 778, -3925, 23784, 15487, -4344, 1231, -192,
+    -59, 807, -3982, 23561, 15770, -4369, 1231, -191,
+    -67, 836, -4037, 23336, 16053, -4393, 1230, -190,
+    -75, 863, -4088, 23108, 16335, -4414, 1228, -189,
+    -83, 889, -4136, 22877, 16616, -4433, 1225, -187,
+    -91, 915, -4181, 22643, 16896, -4450, 1222, -186,
+    -98, 939, -4223, 22407, 17175, -4465, 1217, -184,
+    -105, 962, -4261, 22166, 17453, -4477, 1212, -182,
+    -111, 984, -4297, 21923, 17730, -4487, 1206, -180,
+    -117, 1005, -4330, 21679, 18005, -4495, 1199, -178,
+    -123, 1026, -4360, 21429, 18279, -4500, 1192, -175,
+    -129, 1045, -4387, 21179, 18552, -4503, 1183, -172,
+    -135, 1063, -4411, 20927, 18823, -4503, 1173, -169,
+    -140, 1080, -4432, 20670, 19093, -4501, 1163, -165,
+    -145, 1096, -4450, 20413, 19361, -4496, 1151, -162,
+    -149, 1111, -4466, 20153, 19627, -4489, 1139, -158,
+    -154, 1126, -4479, 19891, 19891, -4479, 1126, -154,
+    -158, 1139, -4489, 19627, 20153, -4466, 1111, -149,
+    -162, 1151, -4496, 19361, 20413, -4450, 1096, -145,
+    -165, 1163, -4501, 19093, 20670, -4432, 1080, -140,
+    -169, 1173, -4503, 18824, 20926, -4411, 1063, -135,
+    -172, 1183, -4503, 18552, 21179, -4387, 1045, -129,
+    -175, 1192, -4500, 18279, 21429, -4360, 1026, -123,
+    -178, 1199, -4495, 18006, 21678, -4330, 1005, -117,
+    -180, 1206, -4487, 17730, 21923, -4297, 984, -111,
+    -182, 1212, -4477, 17453, 22166, -4261, 962, -105,
+    -184, 1217, -4465, 17176, 22406, -4223, 939, -98,
+    -186, 1222, -4450, 16896, 22643, -4181, 915, -91,
+    -187, 1225, -4433, 16616, 22877, -4136, 889, -83,
+    -189, 1228, -4414, 16335, 23108, -4088, 863, -75,
+    -190, 1230, -4393, 16052, 23337, -4037, 836, -67,
+    -191, 1231, -4369, 15770, 23561, -3982, 807, -59,
+    -192, 1231, -4344, 15488, 23783, -3925, 778, -51,
+    -192, 1231, -4317, 15203, 24001, -3864, 748, -42,
+    -192, 1229, -4288, 14920, 24216, -3800, 716, -33,
+    -193, 1227, -4256, 14634, 24427, -3732, 684, -23,
+    -193, 1225, -4223, 14349, 24635, -3662, 650, -13,
+    -192, 1221, -4189, 14064, 24839, -3588, 616, -3,
+    -192, 1217, -4152, 13778, 25040, -3510, 580, 7,
+    -191, 1212, -4114, 13495, 25236, -3430, 543, 17,
+    -191, 1207, -4074, 13209, 25429, -3346, 506, 28,
+    -190, 1201, -4032, 12924, 25618, -3259, 467, 39,
+    -189, 1194, -3989, 12639, 25802, -3168, 428, 51,
+    -188, 1187, -3945, 12355, 25983, -3074, 387, 63,
+    -187, 1179, -3899, 12071, 26160, -2976, 345, 75,
+    -185, 1171, -3851, 11786, 26332, -2875, 303, 87,
+    -184, 1162, -3803, 11506, 26500, -2771, 259, 99,
+    -182, 1152, -3753, 11223, 26664, -2663, 215, 112,
+    -180, 1142, -3701, 10941, 26824, -2552, 169, 125,
+    -178, 1132, -3649, 10660, 26979, -2437, 123, 138,
+    -176, 1121, -3595, 10381, 27129, -2319, 75, 152,
+    -174, 1109, -3541, 10102, 27276, -2197, 27, 166,
+    -172, 1097, -3485, 9825, 27417, -2072, -22, 180,
+    -170, 1085, -3428, 9548, 27554, -1943, -72, 194,
+    -167, 1072, -3370, 9272, 27686, -1811, -123, 209,
+    -165, 1059, -3312, 9000, 27814, -1676, -175, 223,
+    -162, 1045, -3252, 8727, 27936, -1537, -227, 238,
+    -160, 1031, -3192, 8457, 28054, -1395, -281, 254,
+    -157, 1017, -3131, 8186, 28168, -1249, -335, 269,
+    -155, 1002, -3069, 7919, 28276, -1100, -390, 285,
+    -152, 987, -3007, 7653, 28379, -947, -446, 301,
+    -149, 972, -2944, 7389, 28477, -791, -503, 317,
+    -146, 957, -2880, 7125, 28571, -632, -560, 333,
+    -143, 941, -2816, 6865, 28659, -469, -618, 349,
+    -140, 925, -2751, 6606, 28742, -303, -677, 366,
+    -137, 908, -2686, 6351, 28820, -134, -736, 382,
+    -134, 892, -2621, 6096, 28893, 39, -796, 399,
+    -131, 875, -2555, 5844, 28961, 215, -857, 416,
+    -128, 858, -2489, 5594, 29024, 394, -918, 433,
+    -125, 841, -2423, 5346, 29082, 576, -980, 451,
+    -122, 824, -2356, 5100, 29134, 762, -1042, 468,
+    -119, 806, -2289, 4858, 29181, 950, -1105, 486,
+    -116, 789, -2223, 4618, 29223, 1142, -1168, 503,
+    -112, 771, -2156, 4379, 29260, 1337, -1232, 521,
+    -109, 754, -2089, 4142, 29292, 1535, -1296, 539,
+    -106, 736, -2022, 3910, 29318, 1736, -1360, 556,
+    -103, 718, -1955, 3680, 29339, 1940, -1425, 574,
+    -100, 700, -1888, 3452, 29355, 2148, -1491, 592,
+    -97, 682, -1821, 3227, 29365, 2358, -1556, 610,
+    -94, 664, -1754, 3006, 29370, 2570, -1622, 628
+};
+
+static const int16_t resampler_table_high[256 * 16] = {
+    48, -192, 511, -1047, 1755, -2496, 3063, 29489, 3063, -2496, 1755, -1047, 511, -192, 48, -5,
+    48, -192, 510, -1040, 1737, -2451, 2946, 29484, 3181, -2540, 1774, -1053, 513, -192, 48, -5,
+    48, -192, 508, -1033, 1718, -2406, 2830, 29483, 3299, -2585, 1792, -1060, 515, -192, 48, -5,
+    48, -192, 506, -1026, 1699, -2361, 2714, 29479, 3418, -2630, 1811, -1066, 516, -192, 48, -4,
+    48, -192, 504, -1019, 1680, -2316, 2599, 29474, 3537, -2674, 1829, -1072, 518, -192, 48, -4,
+    48, -191, 502, -1012, 1661, -2271, 2484, 29471, 3657, -2719, 1847, -1079, 519, -192, 47, -4,
+    49, -191, 500, -1005, 1642, -2226, 2371, 29462, 3778, -2763, 1865, -1085, 520, -192, 47, -4,
+    49, -191, 498, -998, 1622, -2180, 2257, 29456, 3899, -2808, 1882, -1091, 522, -192, 47, -4,
+    49, -191, 496, -990, 1603, -2135, 2145, 29445, 4021, -2852, 1900, -1097, 523, -192, 47, -4,
+    49, -190, 494, -983, 1583, -2090, 2033, 29435, 4143, -2896, 1917, -1102, 524, -192, 47, -4,
+    49, -190, 492, -975, 1563, -2045, 1922, 29425, 4266, -2940, 1934, -1108, 525, -192, 46, -4,
+    49, -190, 490, -968, 1544, -1999, 1812, 29409, 4389, -2983, 1952, -1113, 526, -192, 46, -4,
+    49, -189, 487, -960, 1524, -1954, 1702, 29396, 4513, -3027, 1968, -1119, 527, -191, 46, -4,
+    49, -189, 485, -952, 1504, -1909, 1593, 29380, 4638, -3071, 1985, -1124, 528, -191, 46, -4,
+    49, -188, 483, -944, 1484, -1864, 1484, 29362, 4763, -3114, 2002, -1129, 529, -191, 46, -4,
+    49, -188, 480, -936, 1463, -1818, 1377, 29345, 4889, -3157, 2018, -1134, 530, -191, 45, -4,
+    49, -187, 478, -928, 1443, -1773, 1270, 29325, 5015, -3200, 2034, -1139, 530, -190, 45, -4,
+    49, -187, 475, -920, 1423, -1728, 1164, 29306, 5141, -3243, 2050, -1144, 531, -190, 45, -4,
+    49, -186, 473, -912, 1402, -1683, 1058, 29284, 5269, -3286, 2066, -1149, 531, -189, 45, -4,
+    49, -186, 470, -904, 1382, -1638, 953, 29263, 5396, -3328, 2082, -1154, 532, -189, 44, -4,
+    49, -185, 467, -895, 1361, -1592, 849, 29238, 5524, -3371, 2097, -1158, 532, -188, 44, -4,
+    48, -185, 465, -887, 1341, -1547, 746, 29211, 5653, -3413, 2113, -1162, 533, -188, 44, -4,
+    48, -184, 462, -878, 1320, -1502, 643, 29185, 5782, -3455, 2128, -1166, 533, -187, 43, -4,
+    48, -183, 459, -870, 1299, -1457, 541, 29158, 5912, -3496, 2143, -1171, 533, -187, 43, -4,
+    48, -183, 456, -861, 1278, -1412, 440, 29129, 6042, -3538, 2157, -1174, 533, -186, 43, -4,
+    48, -182, 453, -852, 1258, -1368, 340, 29099, 6172, -3579, 2172, -1178, 533, -186, 42, -4,
+    48, -181, 450, -844, 1237, -1323, 240, 29067, 6303, -3620, 2186, -1182, 533, -185, 42, -3,
+    48, -181, 447, -835, 1216, -1278, 141, 29035, 6434, -3661, 2200, -1185, 533, -184, 41, -3,
+    48, -180, 444, -826, 1195, -1234, 43, 29002, 6566, -3702, 2214, -1189, 533, -184, 41, -3,
+    48, -179, 441, -817, 1174, -1189, -54, 28964, 6698, -3742, 2228, -1192, 533, -183, 41, -3,
+    48, -178, 438, -808, 1152, -1145, -151, 28929, 6831, -3782, 2241, -1195, 533, -182, 40, -3,
+    47, -178, 435, -799, 1131, -1100, -246, 28891, 6964, -3822, 2255, -1198, 532, -181, 40, -3,
+    47, -177, 432, -790, 1110, -1056, -341, 28853, 7097, -3862, 2268, -1201, 532, -180, 39, -3,
+    47, -176, 429, -781, 1089, -1012, -435, 28814, 7231, -3901, 2280, -1204, 531, -180, 39, -3,
+    47, -175, 425, -772, 1068, -968, -529, 28772, 7365, -3940, 2293, -1206, 531, -179, 39, -3,
+    47, -174, 422, -763, 1046, -924, -621, 28731, 7500, -3979, 2305, -1209, 530, -178, 38, -3,
+    47, -173, 419, -753, 1025, -880, -713, 28686, 7635, -4018, 2317, -1211, 529, -177, 38, -3,
+    47, -173, 415, -744, 1004, -836, -804, 28642, 7770, -4056, 2329, -1213, 529, -176, 37, -3,
+    46, -172, 412, -735, 982, -793, -895, 28597, 7906, -4094, 2341, -1215, 528, -175, 37, -2,
+    46, -171, 409, -725, 961, -749, -984, 28549, 8041, -4131, 2352, -1217, 527, -174, 36, -2,
+    46, -170, 405, -716, 940, -706, -1073, 28502, 8178, -4169, 2363, -1219, 526, -173, 36, -2,
+    46, -169, 402, -706, 918, -663, -1160, 28452, 8314, -4206, 2374, -1220, 524, -171, 35, -2,
+    46, -168, 398, -697, 897, -620, -1247, 28401, 8451, -4242, 2385, -1221, 523, -170, 34, -2,
+    45, -167, 395, -687, 875, -577, -1333, 28351, 8588, -4279, 2395, -1223, 522, -169, 34, -2,
+    45, -166, 391, -677, 854, -534, -1419, 28298, 8726, -4315, 2405, -1224, 521, -168, 33, -2,
+    45, -165, 387, -668, 833, -492, -1503, 28244, 8864, -4350, 2415, -1225, 519, -167, 33, -2,
+    45, -164, 384, -658, 811, -449, -1587, 28187, 9002, -4386, 2425, -1225, 518, -165, 32, -2,
+    45, -163, 380, -648, 790, -407, -1670, 28130, 9140, -4420, 2434, -1226, 516, -164, 32, -1,
+    44, -162, 376, -639, 768, -365, -1752, 28077, 9278, -4455, 2443, -1226, 514, -163, 31, -1,
+    44, -160, 373, -629, 747, -323, -1833, 28015, 9417, -4489, 2452, -1227, 513, -161, 30, -1,
+    44, -159, 369, -619, 726, -282, -1913, 27956, 9556, -4523, 2460, -1227, 511, -160, 30, -1,
+    44, -158, 365, -609, 704, -240, -1993, 27895, 9696, -4557, 2469, -1227, 509, -158, 29, -1,
+    43, -157, 361, -599, 683, -199, -2071, 27835, 9835, -4590, 2477, -1227, 507, -157, 28, -1,
+    43, -156, 358, -590, 662, -158, -2149, 27770, 9975, -4622, 2484, -1226, 505, -155, 28, -1,
+    43, -155, 354, -580, 640, -117, -2226, 27707, 10115, -4655, 2492, -1226, 503, -154, 27, 0,
+    43, -154, 350, -570, 619, -76, -2302, 27641, 10255, -4686, 2499, -1225, 500, -152, 26, 0,
+    42, -152, 346, -560, 598, -36, -2378, 27575, 10395, -4718, 2506, -1224, 498, -150, 26, 0,
+    42, -151, 342, -550, 577, 4, -2452, 27509, 10535, -4749, 2512, -1223, 496, -149, 25, 0,
+    42, -150, 338, -540, 555, 45, -2525, 27440, 10676, -4780, 2519, -1222, 493, -147, 24, 0,
+    42, -149, 334, -530, 534, 84, -2598, 27371, 10817, -4810, 2525, -1221, 491, -145, 23, 0,
+    41, -148, 330, -520, 513, 124, -2670, 27300, 10958, -4840, 2530, -1219, 488, -143, 23, 1,
+    41, -146, 326, -510, 492, 163, -2741, 27229, 11099, -4869, 2536, -1218, 485, -142, 22, 1,
+    41, -145, 322, -500, 471, 203, -2811, 27155, 11240, -4898, 2541, -1216, 483, -140, 21, 1,
+    40, -144, 318, -490, 450, 241, -2880, 27083, 11381, -4926, 2546, -1214, 480, -138, 20, 1,
+    40, -143, 314, -480, 429, 280, -2949, 27007, 11523, -4954, 2550, -1211, 477, -136, 20, 1,
+    40, -141, 310, -470, 409, 319, -3016, 26929, 11664, -4981, 2554, -1209, 474, -134, 19, 1,
+    40, -140, 306, -460, 388, 357, -3083, 26853, 11806, -5008, 2558, -1207, 470, -132, 18, 2,
+    39, -139, 302, -450, 367, 395, -3149, 26777, 11947, -5035, 2562, -1204, 467, -130, 17, 2,
+    39, -137, 298, -440, 346, 432, -3213, 26697, 12089, -5061, 2565, -1201, 464, -128, 16, 2,
+    39, -136, 294, -430, 326, 470, -3278, 26617, 12231, -5087, 2568, -1198, 461, -126, 15, 2,
+    38, -135, 290, -420, 305, 507, -3341, 26537, 12373, -5112, 2571, -1195, 457, -124, 15, 2,
+    38, -133, 286, -410, 285, 544, -3403, 26451, 12515, -5136, 2573, -1191, 454, -122, 14, 3,
+    38, -132, 281, -400, 264, 581, -3464, 26369, 12657, -5160, 2575, -1188, 450, -119, 13, 3,
+    37, -131, 277, -390, 244, 617, -3525, 26288, 12798, -5184, 2577, -1184, 446, -117, 12, 3,
+    37, -129, 273, -380, 224, 653, -3585, 26203, 12940, -5207, 2578, -1180, 442, -115, 11, 3,
+    37, -128, 269, -370, 204, 689, -3643, 26115, 13082, -5229, 2579, -1176, 439, -113, 10, 3,
+    36, -127, 265, -360, 183, 725, -3701, 26028, 13224, -5251, 2580, -1172, 435, -110, 9, 4,
+    36, -125, 261, -350, 163, 760, -3758, 25940, 13366, -5272, 2580, -1167, 430, -108, 8, 4,
+    36, -124, 256, -340, 143, 795, -3814, 25853, 13508, -5293, 2580, -1163, 426, -106, 7, 4,
+    35, -122, 252, -330, 124, 830, -3870, 25762, 13650, -5314, 2580, -1158, 422, -103, 6, 4,
+    35, -121, 248, -320, 104, 864, -3924, 25671, 13792, -5333, 2579, -1153, 418, -101, 5, 4,
+    35, -120, 244, -310, 84, 898, -3978, 25581, 13933, -5353, 2578, -1148, 413, -98, 4, 5,
+    34, -118, 240, -300, 65, 932, -4030, 25486, 14075, -5371, 2577, -1143, 409, -96, 3, 5,
+    34, -117, 235, -290, 45, 966, -4082, 25393, 14217, -5389, 2575, -1137, 404, -93, 2, 5,
+    34, -115, 231, -280, 26, 999, -4133, 25298, 14358, -5407, 2573, -1131, 400, -91, 1, 5,
+    33, -114, 227, -270, 6, 1032, -4183, 25204, 14499, -5424, 2571, -1126, 395, -88, 0, 6,
+    33, -113, 223, -260, -13, 1064, -4232, 25107, 14641, -5440, 2568, -1120, 390, -85, -1, 6,
+    33, -111, 219, -250, -32, 1097, -4280, 25007, 14782, -5455, 2565, -1113, 385, -83, -2, 6,
+    32, -110, 214, -241, -51, 1129, -4328, 24912, 14923, -5471, 2562, -1107, 381, -80, -3, 6,
+    32, -108, 210, -231, -70, 1160, -4374, 24811, 15064, -5485, 2558, -1100, 375, -77, -4, 7,
+    32, -107, 206, -221, -89, 1192, -4420, 24712, 15205, -5499, 2554, -1094, 370, -75, -5, 7,
+    31, -105, 202, -211, -107, 1223, -4465, 24610, 15345, -5512, 2550, -1087, 365, -72, -6, 7,
+    31, -104, 198, -202, -126, 1254, -4509, 24509, 15486, -5525, 2545, -1080, 360, -69, -7, 7,
+    31, -103, 193, -192, -144, 1284, -4552, 24405, 15626, -5537, 2540, -1072, 355, -66, -8, 8,
+    30, -101, 189, -182, -163, 1314, -4594, 24302, 15766, -5548, 2535, -1065, 349, -63, -9, 8,
+    30, -100, 185, -173, -181, 1344, -4635, 24197, 15906, -5559, 2529, -1057, 344, -60, -10, 8,
+    30, -98, 181, -163, -199, 1374, -4676, 24092, 16045, -5569, 2523, -1049, 338, -57, -12, 8,
+    29, -97, 177, -154, -217, 1403, -4715, 23986, 16185, -5578, 2516, -1041, 332, -54, -13, 9,
+    29, -95, 172, -144, -235, 1432, -4754, 23879, 16324, -5587, 2509, -1033, 327, -51, -14, 9,
+    28, -94, 168, -135, -252, 1460, -4792, 23773, 16463, -5595, 2502, -1025, 321, -48, -15, 9,
+    28, -92, 164, -125, -270, 1488, -4829, 23662, 16602, -5603, 2495, -1016, 315, -45, -16, 10,
+    28, -91, 160, -116, -288, 1516, -4865, 23555, 16740, -5610, 2487, -1008, 309, -42, -17, 10,
+    27, -90, 156, -107, -305, 1543, -4900, 23448, 16878, -5616, 2478, -999, 303, -39, -19, 10,
+    27, -88, 151, -97, -322, 1571, -4935, 23335, 17016, -5621, 2470, -990, 297, -36, -20, 10,
+    27, -87, 147, -88, -339, 1597, -4968, 23223, 17154, -5626, 2461, -980, 290, -33, -21, 11,
+    26, -85, 143, -79, -356, 1624, -5001, 23111, 17291, -5630, 2451, -971, 284, -29, -22, 11,
+    26, -84, 139, -70, -373, 1650, -5033, 22998, 17428, -5633, 2441, -961, 278, -26, -23, 11,
+    26, -82, 135, -61, -390, 1676, -5064, 22885, 17565, -5636, 2431, -952, 271, -23, -25, 12,
+    25, -81, 131, -52, -406, 1701, -5094, 22771, 17701, -5638, 2421, -942, 265, -20, -26, 12,
+    25, -79, 127, -43, -423, 1726, -5123, 22654, 17837, -5639, 2410, -931, 258, -16, -27, 12,
+    25, -78, 123, -34, -439, 1751, -5152, 22540, 17972, -5640, 2399, -921, 251, -13, -28, 12,
+    24, -76, 119, -25, -455, 1775, -5179, 22423, 18108, -5640, 2387, -911, 245, -10, -30, 13,
+    24, -75, 115, -16, -471, 1799, -5206, 22305, 18243, -5639, 2375, -900, 238, -6, -31, 13,
+    23, -74, 110, -7, -487, 1823, -5232, 22189, 18377, -5637, 2363, -889, 231, -3, -32, 13,
+    23, -72, 106, 2, -503, 1846, -5257, 22070, 18511, -5635, 2350, -878, 224, 1, -34, 14,
+    23, -71, 102, 11, -518, 1869, -5282, 21951, 18645, -5632, 2337, -867, 217, 4, -35, 14,
+    22, -69, 98, 19, -534, 1891, -5305, 21832, 18778, -5628, 2324, -856, 210, 8, -36, 14,
+    22, -68, 94, 28, -549, 1914, -5328, 21710, 18911, -5623, 2310, -844, 203, 11, -38, 15,
+    22, -66, 90, 37, -564, 1936, -5349, 21586, 19044, -5618, 2296, -832, 195, 15, -39, 15,
+    21, -65, 86, 45, -579, 1957, -5370, 21468, 19176, -5612, 2281, -821, 188, 18, -40, 15,
+    21, -64, 83, 54, -594, 1978, -5391, 21344, 19307, -5605, 2266, -809, 181, 22, -41, 16,
+    21, -62, 79, 62, -608, 1999, -5410, 21220, 19438, -5598, 2251, -796, 173, 26, -43, 16,
+    20, -61, 75, 70, -623, 2019, -5429, 21098, 19569, -5589, 2236, -784, 166, 29, -44, 16,
+    20, -59, 71, 79, -637, 2039, -5446, 20971, 19699, -5580, 2220, -771, 158, 33, -46, 17,
+    20, -58, 67, 87, -651, 2059, -5463, 20847, 19829, -5570, 2203, -759, 150, 37, -47, 17,
+    19, -57, 63, 95, -665, 2078, -5479, 20724, 19958, -5560, 2186, -746, 143, 40, -48, 17,
+    19, -55, 59, 103, -679, 2097, -5495, 20597, 20087, -5548, 2169, -733, 135, 44, -50, 18,
+    19, -54, 55, 111, -693, 2116, -5509, 20470, 20215, -5536, 2152, -720, 127, 48, -51, 18,
+    18, -52, 52, 119, -706, 2134, -5523, 20341, 20343, -5523, 2134, -706, 119, 52, -52, 18,
+    18, -51, 48, 127, -720, 2152, -5536, 20215, 20470, -5509, 2116, -693, 111, 55, -54, 19,
+    18, -50, 44, 135, -733, 2169, -5548, 20088, 20596, -5495, 2097, -679, 103, 59, -55, 19,
+    17, -48, 40, 143, -746, 2186, -5560, 19960, 20722, -5479, 2078, -665, 95, 63, -57, 19,
+    17, -47, 37, 150, -759, 2203, -5570, 19828, 20848, -5463, 2059, -651, 87, 67, -58, 20,
+    17, -46, 33, 158, -771, 2220, -5580, 19697, 20973, -5446, 2039, -637, 79, 71, -59, 20,
+    16, -44, 29, 166, -784, 2236, -5589, 19570, 21097, -5429, 2019, -623, 70, 75, -61, 20,
+    16, -43, 26, 173, -796, 2251, -5598, 19437, 21221, -5410, 1999, -608, 62, 79, -62, 21,
+    16, -41, 22, 181, -809, 2266, -5605, 19307, 21344, -5391, 1978, -594, 54, 83, -64, 21,
+    15, -40, 18, 188, -821, 2281, -5612, 19178, 21466, -5370, 1957, -579, 45, 86, -65, 21,
+    15, -39, 15, 195, -832, 2296, -5618, 19042, 21588, -5349, 1936, -564, 37, 90, -66, 22,
+    15, -38, 11, 203, -844, 2310, -5623, 18912, 21709, -5328, 1914, -549, 28, 94, -68, 22,
+    14, -36, 8, 210, -856, 2324, -5628, 18780, 21830, -5305, 1891, -534, 19, 98, -69, 22,
+    14, -35, 4, 217, -867, 2337, -5632, 18646, 21950, -5282, 1869, -518, 11, 102, -71, 23,
+    14, -34, 1, 224, -878, 2350, -5635, 18512, 22069, -5257, 1846, -503, 2, 106, -72, 23,
+    13, -32, -3, 231, -889, 2363, -5637, 18378, 22188, -5232, 1823, -487, -7, 110, -74, 23,
+    13, -31, -6, 238, -900, 2375, -5639, 18243, 22305, -5206, 1799, -471, -16, 115, -75, 24,
+    13, -30, -10, 245, -911, 2387, -5640, 18108, 22423, -5179, 1775, -455, -25, 119, -76, 24,
+    12, -28, -13, 251, -921, 2399, -5640, 17973, 22539, -5152, 1751, -439, -34, 123, -78, 25,
+    12, -27, -16, 258, -931, 2410, -5639, 17836, 22655, -5123, 1726, -423, -43, 127, -79, 25,
+    12, -26, -20, 265, -942, 2421, -5638, 17702, 22770, -5094, 1701, -406, -52, 131, -81, 25,
+    12, -25, -23, 271, -952, 2431, -5636, 17565, 22885, -5064, 1676, -390, -61, 135, -82, 26,
+    11, -23, -26, 278, -961, 2441, -5633, 17428, 22998, -5033, 1650, -373, -70, 139, -84, 26,
+    11, -22, -29, 284, -971, 2451, -5630, 17291, 23111, -5001, 1624, -356, -79, 143, -85, 26,
+    11, -21, -33, 290, -980, 2461, -5626, 17154, 23223, -4968, 1597, -339, -88, 147, -87, 27,
+    10, -20, -36, 297, -990, 2470, -5621, 17016, 23335, -4935, 1571, -322, -97, 151, -88, 27,
+    10, -19, -39, 303, -999, 2478, -5616, 16880, 23446, -4900, 1543, -305, -107, 156, -90, 27,
+    10, -17, -42, 309, -1008, 2487, -5610, 16740, 23555, -4865, 1516, -288, -116, 160, -91, 28,
+    10, -16, -45, 315, -1016, 2495, -5603, 16599, 23665, -4829, 1488, -270, -125, 164, -92, 28,
+    9, -15, -48, 321, -1025, 2502, -5595, 16463, 23773, -4792, 1460, -252, -135, 168, -94, 28,
+    9, -14, -51, 327, -1033, 2509, -5587, 16323, 23880, -4754, 1432, -235, -144, 172, -95, 29,
+    9, -13, -54, 332, -1041, 2516, -5578, 16184, 23987, -4715, 1403, -217, -154, 177, -97, 29,
+    8, -12, -57, 338, -1049, 2523, -5569, 16044, 24093, -4676, 1374, -199, -163, 181, -98, 30,
+    8, -10, -60, 344, -1057, 2529, -5559, 15905, 24198, -4635, 1344, -181, -173, 185, -100, 30,
+    8, -9, -63, 349, -1065, 2535, -5548, 15766, 24302, -4594, 1314, -163, -182, 189, -101, 30,
+    8, -8, -66, 355, -1072, 2540, -5537, 15625, 24406, -4552, 1284, -144, -192, 193, -103, 31,
+    7, -7, -69, 360, -1080, 2545, -5525, 15487, 24508, -4509, 1254, -126, -202, 198, -104, 31,
+    7, -6, -72, 365, -1087, 2550, -5512, 15345, 24610, -4465, 1223, -107, -211, 202, -105, 31,
+    7, -5, -75, 370, -1094, 2554, -5499, 15206, 24711, -4420, 1192, -89, -221, 206, -107, 32,
+    7, -4, -77, 375, -1100, 2558, -5485, 15064, 24811, -4374, 1160, -70, -231, 210, -108, 32,
+    6, -3, -80, 381, -1107, 2562, -5471, 14925, 24910, -4328, 1129, -51, -241, 214, -110, 32,
+    6, -2, -83, 385, -1113, 2565, -5455, 14781, 25008, -4280, 1097, -32, -250, 219, -111, 33,
+    6, -1, -85, 390, -1120, 2568, -5440, 14642, 25106, -4232, 1064, -13, -260, 223, -113, 33,
+    6, 0, -88, 395, -1126, 2571, -5424, 14501, 25202, -4183, 1032, 6, -270, 227, -114, 33,
+    5, 1, -91, 400, -1131, 2573, -5407, 14358, 25298, -4133, 999, 26, -280, 231, -115, 34,
+    5, 2, -93, 404, -1137, 2575, -5389, 14218, 25392, -4082, 966, 45, -290, 235, -117, 34,
+    5, 3, -96, 409, -1143, 2577, -5371, 14075, 25486, -4030, 932, 65, -300, 240, -118, 34,
+    5, 4, -98, 413, -1148, 2578, -5353, 13935, 25579, -3978, 898, 84, -310, 244, -120, 35,
+    4, 5, -101, 418, -1153, 2579, -5333, 13793, 25670, -3924, 864, 104, -320, 248, -121, 35,
+    4, 6, -103, 422, -1158, 2580, -5314, 13651, 25761, -3870, 830, 124, -330, 252, -122, 35,
+    4, 7, -106, 426, -1163, 2580, -5293, 13510, 25851, -3814, 795, 143, -340, 256, -124, 36,
+    4, 8, -108, 430, -1167, 2580, -5272, 13366, 25940, -3758, 760, 163, -350, 261, -125, 36,
+    4, 9, -110, 435, -1172, 2580, -5251, 13224, 26028, -3701, 725, 183, -360, 265, -127, 36,
+    3, 10, -113, 439, -1176, 2579, -5229, 13082, 26115, -3643, 689, 204, -370, 269, -128, 37,
+    3, 11, -115, 442, -1180, 2578, -5207, 12942, 26201, -3585, 653, 224, -380, 273, -129, 37,
+    3, 12, -117, 446, -1184, 2577, -5184, 12800, 26286, -3525, 617, 244, -390, 277, -131, 37,
+    3, 13, -119, 450, -1188, 2575, -5160, 12656, 26370, -3464, 581, 264, -400, 281, -132, 38,
+    3, 14, -122, 454, -1191, 2573, -5136, 12513, 26453, -3403, 544, 285, -410, 286, -133, 38,
+    2, 15, -124, 457, -1195, 2571, -5112, 12374, 26536, -3341, 507, 305, -420, 290, -135, 38,
+    2, 15, -126, 461, -1198, 2568, -5087, 12231, 26617, -3278, 470, 326, -430, 294, -136, 39,
+    2, 16, -128, 464, -1201, 2565, -5061, 12089, 26697, -3213, 432, 346, -440, 298, -137, 39,
+    2, 17, -130, 467, -1204, 2562, -5035, 11948, 26776, -3149, 395, 367, -450, 302, -139, 39,
+    2, 18, -132, 470, -1207, 2558, -5008, 11805, 26854, -3083, 357, 388, -460, 306, -140, 40,
+    1, 19, -134, 474, -1209, 2554, -4981, 11662, 26931, -3016, 319, 409, -470, 310, -141, 40,
+    1, 20, -136, 477, -1211, 2550, -4954, 11524, 27006, -2949, 280, 429, -480, 314, -143, 40,
+    1, 20, -138, 480, -1214, 2546, -4926, 11383, 27081, -2880, 241, 450, -490, 318, -144, 40,
+    1, 21, -140, 483, -1216, 2541, -4898, 11240, 27155, -2811, 203, 471, -500, 322, -145, 41,
+    1, 22, -142, 485, -1218, 2536, -4869, 11100, 27228, -2741, 163, 492, -510, 326, -146, 41,
+    1, 23, -143, 488, -1219, 2530, -4840, 10958, 27300, -2670, 124, 513, -520, 330, -148, 41,
+    0, 23, -145, 491, -1221, 2525, -4810, 10818, 27370, -2598, 84, 534, -530, 334, -149, 42,
+    0, 24, -147, 493, -1222, 2519, -4780, 10676, 27440, -2525, 45, 555, -540, 338, -150, 42,
+    0, 25, -149, 496, -1223, 2512, -4749, 10536, 27508, -2452, 4, 577, -550, 342, -151, 42,
+    0, 26, -150, 498, -1224, 2506, -4718, 10395, 27575, -2378, -36, 598, -560, 346, -152, 42,
+    0, 26, -152, 500, -1225, 2499, -4686, 10254, 27642, -2302, -76, 619, -570, 350, -154, 43,
+    0, 27, -154, 503, -1226, 2492, -4655, 10115, 27707, -2226, -117, 640, -580, 354, -155, 43,
+    -1, 28, -155, 505, -1226, 2484, -4622, 9974, 27771, -2149, -158, 662, -590, 358, -156, 43,
+    -1, 28, -157, 507, -1227, 2477, -4590, 9836, 27834, -2071, -199, 683, -599, 361, -157, 43,
+    -1, 29, -158, 509, -1227, 2469, -4557, 9695, 27896, -1993, -240, 704, -609, 365, -158, 44,
+    -1, 30, -160, 511, -1227, 2460, -4523, 9556, 27956, -1913, -282, 726, -619, 369, -159, 44,
+    -1, 30, -161, 513, -1227, 2452, -4489, 9416, 28016, -1833, -323, 747, -629, 373, -160, 44,
+    -1, 31, -163, 514, -1226, 2443, -4455, 9281, 28074, -1752, -365, 768, -639, 376, -162, 44,
+    -1, 32, -164, 516, -1226, 2434, -4420, 9138, 28132, -1670, -407, 790, -648, 380, -163, 45,
+    -2, 32, -165, 518, -1225, 2425, -4386, 9001, 28188, -1587, -449, 811, -658, 384, -164, 45,
+    -2, 33, -167, 519, -1225, 2415, -4350, 8865, 28243, -1503, -492, 833, -668, 387, -165, 45,
+    -2, 33, -168, 521, -1224, 2405, -4315, 8727, 28297, -1419, -534, 854, -677, 391, -166, 45,
+    -2, 34, -169, 522, -1223, 2395, -4279, 8589, 28350, -1333, -577, 875, -687, 395, -167, 45,
+    -2, 34, -170, 523, -1221, 2385, -4242, 8451, 28401, -1247, -620, 897, -697, 398, -168, 46,
+    -2, 35, -171, 524, -1220, 2374, -4206, 8314, 28452, -1160, -663, 918, -706, 402, -169, 46,
+    -2, 36, -173, 526, -1219, 2363, -4169, 8179, 28501, -1073, -706, 940, -716, 405, -170, 46,
+    -2, 36, -174, 527, -1217, 2352, -4131, 8041, 28549, -984, -749, 961, -725, 409, -171, 46,
+    -2, 37, -175, 528, -1215, 2341, -4094, 7907, 28596, -895, -793, 982, -735, 412, -172, 46,
+    -3, 37, -176, 529, -1213, 2329, -4056, 7770, 28642, -804, -836, 1004, -744, 415, -173, 47,
+    -3, 38, -177, 529, -1211, 2317, -4018, 7635, 28686, -713, -880, 1025, -753, 419, -173, 47,
+    -3, 38, -178, 530, -1209, 2305, -3979, 7501, 28730, -621, -924, 1046, -763, 422, -174, 47,
+    -3, 39, -179, 531, -1206, 2293, -3940, 7365, 28772, -529, -968, 1068, -772, 425, -175, 47,
+    -3, 39, -180, 531, -1204, 2280, -3901, 7232, 28813, -435, -1012, 1089, -781, 429, -176, 47,
+    -3, 39, -180, 532, -1201, 2268, -3862, 7097, 28853, -341, -1056, 1110, -790, 432, -177, 47,
+    -3, 40, -181, 532, -1198, 2255, -3822, 6963, 28892, -246, -1100, 1131, -799, 435, -178, 47,
+    -3, 40, -182, 533, -1195, 2241, -3782, 6831, 28929, -151, -1145, 1152, -808, 438, -178, 48,
+    -3, 41, -183, 533, -1192, 2228, -3742, 6697, 28965, -54, -1189, 1174, -817, 441, -179, 48,
+    -3, 41, -184, 533, -1189, 2214, -3702, 6568, 29000, 43, -1234, 1195, -826, 444, -180, 48,
+    -3, 41, -184, 533, -1185, 2200, -3661, 6435, 29034, 141, -1278, 1216, -835, 447, -181, 48,
+    -3, 42, -185, 533, -1182, 2186, -3620, 6303, 29067, 240, -1323, 1237, -844, 450, -181, 48,
+    -4, 42, -186, 533, -1178, 2172, -3579, 6173, 29098, 340, -1368, 1258, -852, 453, -182, 48,
+    -4, 43, -186, 533, -1174, 2157, -3538, 6042, 29129, 440, -1412, 1278, -861, 456, -183, 48,
+    -4, 43, -187, 533, -1171, 2143, -3496, 5912, 29158, 541, -1457, 1299, -870, 459, -183, 48,
+    -4, 43, -187, 533, -1166, 2128, -3455, 5782, 29185, 643, -1502, 1320, -878, 462, -184, 48,
+    -4, 44, -188, 533, -1162, 2113, -3413, 5652, 29212, 746, -1547, 1341, -887, 465, -185, 48,
+    -4, 44, -188, 532, -1158, 2097, -3371, 5525, 29237, 849, -1592, 1361, -895, 467, -185, 49,
+    -4, 44, -189, 532, -1154, 2082, -3328, 5397, 29262, 953, -1638, 1382, -904, 470, -186, 49,
+    -4, 45, -189, 531, -1149, 2066, -3286, 5269, 29284, 1058, -1683, 1402, -912, 473, -186, 49,
+    -4, 45, -190, 531, -1144, 2050, -3243, 5141, 29306, 1164, -1728, 1423, -920, 475, -187, 49,
+    -4, 45, -190, 530, -1139, 2034, -3200, 5013, 29327, 1270, -1773, 1443, -928, 478, -187, 49,
+    -4, 45, -191, 530, -1134, 2018, -3157, 4888, 29346, 1377, -1818, 1463, -936, 480, -188, 49,
+    -4, 46, -191, 529, -1129, 2002, -3114, 4761, 29364, 1484, -1864, 1484, -944, 483, -188, 49,
+    -4, 46, -191, 528, -1124, 1985, -3071, 4637, 29381, 1593, -1909, 1504, -952, 485, -189, 49,
+    -4, 46, -191, 527, -1119, 1968, -3027, 4513, 29396, 1702, -1954, 1524, -960, 487, -189, 49,
+    -4, 46, -192, 526, -1113, 1952, -2983, 4388, 29410, 1812, -1999, 1544, -968, 490, -190, 49,
+    -4, 46, -192, 525, -1108, 1934, -2940, 4268, 29423, 1922, -2045, 1563, -975, 492, -190, 49,
+    -4, 47, -192, 524, -1102, 1917, -2896, 4143, 29435, 2033, -2090, 1583, -983, 494, -190, 49,
+    -4, 47, -192, 523, -1097, 1900, -2852, 4020, 29446, 2145, -2135, 1603, -990, 496, -191, 49,
+    -4, 47, -192, 522, -1091, 1882, -2808, 3900, 29455, 2257, -2180, 1622, -998, 498, -191, 49,
+    -4, 47, -192, 520, -1085, 1865, -2763, 3777, 29463, 2371, -2226, 1642, -1005, 500, -191, 49,
+    -4, 47, -192, 519, -1079, 1847, -2719, 3658, 29470, 2484, -2271, 1661, -1012, 502, -191, 48,
+    -4, 48, -192, 518, -1072, 1829, -2674, 3535, 29476, 2599, -2316, 1680, -1019, 504, -192, 48,
+    -4, 48, -192, 516, -1066, 1811, -2630, 3417, 29480, 2714, -2361, 1699, -1026, 506, -192, 48,
+    -5, 48, -192, 515, -1060, 1792, -2585, 3299, 29483, 2830, -2406, 1718, -1033, 508, -192, 48,
+    -5, 48, -192, 513, -1053, 1774, -2540, 3180, 29485, 2946, -2451, 1737, -1040, 510, -192, 48
+};
+
+
+struct resampler_tier {
+    const int16_t   *table;
+    uint32_t        taps;
+    uint32_t        phase_shift;
+};
+
+static const struct resampler_tier resampler_tiers[] = {
+    [RESAMPLER_QUALITY_LOW] = { resampler_table_low, 2, 24 - 6 },
+    [RESAMPLER_QUALITY_MEDIUM] = { resampler_table_medium, 8, 24 - 7 },
+    [RESAMPLER_QUALITY_HIGH] = { resampler_table_high, 16, 24 - 8 }
+};
+
+int32_t resampler_init(struct resampler * const rs, uint32_t in_rate, uint32_t out_rate,
+    enum resampler_quality quality)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (rs == NULL || in_rate == 0 || out_rate == 0 || quality > RESAMPLER_QUALITY_HIGH) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    uint64_t step = ((uint64_t)in_rate << 24) / out_rate;
+    if (step == 0 || step > RESAMPLER_MAX_STEP) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    rs->table = resampler_tiers[quality].table;
+    rs->taps = resampler_tiers[quality].taps;
+    rs->phase_shift = resampler_tiers[quality].phase_shift;
+    rs->step = (uint32_t)step;
+    // Half a phase ahead, so frac >> phase_shift rounds to the nearest phase. Past the last phase
+    // this brings in the next input and picks its phase 0
+    rs->frac = RESAMPLER_ONE + (1UL << (rs->phase_shift - 1));
+    rs->pos = 0;
+    for (uint32_t i = 0; i < 2 * RESAMPLER_MAX_TAPS; i++) {
+        rs->history[0][i] = 0;
+        rs->history[1][i] = 0;
+    }
+
+    exit:
+    return ret;
+}
+
+int32_t resampler_set_step(struct resampler * const rs, uint32_t step)
+{
+    if (step == 0 || step > RESAMPLER_MAX_STEP) return E_INVALID_PARAMETER;
+    rs->step = step;
+
+    return E_SUCCESS;
+}
+
+int32_t resampler_process(struct resampler * const rs, const int16_t *in, uint32_t in_frames,
+    uint32_t * const consumed, int16_t *out, uint32_t out_frames)
+{
+    uint32_t taps = rs->taps;
+    uint32_t frac = rs->frac;
+    uint32_t pos = rs->pos;
+    uint32_t i = 0, o = 0;
+
+    while (o < out_frames) {
+        // Bring in the inputs the next output needs
+        while (frac >= RESAMPLER_ONE && i < in_frames) {
+            // Every sample is stored twice so the window is always contiguous
+            rs->history[0][pos] = rs->history[0][pos + taps] = in[2 * i];
+            rs->history[1][pos] = rs->history[1][pos + taps] = in[2 * i + 1];
+            if (++pos == taps) pos = 0;
+            frac -= RESAMPLER_ONE;
+            i++;
+        }
+        if (frac >= RESAMPLER_ONE) break;
+
+        // Window starts at the oldest sample, which is the next slot to be written
+        const int16_t *coeffs = &rs->table[(frac >> rs->phase_shift) * taps];
+        out[2 * o] = dsp_dot_q15(&rs->history[0][pos], coeffs, taps);
+        out[2 * o + 1] = dsp_dot_q15(&rs->history[1][pos], coeffs, taps);
+        frac += rs->step;
+        o++;
+    }
+
+    rs->frac = frac;
+    rs->pos = pos;
+    if (consumed != NULL) *consumed = i;
+
+    return o;
+}
@@ -0,0 +1,236 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/capture.h"
+
+#include "include/errors.h"
+#include "include/stm32f4xx/dma.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_bus.h"
+#include "stm32f4xx_ll_dma.h"
+#include "stm32f4xx_ll_gpio.h"
+#include "stm32f4xx_ll_tim.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Only DMA2 reaches the GPIO ports, and TIM1_CH3 is on stream 6 channel 6. The update event is
+// not used because it cannot follow every edge of an external clock
+#define CAPTURE_TIM         TIM1
+#define CAPTURE_CHANNEL     LL_TIM_CHANNEL_CH3
+#define CAPTURE_CLOCK_PORT  GPIOE
+#define CAPTURE_CLOCK_PIN   LL_GPIO_PIN_13
+#define CAPTURE_MAX_SAMPLES 0xfffe
+
+struct capture_state {
+    uint8_t             *buffer;
+    uint32_t            half;       // Bytes in half of the buffer
+    uint32_t            samples;
+    uint32_t            sample_size;
+    capture_callback    callback;
+    void                *arg;
+    volatile uint32_t   running;
+    volatile uint32_t   overruns;
+};
+
+static const struct dma_stream capture_dma = {
+    .dma = DMA2,
+    .stream = LL_DMA_STREAM_6,
+    .channel = LL_DMA_CHANNEL_6,
+    .irqn = DMA2_Stream6_IRQn,
+};
+
+static struct capture_state capture;
+
+static void capture_halt(void)
+{
+    LL_TIM_DisableCounter(CAPTURE_TIM);
+    LL_TIM_DisableDMAReq_CC3(CAPTURE_TIM);
+    LL_TIM_CC_DisableChannel(CAPTURE_TIM, CAPTURE_CHANNEL);
+    dma_stop_stream(capture_dma.dma, capture_dma.stream, DMA_STOP_TIMEOUT);
+    dma_clear_handler(&capture_dma);
+}
+
+/**
+ * @brief Gives the engine and its claim of DMA2 back
+ */
+static void capture_release(void)
+{
+    capture.running = 0;
+    dma2_port_release(DMA2_PORT_AHB);
+}
+
+static void capture_dma_handler(void *arg, uint32_t flags)
+{
+    (void)arg;
+
+    if (flags & DMA_FLAG_ERRORS) {
+        capture_halt();
+        capture_release();
+        return;
+    }
+
+    // Both set means the first half was being overwritten before it could be handed out
+    if ((flags & (DMA_FLAG_HT | DMA_FLAG_TC)) == (DMA_FLAG_HT | DMA_FLAG_TC)) {
+        capture.overruns++;
+        flags &= ~DMA_FLAG_HT;
+    }
+
+    if (flags & DMA_FLAG_HT) capture.callback(capture.arg, capture.buffer, capture.samples / 2);
+    if (flags & DMA_FLAG_TC) capture.callback(capture.arg, capture.buffer + capture.half, capture.samples / 2);
+}
+
+static void capture_gpio_init(const struct capture_config * const config)
+{
+    LL_GPIO_InitTypeDef gpio = {
+        .Pin = config->width == CAPTURE_WIDTH_8 ? 0xffUL << config->first_pin : 0xffffUL,
+        .Mode = LL_GPIO_MODE_INPUT,
+        .Pull = LL_GPIO_PULL_NO,
+    };
+
+    LL_AHB1_GRP1_EnableClock(config->ahb1_grp1_periph);
+    LL_GPIO_Init(config->port, &gpio);
+
+    if (config->clock != CAPTURE_CLOCK_TIMER) {
+        LL_GPIO_InitTypeDef clock = {
+            .Pin = CAPTURE_CLOCK_PIN,
+            .Mode = LL_GPIO_MODE_ALTERNATE,
+            .Speed = LL_GPIO_SPEED_FREQ_VERY_HIGH,
+            .Pull = LL_GPIO_PULL_NO,
+            .Alternate = LL_GPIO_AF_1,
+        };
+
+        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOE);
+        LL_GPIO_Init(CAPTURE_CLOCK_PORT, &clock);
+    }
+}
+
+static void capture_timer_init(const struct capture_config * const config)
+{
+    LL_TIM_DisableCounter(CAPTURE_TIM);
+    LL_TIM_DisableDMAReq_CC3(CAPTURE_TIM);
+    LL_TIM_CC_DisableChannel(CAPTURE_TIM, CAPTURE_CHANNEL);
+
+    if (config->clock == CAPTURE_CLOCK_TIMER) {
+        // Compare match at 0 once per period, with no effect on the pin
+        uint32_t prescaler = (config->period - 1) >> 16;
+        LL_TIM_SetPrescaler(CAPTURE_TIM, prescaler);
+        LL_TIM_SetAutoReload(CAPTURE_TIM, config->period / (prescaler + 1) - 1);
+        LL_TIM_OC_SetMode(CAPTURE_TIM, CAPTURE_CHANNEL, LL_TIM_OCMODE_FROZEN);
+        LL_TIM_OC_SetCompareCH3(CAPTURE_TIM, 0);
+    } else {
+        LL_TIM_SetPrescaler(CAPTURE_TIM, 0);
+        LL_TIM_SetAutoReload(CAPTURE_TIM, 0xffff);
+        LL_TIM_IC_Config(CAPTURE_TIM, CAPTURE_CHANNEL, LL_TIM_ACTIVEINPUT_DIRECTTI | LL_TIM_ICPSC_DIV1 |
+            LL_TIM_IC_FILTER_FDIV1 | (config->clock == CAPTURE_CLOCK_RISING ? LL_TIM_IC_POLARITY_RISING :
+            LL_TIM_IC_POLARITY_FALLING));
+        LL_TIM_CC_EnableChannel(CAPTURE_TIM, CAPTURE_CHANNEL);
+    }
+
+    LL_TIM_SetCounter(CAPTURE_TIM, 0);
+    LL_TIM_GenerateEvent_UPDATE(CAPTURE_TIM);
+    LL_TIM_ClearFlag_UPDATE(CAPTURE_TIM);
+    LL_TIM_ClearFlag_CC3(CAPTURE_TIM);
+}
+
+static void capture_dma_init(const struct capture_config * const config, void *buffer, uint32_t samples)
+{
+    uint32_t align = config->width == CAPTURE_WIDTH_8 ? LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE :
+        LL_DMA_PDATAALIGN_HALFWORD | LL_DMA_MDATAALIGN_HALFWORD;
+    // Upper byte of IDR is one address above, the bus is little endian
+    uint32_t idr = (uint32_t)&config->port->IDR + (config->first_pin == 8 ? 1 : 0);
+
+    LL_DMA_SetChannelSelection(capture_dma.dma, capture_dma.stream, capture_dma.channel);
+    LL_DMA_ConfigTransfer(capture_dma.dma, capture_dma.stream, LL_DMA_DIRECTION_PERIPH_TO_MEMORY |
+        LL_DMA_MODE_CIRCULAR | LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT | align |
+        LL_DMA_PRIORITY_VERYHIGH);
+    LL_DMA_DisableFifoMode(capture_dma.dma, capture_dma.stream);
+    LL_DMA_ConfigAddresses(capture_dma.dma, capture_dma.stream, idr, (uint32_t)buffer,
+        LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+    LL_DMA_SetDataLength(capture_dma.dma, capture_dma.stream, samples);
+    LL_DMA_EnableIT_HT(capture_dma.dma, capture_dma.stream);
+    LL_DMA_EnableIT_TC(capture_dma.dma, capture_dma.stream);
+    LL_DMA_EnableIT_TE(capture_dma.dma, capture_dma.stream);
+    LL_DMA_EnableIT_DME(capture_dma.dma, capture_dma.stream);
+}
+
+int32_t capture_start(const struct capture_config * const config, void *buffer, uint32_t samples,
+    capture_callback callback, void *arg)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (config == NULL || config->port == NULL || buffer == NULL || callback == NULL ||
+        samples == 0 || samples > CAPTURE_MAX_SAMPLES || (samples & 0x01) ||
+        config->width > CAPTURE_WIDTH_16 || config->clock > CAPTURE_CLOCK_FALLING ||
+        (config->clock == CAPTURE_CLOCK_TIMER && config->period < 2) ||
+        (config->first_pin != 0 && (config->first_pin != 8 || config->width != CAPTURE_WIDTH_8))) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    taskENTER_CRITICAL();
+    // DMA2 must not be serving SPI1 at the same time, see dma2_port
+    if (capture.running) ret = E_DEVICE_BUSY;
+    else                 ret = dma2_port_acquire(DMA2_PORT_AHB);
+    if (ret == E_SUCCESS) capture.running = 1;
+    taskEXIT_CRITICAL();
+    if (ret != E_SUCCESS) goto exit;
+
+    // Claims the stream before anything is touched
+    if ((ret = dma_set_handler(&capture_dma, capture_dma_handler, NULL)) != E_SUCCESS) {
+        capture_release();
+        goto exit;
+    }
+
+    capture.buffer = buffer;
+    capture.samples = samples;
+    capture.sample_size = config->width == CAPTURE_WIDTH_8 ? 1 : 2;
+    capture.half = samples / 2 * capture.sample_size;
+    capture.callback = callback;
+    capture.arg = arg;
+    capture.overruns = 0;
+
+    LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM1);
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+    capture_gpio_init(config);
+    capture_timer_init(config);
+    capture_dma_init(config, buffer, samples);
+
+    LL_DMA_EnableStream(capture_dma.dma, capture_dma.stream);
+    LL_TIM_EnableDMAReq_CC3(CAPTURE_TIM);
+    LL_TIM_EnableCounter(CAPTURE_TIM);
+
+    exit:
+    return ret;
+}
+
+void capture_stop(void)
+{
+    taskENTER_CRITICAL();
+    if (capture.running) {
+        capture_halt();
+        capture_release();
+    }
+    taskEXIT_CRITICAL();
+}
+
+uint32_t capture_position(void)
+{
+    if (!capture.running) return 0;
+    return capture.samples - LL_DMA_GetDataLength(capture_dma.dma, capture_dma.stream);
+}
+
+uint32_t capture_overruns(void)
+{
+    return capture.overruns;
+}
@@ -9,6 +9,8 @@
 #include "include/device/cpu.h"
 
 #include "include/errors.h"
+#include "include/stm32f4xx/cpu.h"
+#include "include/stm32f4xx/rtc.h"
 #include "ulibc/include/utils.h"
 
 #include "stm32f4xx.h"
@@ -38,7 +40,7 @@ static int32_t stm32f4xx_get_uuid(const struct cpu * const cpu, void * const uui
 
 static int32_t stm32f4xx_get_rtc_timestamp(const struct cpu * const cpu, uint32_t * const timestamp)
 {
-    return E_UNIMPEMENTED;
+    return rtc_get_timestamp(timestamp, NULL);
 }
 
 static int32_t stm32f4xx_get_clock_in_hz(const struct cpu * const cpu, uint32_t * const clock)
@@ -58,4 +60,71 @@ const struct cpu stm32f4xx_cpu = {
     .get_rtc_timestamp = stm32f4xx_get_rtc_timestamp,
     .get_clock_in_hz = stm32f4xx_get_clock_in_hz,
     .reset = stm32f4xx_reset
-};
\ No newline at end of file
+};
+
+struct cpu_prof_slot cpu_prof_table[CPU_PROF_SLOTS];
+
+int32_t stm32f4xx_cpu_prof_get(uint32_t id, struct cpu_prof_stats * const stats)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (id >= CPU_PROF_SLOTS || stats == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    // Same masking as stm32f4xx_cpu_prof_end, so a copy is never torn
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    struct cpu_prof_slot slot = cpu_prof_table[id];
+    __set_PRIMASK(primask);
+
+    stats->count = slot.count;
+    stats->min = slot.min;
+    stats->max = slot.max;
+    stats->total = slot.total;
+    stats->mean = slot.count ? (uint32_t)(slot.total / slot.count) : 0;
+
+    exit:
+    return ret;
+}
+
+int32_t stm32f4xx_cpu_prof_reset(uint32_t id)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (id >= CPU_PROF_SLOTS) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    cpu_prof_table[id].count = 0;
+    cpu_prof_table[id].min = 0;
+    cpu_prof_table[id].max = 0;
+    cpu_prof_table[id].total = 0;
+    __set_PRIMASK(primask);
+
+    exit:
+    return ret;
+}
+
+int32_t stm32f4xx_cpu_prof_dump(cpu_prof_dump_callback callback, void *arg)
+{
+    struct cpu_prof_stats stats;
+    int32_t ret = E_SUCCESS;
+
+    if (callback == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    for (uint32_t id = 0; id < CPU_PROF_SLOTS; id++) {
+        stm32f4xx_cpu_prof_get(id, &stats);
+        if (stats.count != 0) callback(arg, id, &stats);
+    }
+
+    exit:
+    return ret;
+}
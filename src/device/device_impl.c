@@ -12,37 +12,347 @@
 #include "include/device/usart.h"
 #include "include/device/i2c.h"
 #include "include/device/cpu.h"
+#include "include/errors.h"
+#include "include/stm32f4xx/device.h"
+#include "include/stm32f4xx/errors.h"
+#include "include/stm32f4xx/i2s.h"
+#include "include/stm32f4xx/spi.h"
+#include "include/stm32f4xx/spi_nor.h"
 
 #include "ulibc/include/utils.h"
 
 #include <string.h>
+#include <stddef.h>
 
-extern const struct usart_device usart2;
-extern const struct gpio_device led_gpio;
-extern const struct i2c_device i2c1;
-extern const struct i2s_device i2s2;
-extern const struct i2s_device i2s3;
-extern const struct cpu stm32f4xx_cpu;
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_bus.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+// Open addressing hash table. Must be a power of two, at least twice DEVICE_COUNT
+#define DEVICE_HASH_SLOTS   32
+
+#define DEVICE_EXTERN(id_, name_, type_, object_, init_)    extern const struct type_ object_;
+#define DEVICE_ENTRY(id_, name_, type_, object_, init_)     [DEVICE_ID_##id_] = {&object_, device_init_##id_},
+#define DEVICE_DESCRIPTOR(id_, name_, type_, object_, init_) \
+    [DEVICE_ID_##id_] = {DEVICE_ID_##id_, name_, DEVICE_INFO_##id_},
+#define DEVICE_INIT(id_, name_, type_, object_, init_)      \
+    static int32_t device_init_##id_(void) { return init_(&object_); }
+
+// Class, instance, capabilities and maximum speed of each device
+#define DEVICE_INFO_CPU         DEVICE_CLASS_CPU, 0, 0, 168000000
+#define DEVICE_INFO_USART2      DEVICE_CLASS_USART, 2, DEVICE_CAP_IRQ | DEVICE_CAP_FULL_DUPLEX, 2625000
+#define DEVICE_INFO_LED         DEVICE_CLASS_GPIO, 0, 0, 2000000
+#define DEVICE_INFO_I2C1        DEVICE_CLASS_I2C, 1, 0, 400000
+#define DEVICE_INFO_I2S2        DEVICE_CLASS_I2S, 2, DEVICE_CAP_DMA | DEVICE_CAP_IRQ | DEVICE_CAP_FULL_DUPLEX, 12288000
+#define DEVICE_INFO_I2S3        DEVICE_CLASS_I2S, 3, DEVICE_CAP_DMA | DEVICE_CAP_IRQ | DEVICE_CAP_FULL_DUPLEX, 12288000
+#define DEVICE_INFO_SPI1        DEVICE_CLASS_SPI, 1, DEVICE_CAP_DMA | DEVICE_CAP_FULL_DUPLEX | DEVICE_CAP_CRC, 42000000
+#define DEVICE_INFO_SPI2_SLAVE  DEVICE_CLASS_SPI, 2, DEVICE_CAP_DMA | DEVICE_CAP_SLAVE, 21000000
+#define DEVICE_INFO_SPI_NOR1    DEVICE_CLASS_SPI_NOR, 1, DEVICE_CAP_DMA, 42000000
+
+STM32F4XX_DEVICES(DEVICE_EXTERN)
+STM32F4XX_DEVICES(DEVICE_INIT)
 
 struct device_tree {
-    const char *name;
-    const void *device;
+    const void  *device;
+    int32_t     (*init)(void);
+};
+
+static const struct device_tree tree[DEVICE_COUNT] = {
+    STM32F4XX_DEVICES(DEVICE_ENTRY)
+};
+
+static const struct device_descriptor descriptors[DEVICE_COUNT] = {
+    STM32F4XX_DEVICES(DEVICE_DESCRIPTOR)
+};
+
+enum device_bus {
+    DEVICE_BUS_NONE,    // Clock is shared or always on, never gated
+    DEVICE_BUS_APB1,
+    DEVICE_BUS_APB2,
+};
+
+struct device_power {
+    enum device_bus bus;
+    uint32_t        clock;      // LL_APBx_GRP1_PERIPH_x
+    uint32_t        parent;     // Device it is built on, DEVICE_COUNT if none
 };
 
-static const struct device_tree tree[6] = {
-    {DEFAULT_CPU,   &stm32f4xx_cpu},
-    {DEFAULT_USART, &usart2},
-    {DEFAULT_LED,   &led_gpio},
-    {"i2c1",        &i2c1},
-    {"i2s2",        &i2s2},
-    {"i2s3",        &i2s3}
+// GPIO ports, DMAs and the CPU are shared with code outside the registry, so they are never gated
+static const struct device_power power[DEVICE_COUNT] = {
+    [DEVICE_ID_CPU] = {DEVICE_BUS_NONE, 0, DEVICE_COUNT},
+    [DEVICE_ID_USART2] = {DEVICE_BUS_APB1, LL_APB1_GRP1_PERIPH_USART2, DEVICE_COUNT},
+    [DEVICE_ID_LED] = {DEVICE_BUS_NONE, 0, DEVICE_COUNT},
+    [DEVICE_ID_I2C1] = {DEVICE_BUS_APB1, LL_APB1_GRP1_PERIPH_I2C1, DEVICE_COUNT},
+    [DEVICE_ID_I2S2] = {DEVICE_BUS_APB1, LL_APB1_GRP1_PERIPH_SPI2, DEVICE_COUNT},
+    [DEVICE_ID_I2S3] = {DEVICE_BUS_APB1, LL_APB1_GRP1_PERIPH_SPI3, DEVICE_COUNT},
+    [DEVICE_ID_SPI1] = {DEVICE_BUS_APB2, LL_APB2_GRP1_PERIPH_SPI1, DEVICE_COUNT},
+    [DEVICE_ID_SPI2_SLAVE] = {DEVICE_BUS_APB1, LL_APB1_GRP1_PERIPH_SPI2, DEVICE_COUNT},
+    [DEVICE_ID_SPI_NOR1] = {DEVICE_BUS_NONE, 0, DEVICE_ID_SPI1},
 };
 
+typedef char device_hash_slots_check[DEVICE_HASH_SLOTS >= 2 * DEVICE_COUNT ? 1 : -1];
+
+struct device_hash_index {
+    uint32_t            hashes[DEVICE_COUNT];
+    uint8_t             slots[DEVICE_HASH_SLOTS];   // ID + 1, 0 if empty
+    volatile uint32_t   ready;
+};
+
+struct device_state {
+    volatile uint8_t    initialized;
+    volatile uint8_t    clocked;
+    uint16_t            refs;       // Taken by device_open
+};
+
+static struct device_hash_index hash_index;
+static struct device_state state[DEVICE_COUNT];
+static SemaphoreHandle_t lock;
+
+static void device_index_build(void)
+{
+    taskENTER_CRITICAL();
+    if (!hash_index.ready) {
+        for (uint32_t id = 0; id < DEVICE_COUNT; id++) {
+            uint32_t slot = hash_index.hashes[id] = device_hash(descriptors[id].name);
+            for (uint32_t entry; (entry = hash_index.slots[slot & (DEVICE_HASH_SLOTS - 1)]) != 0; slot++) {
+                // Two names with the same hash: the second device could never be found
+                configASSERT(hash_index.hashes[entry - 1] != hash_index.hashes[id]);
+            }
+            hash_index.slots[slot & (DEVICE_HASH_SLOTS - 1)] = id + 1;
+        }
+        __DMB(); // Table must be complete before it is used
+        hash_index.ready = 1;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Finds the ID whose name has hash, DEVICE_COUNT if none
+ */
+static uint32_t device_find(uint32_t hash)
+{
+    if (!hash_index.ready) device_index_build();
+
+    // Table is never full, so an empty slot always ends the probe
+    for (uint32_t slot = hash; ; slot++) {
+        uint32_t entry = hash_index.slots[slot & (DEVICE_HASH_SLOTS - 1)];
+        if (entry == 0) return DEVICE_COUNT;
+        if (hash_index.hashes[entry - 1] == hash) return entry - 1;
+    }
+}
+
+/**
+ * @brief Takes the registry lock, creating it on first use
+ */
+static int32_t device_lock(void)
+{
+    if (lock == NULL) {
+        SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) return E_HARDWARE_CONFIG_FAILED;
+
+        taskENTER_CRITICAL();
+        if (lock == NULL) {
+            lock = mutex;
+            mutex = NULL;
+        }
+        taskEXIT_CRITICAL();
+
+        // Someone else created it meanwhile
+        if (mutex != NULL) vSemaphoreDelete(mutex);
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    return E_SUCCESS;
+}
+
+static void device_unlock(void)
+{
+    xSemaphoreGive(lock);
+}
+
+static void device_clock(uint32_t id, uint32_t enable)
+{
+    const struct device_power *p = &power[id];
+
+    switch (p->bus) {
+    case DEVICE_BUS_APB1:
+        if (enable) LL_APB1_GRP1_EnableClock(p->clock);
+        else        LL_APB1_GRP1_DisableClock(p->clock);
+        break;
+
+    case DEVICE_BUS_APB2:
+        if (enable) LL_APB2_GRP1_EnableClock(p->clock);
+        else        LL_APB2_GRP1_DisableClock(p->clock);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static uint32_t device_shares_peripheral(uint32_t id, uint32_t other)
+{
+    return other != id && power[id].bus != DEVICE_BUS_NONE && power[other].bus == power[id].bus &&
+        power[other].clock == power[id].clock;
+}
+
+/**
+ * @brief Takes the peripheral of id from the devices it shares it with (i2s2 and spi2_slave). Only
+ * one of them can drive it at a time: it is busy while another one is clocked or referenced. Lock
+ * must be held
+ */
+static int32_t device_claim(uint32_t id)
+{
+    for (uint32_t other = 0; other < DEVICE_COUNT; other++) {
+        if (!device_shares_peripheral(id, other) || !state[other].initialized) continue;
+        if (state[other].clocked || state[other].refs != 0) return E_DEVICE_BUSY;
+        // Its setup is about to be overwritten, it will be initialized again if opened later
+        state[other].initialized = 0;
+    }
+
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Initializes id the first time and ungates its clock afterwards. Lock must be held
+ */
+static int32_t device_prepare(uint32_t id)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (power[id].parent != DEVICE_COUNT && (ret = device_prepare(power[id].parent)) != E_SUCCESS) goto exit;
+
+    if (!state[id].initialized) {
+        if ((ret = device_claim(id)) != E_SUCCESS) goto exit;
+        // Initialization turns the clock on
+        if ((ret = tree[id].init()) != E_SUCCESS) goto exit;
+        state[id].clocked = 1;
+        state[id].initialized = 1;
+    } else if (!state[id].clocked) {
+        device_clock(id, 1);
+        state[id].clocked = 1;
+    }
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Drops a reference of id and of what it is built on. Lock must be held
+ */
+static void device_release(uint32_t id)
+{
+    const struct device_power *p = &power[id];
+
+    if (--state[id].refs == 0 && p->bus != DEVICE_BUS_NONE) {
+        uint32_t users = 0;
+
+        // Instances sharing a peripheral (i2s2 and spi2_slave) share its clock
+        for (uint32_t other = 0; other < DEVICE_COUNT; other++) {
+            if (device_shares_peripheral(id, other)) users += state[other].refs;
+        }
+
+        if (users == 0) {
+            device_clock(id, 0);
+            state[id].clocked = 0;
+            for (uint32_t other = 0; other < DEVICE_COUNT; other++) {
+                if (device_shares_peripheral(id, other)) state[other].clocked = 0;
+            }
+        }
+    }
+
+    if (p->parent != DEVICE_COUNT) device_release(p->parent);
+}
+
+static void device_acquire(uint32_t id)
+{
+    state[id].refs++;
+    if (power[id].parent != DEVICE_COUNT) device_acquire(power[id].parent);
+}
+
+/**
+ * @brief The device of id, NULL if there is none. Initialization is left to device_open
+ */
+static const void *device_lookup(uint32_t id)
+{
+    return id < DEVICE_COUNT ? tree[id].device : NULL;
+}
+
 const void *device_get_by_name(const char *dev_name)
 {
-    for(int i = 0; i < ARRAY_SIZE(tree); i++) {
-        if (strcmp(tree[i].name, dev_name) == 0) return tree[i].device;
+    if (dev_name == NULL) return NULL;
+
+    uint32_t id = device_find(device_hash(dev_name));
+    // An unknown name may share the hash of a known one
+    if (id == DEVICE_COUNT || strcmp(descriptors[id].name, dev_name) != 0) return NULL;
+
+    return device_lookup(id);
+}
+
+const void *device_get_by_id(enum device_id id)
+{
+    return device_lookup((uint32_t)id);
+}
+
+const void *device_get_by_hash(uint32_t hash)
+{
+    return device_lookup(device_find(hash));
+}
+
+int32_t device_open(enum device_id id, const void ** const device)
+{
+    int32_t ret;
+
+    if ((uint32_t)id >= DEVICE_COUNT) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = device_lock()) != E_SUCCESS) goto exit;
+    if ((ret = device_prepare(id)) == E_SUCCESS) device_acquire(id);
+    device_unlock();
+
+    if (ret == E_SUCCESS && device != NULL) *device = tree[id].device;
+
+    exit:
+    return ret;
+}
+
+int32_t device_close(enum device_id id)
+{
+    int32_t ret;
+
+    if ((uint32_t)id >= DEVICE_COUNT) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
     }
 
-    return NULL;
-}
\ No newline at end of file
+    if ((ret = device_lock()) != E_SUCCESS) goto exit;
+    if (state[id].refs == 0) ret = E_INVALID_PARAMETER;
+    else                     device_release(id);
+    device_unlock();
+
+    exit:
+    return ret;
+}
+
+const struct device_descriptor *device_describe(enum device_id id)
+{
+    return (uint32_t)id < DEVICE_COUNT ? &descriptors[id] : NULL;
+}
+
+const struct device_descriptor *device_next(const struct device_descriptor *prev)
+{
+    if (prev == NULL) return &descriptors[0];
+    return prev + 1 < &descriptors[DEVICE_COUNT] ? prev + 1 : NULL;
+}
+
+const struct device_descriptor *device_next_of_class(enum device_class class,
+    const struct device_descriptor *prev)
+{
+    while ((prev = device_next(prev)) != NULL && prev->class != class);
+    return prev;
+}
@@ -0,0 +1,116 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/dma.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "include/errors.h"
+#include "include/stm32f4xx/errors.h"
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_dma.h"
+
+#define AVAILABLE_DMAS      2
+#define STREAMS_PER_DMA     8
+
+struct dma_handler_entry {
+    dma_handler handler;
+    void        *arg;
+};
+
+static struct dma_handler_entry handlers[AVAILABLE_DMAS][STREAMS_PER_DMA];
+// Claims of DMA2 per enum dma2_port
+static uint32_t dma2_users[2];
+
+int32_t dma_set_handler(const struct dma_stream * const stream, dma_handler handler, void *arg)
+{
+    struct dma_handler_entry *entry;
+    uint32_t primask;
+    int32_t ret = E_SUCCESS;
+
+    if (stream == NULL || handler == NULL || stream->stream >= STREAMS_PER_DMA) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    entry = &handlers[stream->dma == DMA2][stream->stream];
+    primask = __get_PRIMASK();
+    __disable_irq();
+    // Streams are shared by some peripherals (DMA1 stream 3 serves I2S2ext and SPI2)
+    if (entry->handler != NULL) {
+        ret = E_DEVICE_BUSY;
+    } else {
+        entry->handler = handler;
+        entry->arg = arg;
+    }
+    __set_PRIMASK(primask);
+    if (ret != E_SUCCESS) goto exit;
+
+    NVIC_SetPriority(stream->irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), DMA_IRQ_PRIORITY, 0));
+    NVIC_EnableIRQ(stream->irqn);
+
+    exit:
+    return ret;
+}
+
+void dma_clear_handler(const struct dma_stream * const stream)
+{
+    NVIC_DisableIRQ(stream->irqn);
+    handlers[stream->dma == DMA2][stream->stream].handler = NULL;
+}
+
+int32_t dma2_port_acquire(enum dma2_port port)
+{
+    uint32_t primask = __get_PRIMASK();
+    int32_t ret = E_SUCCESS;
+
+    __disable_irq();
+    if (dma2_users[port == DMA2_PORT_APB2 ? DMA2_PORT_AHB : DMA2_PORT_APB2] != 0) ret = E_DEVICE_BUSY;
+    else                                                                           dma2_users[port]++;
+    __set_PRIMASK(primask);
+
+    return ret;
+}
+
+void dma2_port_release(enum dma2_port port)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (dma2_users[port] != 0) dma2_users[port]--;
+    __set_PRIMASK(primask);
+}
+
+static void dma_irq_handle(DMA_TypeDef *dma, uint32_t stream)
+{
+    const struct dma_handler_entry *entry = &handlers[dma == DMA2][stream];
+    uint32_t flags = dma_get_flags(dma, stream);
+
+    dma_clear_flags(dma, stream, flags);
+    if (entry->handler != NULL) entry->handler(entry->arg, flags);
+}
+
+void DMA1_Stream0_IRQHandler(void) { dma_irq_handle(DMA1, LL_DMA_STREAM_0); }
+void DMA1_Stream1_IRQHandler(void) { dma_irq_handle(DMA1, LL_DMA_STREAM_1); }
+void DMA1_Stream2_IRQHandler(void) { dma_irq_handle(DMA1, LL_DMA_STREAM_2); }
+void DMA1_Stream3_IRQHandler(void) { dma_irq_handle(DMA1, LL_DMA_STREAM_3); }
+void DMA1_Stream4_IRQHandler(void) { dma_irq_handle(DMA1, LL_DMA_STREAM_4); }
+void DMA1_Stream5_IRQHandler(void) { dma_irq_handle(DMA1, LL_DMA_STREAM_5); }
+void DMA1_Stream6_IRQHandler(void) { dma_irq_handle(DMA1, LL_DMA_STREAM_6); }
+void DMA1_Stream7_IRQHandler(void) { dma_irq_handle(DMA1, LL_DMA_STREAM_7); }
+
+void DMA2_Stream0_IRQHandler(void) { dma_irq_handle(DMA2, LL_DMA_STREAM_0); }
+void DMA2_Stream1_IRQHandler(void) { dma_irq_handle(DMA2, LL_DMA_STREAM_1); }
+void DMA2_Stream2_IRQHandler(void) { dma_irq_handle(DMA2, LL_DMA_STREAM_2); }
+void DMA2_Stream3_IRQHandler(void) { dma_irq_handle(DMA2, LL_DMA_STREAM_3); }
+void DMA2_Stream4_IRQHandler(void) { dma_irq_handle(DMA2, LL_DMA_STREAM_4); }
+void DMA2_Stream5_IRQHandler(void) { dma_irq_handle(DMA2, LL_DMA_STREAM_5); }
+void DMA2_Stream6_IRQHandler(void) { dma_irq_handle(DMA2, LL_DMA_STREAM_6); }
+void DMA2_Stream7_IRQHandler(void) { dma_irq_handle(DMA2, LL_DMA_STREAM_7); }
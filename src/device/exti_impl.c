@@ -0,0 +1,305 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/exti.h"
+
+#include "include/errors.h"
+#include "include/stm32f4xx/timebase.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_gpio.h"
+#include "stm32f4xx_ll_bus.h"
+#include "stm32f4xx_ll_exti.h"
+#include "stm32f4xx_ll_system.h"
+#include "stm32f4xx_ll_tim.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#define EXTI_LINES      16
+
+// Ticks at 1 kHz while some line is being debounced
+#define DEBOUNCE_TIM    TIM7
+
+struct exti_line_state {
+    const struct exti_input *input;
+    volatile uint32_t       debounce;   // Ticks left before the pin is sampled, 0 if idle
+    uint32_t                timestamp;  // Time of the edge being debounced
+    uint32_t                level;      // Last stable level
+};
+
+struct exti_state {
+    struct exti_line_state  lines[EXTI_LINES];
+    struct exti_event       queue[EXTI_EVENT_QUEUE_LEN];
+    volatile uint32_t       head;       // Only written from interrupts
+    volatile uint32_t       tail;       // Only written by readers
+    volatile uint32_t       overflows;
+    SemaphoreHandle_t       events;     // Counts events in queue
+};
+
+static struct exti_state exti;
+
+static const IRQn_Type exti_irqn[EXTI_LINES] = {
+    EXTI0_IRQn, EXTI1_IRQn, EXTI2_IRQn, EXTI3_IRQn, EXTI4_IRQn,
+    EXTI9_5_IRQn, EXTI9_5_IRQn, EXTI9_5_IRQn, EXTI9_5_IRQn, EXTI9_5_IRQn,
+    EXTI15_10_IRQn, EXTI15_10_IRQn, EXTI15_10_IRQn, EXTI15_10_IRQn, EXTI15_10_IRQn, EXTI15_10_IRQn
+};
+
+static int32_t exti_init(void)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (exti.events == NULL) exti.events = xSemaphoreCreateCounting(EXTI_EVENT_QUEUE_LEN, 0);
+
+    if (exti.events == NULL) {
+        ret = E_HARDWARE_CONFIG_FAILED;
+        goto exit;
+    }
+
+    timebase_init();
+    LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_SYSCFG);
+
+    if (LL_APB1_GRP1_IsEnabledClock(LL_APB1_GRP1_PERIPH_TIM7) == 0) {
+        LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM7);
+        LL_TIM_SetPrescaler(DEBOUNCE_TIM, (SystemCoreClock / 2 / 1000000) - 1);
+        LL_TIM_SetAutoReload(DEBOUNCE_TIM, 1000 - 1);
+        LL_TIM_GenerateEvent_UPDATE(DEBOUNCE_TIM);
+        LL_TIM_ClearFlag_UPDATE(DEBOUNCE_TIM);
+        LL_TIM_EnableIT_UPDATE(DEBOUNCE_TIM);
+        NVIC_SetPriority(TIM7_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), EXTI_IRQ_PRIORITY, 0));
+        NVIC_EnableIRQ(TIM7_IRQn);
+    }
+
+    exit:
+    return ret;
+}
+
+static void exti_push(uint32_t line, uint32_t level, uint32_t timestamp, BaseType_t *context_switch)
+{
+    uint32_t head = exti.head;
+
+    if (head - exti.tail == EXTI_EVENT_QUEUE_LEN) {
+        exti.overflows++;
+        return;
+    }
+
+    struct exti_event *event = &exti.queue[head & (EXTI_EVENT_QUEUE_LEN - 1)];
+    event->timestamp = timestamp;
+    event->line = line;
+    event->level = level;
+    __DMB(); // Event must be complete before it is published
+    exti.head = head + 1;
+
+    xSemaphoreGiveFromISR(exti.events, context_switch);
+}
+
+static uint32_t exti_level(const struct exti_input * const input)
+{
+    return LL_GPIO_IsInputPinSet(input->port, 1UL << input->pin);
+}
+
+/**
+ * @brief Tells if level is where the configured edge leads to
+ */
+static int exti_edge_matches(const struct exti_line_state * const state, uint32_t level)
+{
+    switch (state->input->edge) {
+    case EXTI_EDGE_RISING:  return level == 1;
+    case EXTI_EDGE_FALLING: return level == 0;
+    default:                return level != state->level;
+    }
+}
+
+int32_t exti_input_enable(const struct exti_input * const input)
+{
+    int32_t ret;
+
+    if (input == NULL || input->port == NULL || input->pin >= EXTI_LINES || input->edge > EXTI_EDGE_BOTH) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = exti_init()) != E_SUCCESS) goto exit;
+
+    struct exti_line_state *state = &exti.lines[input->pin];
+    uint32_t line = 1UL << input->pin;
+
+    taskENTER_CRITICAL();
+    if (state->input != NULL) ret = E_DEVICE_BUSY;
+    else                      state->input = input;
+    taskEXIT_CRITICAL();
+    if (ret != E_SUCCESS) goto exit;
+
+    const LL_GPIO_InitTypeDef gpio = {
+        .Pin = line,
+        .Mode = LL_GPIO_MODE_INPUT,
+        .Pull = input->pull,
+    };
+
+    LL_AHB1_GRP1_EnableClock(input->ahb1_grp1_periph);
+    LL_GPIO_Init(input->port, (LL_GPIO_InitTypeDef *)&gpio);
+
+    // Ports are 0x400 apart, in the same order as LL_SYSCFG_EXTI_PORTx
+    uint32_t port = ((uint32_t)input->port - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE);
+    LL_SYSCFG_SetEXTISource(port, ((0x000fUL << (4 * (input->pin & 0x03))) << 16) | (input->pin >> 2));
+
+    state->debounce = 0;
+    state->level = exti_level(input);
+
+    if (input->edge != EXTI_EDGE_FALLING) LL_EXTI_EnableRisingTrig_0_31(line);
+    else                                  LL_EXTI_DisableRisingTrig_0_31(line);
+    if (input->edge != EXTI_EDGE_RISING)  LL_EXTI_EnableFallingTrig_0_31(line);
+    else                                  LL_EXTI_DisableFallingTrig_0_31(line);
+    LL_EXTI_ClearFlag_0_31(line);
+    LL_EXTI_EnableIT_0_31(line);
+
+    NVIC_SetPriority(exti_irqn[input->pin], NVIC_EncodePriority(NVIC_GetPriorityGrouping(), EXTI_IRQ_PRIORITY, 0));
+    NVIC_EnableIRQ(exti_irqn[input->pin]);
+
+    exit:
+    return ret;
+}
+
+int32_t exti_input_disable(const struct exti_input * const input)
+{
+    if (input == NULL || input->pin >= EXTI_LINES || exti.lines[input->pin].input != input)
+        return E_INVALID_PARAMETER;
+
+    uint32_t line = 1UL << input->pin;
+
+    taskENTER_CRITICAL();
+    LL_EXTI_DisableIT_0_31(line);
+    LL_EXTI_DisableRisingTrig_0_31(line);
+    LL_EXTI_DisableFallingTrig_0_31(line);
+    LL_EXTI_ClearFlag_0_31(line);
+    exti.lines[input->pin].debounce = 0;
+    exti.lines[input->pin].input = NULL;
+    taskEXIT_CRITICAL();
+
+    return E_SUCCESS;
+}
+
+int32_t exti_wait_event(struct exti_event * const event, uint32_t timeout)
+{
+    if (event == NULL) return E_INVALID_PARAMETER;
+    if (exti.events == NULL) return E_NOT_INITIALIZED;
+
+    if (xSemaphoreTake(exti.events, timeout) == pdFAIL) return E_TIMEOUT;
+
+    // Several tasks may wait for events, so taking one out is serialized among them
+    taskENTER_CRITICAL();
+    *event = exti.queue[exti.tail & (EXTI_EVENT_QUEUE_LEN - 1)];
+    exti.tail = exti.tail + 1;
+    taskEXIT_CRITICAL();
+
+    return E_SUCCESS;
+}
+
+uint32_t exti_overflows(void)
+{
+    return exti.overflows;
+}
+
+static void exti_irq_handle(uint32_t first, uint32_t last)
+{
+    BaseType_t context_switch = pdFALSE;
+    uint32_t now = timebase_us();
+
+    for (uint32_t i = first; i <= last; i++) {
+        uint32_t line = 1UL << i;
+        if (LL_EXTI_IsActiveFlag_0_31(line) == 0 || LL_EXTI_IsEnabledIT_0_31(line) == 0) continue;
+        LL_EXTI_ClearFlag_0_31(line);
+
+        struct exti_line_state *state = &exti.lines[i];
+        if (state->input == NULL) continue;
+
+        if (state->input->debounce_ms == 0) {
+            state->level = exti_level(state->input);
+            exti_push(i, state->level, now, &context_switch);
+            continue;
+        }
+
+        // Ignore the bounces and look again once the pin had time to settle
+        LL_EXTI_DisableIT_0_31(line);
+        state->timestamp = now;
+        // The timer free-runs, so the first tick comes anywhere within 1 ms. One more tick makes
+        // sure at least debounce_ms go by
+        state->debounce = state->input->debounce_ms + 1;
+        LL_TIM_EnableCounter(DEBOUNCE_TIM);
+    }
+
+    portYIELD_FROM_ISR(context_switch);
+}
+
+void TIM7_IRQHandler(void)
+{
+    BaseType_t context_switch = pdFALSE;
+    uint32_t active = 0;
+
+    LL_TIM_ClearFlag_UPDATE(DEBOUNCE_TIM);
+
+    for (uint32_t i = 0; i < EXTI_LINES; i++) {
+        struct exti_line_state *state = &exti.lines[i];
+        if (state->debounce == 0) continue;
+
+        if (--state->debounce != 0) {
+            active++;
+            continue;
+        }
+
+        uint32_t level = exti_level(state->input);
+        if (exti_edge_matches(state, level)) exti_push(i, level, state->timestamp, &context_switch);
+        state->level = level;
+
+        LL_EXTI_ClearFlag_0_31(1UL << i);
+        LL_EXTI_EnableIT_0_31(1UL << i);
+    }
+
+    if (active == 0) LL_TIM_DisableCounter(DEBOUNCE_TIM);
+
+    portYIELD_FROM_ISR(context_switch);
+}
+
+void EXTI0_IRQHandler(void)
+{
+    exti_irq_handle(0, 0);
+}
+
+void EXTI1_IRQHandler(void)
+{
+    exti_irq_handle(1, 1);
+}
+
+void EXTI2_IRQHandler(void)
+{
+    exti_irq_handle(2, 2);
+}
+
+void EXTI3_IRQHandler(void)
+{
+    exti_irq_handle(3, 3);
+}
+
+void EXTI4_IRQHandler(void)
+{
+    exti_irq_handle(4, 4);
+}
+
+void EXTI9_5_IRQHandler(void)
+{
+    exti_irq_handle(5, 9);
+}
+
+void EXTI15_10_IRQHandler(void)
+{
+    exti_irq_handle(10, 15);
+}
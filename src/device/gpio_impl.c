@@ -9,8 +9,11 @@
 #include "include/device/gpio.h"
 
 #include "include/errors.h"
+#include "include/stm32f4xx/gpio.h"
+#include "include/stm32f4xx/gpio_fast.h"
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "stm32f4xx.h"
 #include "stm32f4xx_ll_gpio.h"
@@ -25,13 +28,13 @@ struct gpio_priv {
 
 static const struct gpio_priv led_priv = {
     .config = {
-        .Pin = LL_GPIO_PIN_6,
+        .Pin = GPIO_FAST_BIT(GPIO_FAST_LED_PIN),
         .Mode = LL_GPIO_MODE_OUTPUT,
         .Speed = LL_GPIO_SPEED_FREQ_LOW,
         .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
     },
-    .ahb1_grp1_periph = LL_AHB1_GRP1_PERIPH_GPIOF,
-    .gpio = GPIOF,
+    .ahb1_grp1_periph = GPIO_FAST_PASTE(LL_AHB1_GRP1_PERIPH_GPIO, GPIO_FAST_LED_PORT),
+    .gpio = GPIO_FAST_PORT(GPIO_FAST_LED_PORT),
 };
 
 static int32_t stm32f4xx_gpio_init(const struct gpio_device * const gpio)
@@ -75,4 +78,23 @@ static const struct gpio_operations gpio_ops = {
 const struct gpio_device led_gpio = {
     .ops = &gpio_ops,
     .priv = &led_priv,
-};
\ No newline at end of file
+};
+
+int32_t stm32f4xx_gpio_group_init(const struct gpio_group * const group)
+{
+    if (group == NULL || group->mask == 0 || (group->mask & ~0xffffUL) != 0) return E_INVALID_PARAMETER;
+
+    const LL_GPIO_InitTypeDef config = {
+        .Pin = group->mask,
+        .Mode = group->mode,
+        .Speed = LL_GPIO_SPEED_FREQ_VERY_HIGH,
+        .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
+        .Pull = LL_GPIO_PULL_NO,
+    };
+
+    LL_AHB1_GRP1_EnableClock(group->ahb1_grp1_periph);
+    gpio_port_write(group->port, 0, group->mask);
+    LL_GPIO_Init(group->port, (LL_GPIO_InitTypeDef *)&config);
+
+    return E_SUCCESS;
+}
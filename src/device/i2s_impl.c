@@ -9,6 +9,10 @@
 #include "include/device/i2s.h"
 
 #include "include/errors.h"
+#include "include/stm32f4xx/i2s.h"
+#include "include/stm32f4xx/dma.h"
+#include "include/stm32f4xx/hw_init.h"
+#include "include/stm32f4xx/dwt.h"
 
 #include <stdint.h>
 #include <stddef.h>
@@ -17,114 +21,191 @@
 #include "stm32f4xx_ll_gpio.h"
 #include "stm32f4xx_ll_bus.h"
 #include "stm32f4xx_ll_spi.h"
+#include "stm32f4xx_ll_dma.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+// Number of I2Ss available
+#define AVAILABLE_I2S   2
+
+#define I2S_SAMPLE_RATE_MIN 8000
+#define I2S_SAMPLE_RATE_MAX 192000
+
+// Blocks handed to stm32f4xx_i2s_write_block() that may wait to be played
+#define I2S_BLOCK_QUEUE_LEN 4
+
+// Size of the DMA buffer used by stm32f4xx_i2s_write_block(), in uint16_t
+#define I2S_BLOCK_DMA_SIZE  512
+
+struct i2s_block {
+    const uint16_t  *data;
+    uint32_t        frames;
+};
+
+struct i2s_state {
+    struct i2s_config   config;
+    uint32_t            frame_size;     // uint16_t per stereo frame
+    uint16_t            *buffer;
+    uint32_t            frames;
+    i2s_stream_callback callback;
+    void                *arg;
+    uint32_t            streaming;
+    uint16_t            *rx_buffer;
+    i2s_process_callback process;
+
+    QueueHandle_t       block_queue;
+    struct i2s_block    block;          // Block being played. Only touched by the DMA interrupt
+    uint32_t            block_offset;   // Frames of block already copied
+    volatile uint32_t   blocks_done;
+    volatile uint32_t   block_busy;     // 1 while block is not fully copied
+    uint32_t            block_mode;
+
+    struct i2s_stats    stats;
+};
+
+// Most GPIO ports the pins of one I2S are spread over
+#define I2S_PIN_GROUPS  3
+
+struct i2s_pins {
+    GPIO_TypeDef    *port;          // NULL ends the list
+    uint32_t        pins;
+    uint32_t        port_clock;     // LL_AHB1_GRP1_PERIPH_GPIOx
+    uint32_t        af;
+};
 
 struct i2s_priv {
-    SPI_TypeDef *i2s;
+    SPI_TypeDef         *i2s;
+    uint32_t            clock;      // LL_APB1_GRP1_PERIPH_SPIx
+    struct i2s_pins     pins[I2S_PIN_GROUPS];
+    struct dma_stream   tx_dma;
+    SPI_TypeDef         *ext;       // I2Sx_ext block used as receiver in full-duplex
+    struct dma_stream   rx_dma;
+    struct i2s_pins     ext_pins;   // ext_SD, only claimed by stm32f4xx_i2s_duplex_start()
+    int                 index;
 };
 
-static int32_t stm32f4xx_i2s2_init(const struct i2s_device * const i2s)
-{
-    int32_t ret = E_SUCCESS;
+static struct i2s_state i2s_state[AVAILABLE_I2S];
+static uint16_t i2s_block_dma[AVAILABLE_I2S][I2S_BLOCK_DMA_SIZE];
 
-    const LL_GPIO_InitTypeDef gpio_set_1 = {
-        .Pin = LL_GPIO_PIN_3 | LL_GPIO_PIN_6,
-        .Mode = LL_GPIO_MODE_ALTERNATE,
-        .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
-        .Pull = LL_GPIO_PULL_NO,
-        .Speed = LL_GPIO_SPEED_FREQ_LOW,
-        .Alternate = LL_GPIO_AF_5
-    };
+// Configuration PLLI2S was last tuned for, the default one until an instance is configured
+static struct i2s_config i2s_clock_config = {
+    .sample_rate = HW_INIT_I2S_DEFAULT_SAMPLE_RATE,
+    .format = I2S_FORMAT_16BIT,
+    .standard = I2S_STANDARD_PHILIPS,
+    .mclk_output = 1
+};
 
-    const LL_GPIO_InitTypeDef gpio_set_2 = {
-        .Pin = LL_GPIO_PIN_9 | LL_GPIO_PIN_10,
-        .Mode = LL_GPIO_MODE_ALTERNATE,
-        .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
-        .Pull = LL_GPIO_PULL_NO,
-        .Speed = LL_GPIO_SPEED_FREQ_LOW,
-        .Alternate = LL_GPIO_AF_5
-    };
+static const uint32_t i2s_ll_format[] = {
+    [I2S_FORMAT_16BIT] = LL_I2S_DATAFORMAT_16B,
+    [I2S_FORMAT_16BIT_EXTENDED] = LL_I2S_DATAFORMAT_16B_EXTENDED,
+    [I2S_FORMAT_24BIT] = LL_I2S_DATAFORMAT_24B,
+    [I2S_FORMAT_32BIT] = LL_I2S_DATAFORMAT_32B
+};
 
-    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOC);
-    LL_GPIO_Init(GPIOC, (LL_GPIO_InitTypeDef *)&gpio_set_1);
+static const uint32_t i2s_ll_standard[] = {
+    [I2S_STANDARD_PHILIPS] = LL_I2S_STANDARD_PHILIPS,
+    [I2S_STANDARD_MSB] = LL_I2S_STANDARD_MSB,
+    [I2S_STANDARD_LSB] = LL_I2S_STANDARD_LSB,
+    [I2S_STANDARD_PCM_SHORT] = LL_I2S_STANDARD_PCM_SHORT,
+    [I2S_STANDARD_PCM_LONG] = LL_I2S_STANDARD_PCM_LONG
+};
 
-    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOB);
-    LL_GPIO_Init(GPIOB, (LL_GPIO_InitTypeDef *)&gpio_set_2);
+static void i2s_ll_config(const struct i2s_config * const config, LL_I2S_InitTypeDef * const ll_config)
+{
+    ll_config->Mode = LL_I2S_MODE_MASTER_TX;
+    ll_config->Standard = i2s_ll_standard[config->standard];
+    ll_config->DataFormat = i2s_ll_format[config->format];
+    ll_config->MCLKOutput = config->mclk_output ? LL_I2S_MCLK_OUTPUT_ENABLE : LL_I2S_MCLK_OUTPUT_DISABLE;
+    ll_config->AudioFreq = LL_I2S_AUDIOFREQ_DEFAULT;
+    ll_config->ClockPolarity = LL_I2S_POLARITY_LOW;
+}
 
-    const LL_I2S_InitTypeDef config = {
-        .Mode = LL_I2S_MODE_MASTER_TX,
-        .Standard = LL_I2S_STANDARD_PHILIPS,
-        .DataFormat = LL_I2S_DATAFORMAT_16B,
-        .MCLKOutput = LL_I2S_MCLK_OUTPUT_ENABLE,
-        .AudioFreq = LL_I2S_AUDIOFREQ_8K,
-        .ClockPolarity = LL_I2S_POLARITY_LOW
-    };
+/**
+ * @brief Retunes PLLI2S and programs the I2S registers. Leaves the I2S enabled only if it was
+ * enabled before
+ */
+static int32_t i2s_apply_config(const struct i2s_device * const i2s, const struct i2s_config * const config)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_state *state = &i2s_state[priv->index];
+    uint32_t channel_bits = (config->format == I2S_FORMAT_16BIT) ? 16 : 32;
+    uint32_t enabled = LL_I2S_IsEnabled(priv->i2s);
+    uint32_t prescaler;
+    int32_t ret;
+
+    if (config->sample_rate < I2S_SAMPLE_RATE_MIN || config->sample_rate > I2S_SAMPLE_RATE_MAX ||
+        config->format > I2S_FORMAT_32BIT || config->standard > I2S_STANDARD_PCM_LONG) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = hw_init_i2s_clock(config->sample_rate, config->mclk_output, channel_bits, &prescaler)) != E_SUCCESS)
+        goto exit;
+    i2s_clock_config = *config;
+
+    LL_I2S_InitTypeDef ll_config;
+    i2s_ll_config(config, &ll_config);
 
-    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_SPI2);
-    if (LL_I2S_Init(SPI2, (LL_I2S_InitTypeDef *)&config) == ERROR) {
+    LL_I2S_Disable(priv->i2s);
+    if (LL_I2S_Init(priv->i2s, &ll_config) == ERROR) {
         ret = E_HARDWARE_CONFIG_FAILED;
         goto exit;
     }
-    LL_I2S_Enable(SPI2);
+    LL_I2S_ConfigPrescaler(priv->i2s, prescaler / 2,
+        (prescaler & 0x01) ? LL_I2S_PRESCALER_PARITY_ODD : LL_I2S_PRESCALER_PARITY_EVEN);
+
+    state->config = *config;
+    state->frame_size = (config->format == I2S_FORMAT_24BIT || config->format == I2S_FORMAT_32BIT) ? 4 : 2;
+    if (enabled) LL_I2S_Enable(priv->i2s);
 
     exit:
     return ret;
 }
 
-static int32_t stm32f4xx_i2s3_init(const struct i2s_device * const i2s)
+static int32_t i2s_queue_init(const struct i2s_device * const i2s)
 {
-    int32_t ret = E_SUCCESS;
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_state *state = &i2s_state[priv->index];
 
-    const LL_GPIO_InitTypeDef gpio_set_1 = {
-        .Pin = LL_GPIO_PIN_7 | LL_GPIO_PIN_10,
-        .Mode = LL_GPIO_MODE_ALTERNATE,
-        .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
-        .Pull = LL_GPIO_PULL_NO,
-        .Speed = LL_GPIO_SPEED_FREQ_LOW,
-        .Alternate = LL_GPIO_AF_6
-    };
+    if (state->block_queue == NULL)
+        state->block_queue = xQueueCreate(I2S_BLOCK_QUEUE_LEN, sizeof(struct i2s_block));
 
-    const LL_GPIO_InitTypeDef gpio_set_2 = {
-        .Pin = LL_GPIO_PIN_5,
-        .Mode = LL_GPIO_MODE_ALTERNATE,
-        .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
-        .Pull = LL_GPIO_PULL_NO,
-        .Speed = LL_GPIO_SPEED_FREQ_LOW,
-        .Alternate = LL_GPIO_AF_6
-    };
+    return state->block_queue == NULL ? E_HARDWARE_CONFIG_FAILED : E_SUCCESS;
+}
 
-    const LL_GPIO_InitTypeDef gpio_set_3 = {
-        .Pin = LL_GPIO_PIN_4,
+static void i2s_gpio_init(const struct i2s_pins * const pins)
+{
+    const LL_GPIO_InitTypeDef gpio = {
+        .Pin = pins->pins,
         .Mode = LL_GPIO_MODE_ALTERNATE,
         .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
         .Pull = LL_GPIO_PULL_NO,
         .Speed = LL_GPIO_SPEED_FREQ_LOW,
-        .Alternate = LL_GPIO_AF_6
+        .Alternate = pins->af
     };
 
-    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOC);
-    LL_GPIO_Init(GPIOC, (LL_GPIO_InitTypeDef *)&gpio_set_1);
-
-    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOB);
-    LL_GPIO_Init(GPIOB, (LL_GPIO_InitTypeDef *)&gpio_set_2);
+    LL_AHB1_GRP1_EnableClock(pins->port_clock);
+    LL_GPIO_Init(pins->port, (LL_GPIO_InitTypeDef *)&gpio);
+}
 
-    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOA);
-    LL_GPIO_Init(GPIOA, (LL_GPIO_InitTypeDef *)&gpio_set_3);
+static int32_t stm32f4xx_i2s_init(const struct i2s_device * const i2s)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    // PLLI2S feeds every instance. Starting from the configuration it is tuned for leaves it as it
+    // is, so an instance that may be streaming is not disturbed
+    struct i2s_config config = i2s_clock_config;
+    int32_t ret;
 
-    const LL_I2S_InitTypeDef config = {
-        .Mode = LL_I2S_MODE_MASTER_TX,
-        .Standard = LL_I2S_STANDARD_PHILIPS,
-        .DataFormat = LL_I2S_DATAFORMAT_16B,
-        .MCLKOutput = LL_I2S_MCLK_OUTPUT_ENABLE,
-        .AudioFreq = LL_I2S_AUDIOFREQ_8K,
-        .ClockPolarity = LL_I2S_POLARITY_LOW
-    };
+    for (int i = 0; i < I2S_PIN_GROUPS && priv->pins[i].port != NULL; i++) i2s_gpio_init(&priv->pins[i]);
 
-    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_SPI3);
-    if (LL_I2S_Init(SPI3, (LL_I2S_InitTypeDef *)&config) == ERROR) {
-        ret = E_HARDWARE_CONFIG_FAILED;
-        goto exit;
-    }
-    LL_I2S_Enable(SPI3);
+    LL_APB1_GRP1_EnableClock(priv->clock);
+    if ((ret = i2s_apply_config(i2s, &config)) != E_SUCCESS) goto exit;
+    if ((ret = i2s_queue_init(i2s)) != E_SUCCESS) goto exit;
+    dwt_init();
+    stm32f4xx_i2s_reset_stats(i2s);
+    LL_I2S_Enable(priv->i2s);
 
     exit:
     return ret;
@@ -142,30 +223,575 @@ static int32_t stm32f4xx_i2s_write(const struct i2s_device * const i2s, uint16_t
     return (sizeof(uint16_t) + sizeof(uint16_t));
 }
 
-static const struct i2s_operations i2s2_ops = {
-    .i2s_init = stm32f4xx_i2s2_init,
+static const struct i2s_operations i2s_ops = {
+    .i2s_init = stm32f4xx_i2s_init,
     .i2s_write_op = stm32f4xx_i2s_write
 };
 
+// CK PB10, WS PB9, SD PC3, MCK PC6, ext_SD PC2
 static const struct i2s_priv i2s2_priv = {
-    .i2s = SPI2
+    .i2s = SPI2,
+    .clock = LL_APB1_GRP1_PERIPH_SPI2,
+    .pins = {
+        { GPIOC, LL_GPIO_PIN_3 | LL_GPIO_PIN_6, LL_AHB1_GRP1_PERIPH_GPIOC, LL_GPIO_AF_5 },
+        { GPIOB, LL_GPIO_PIN_9 | LL_GPIO_PIN_10, LL_AHB1_GRP1_PERIPH_GPIOB, LL_GPIO_AF_5 }
+    },
+    .tx_dma = {
+        .dma = DMA1,
+        .stream = LL_DMA_STREAM_4,
+        .channel = LL_DMA_CHANNEL_0,
+        .irqn = DMA1_Stream4_IRQn
+    },
+    .ext = I2S2ext,
+    .rx_dma = {
+        .dma = DMA1,
+        .stream = LL_DMA_STREAM_3,
+        .channel = LL_DMA_CHANNEL_3,
+        .irqn = DMA1_Stream3_IRQn
+    },
+    .ext_pins = { GPIOC, LL_GPIO_PIN_2, LL_AHB1_GRP1_PERIPH_GPIOC, LL_GPIO_AF_6 },
+    .index = 0
 };
 
 const struct i2s_device i2s2 = {
-    .i2s_ops = &i2s2_ops,
+    .i2s_ops = &i2s_ops,
     .priv = &i2s2_priv
 };
 
-static const struct i2s_operations i2s3_ops = {
-    .i2s_init = stm32f4xx_i2s3_init,
-    .i2s_write_op = stm32f4xx_i2s_write
-};
-
+// CK PC10, WS PA4, SD PB5, MCK PC7, ext_SD PC11
 static const struct i2s_priv i2s3_priv = {
-    .i2s = SPI3
+    .i2s = SPI3,
+    .clock = LL_APB1_GRP1_PERIPH_SPI3,
+    .pins = {
+        { GPIOC, LL_GPIO_PIN_7 | LL_GPIO_PIN_10, LL_AHB1_GRP1_PERIPH_GPIOC, LL_GPIO_AF_6 },
+        { GPIOB, LL_GPIO_PIN_5, LL_AHB1_GRP1_PERIPH_GPIOB, LL_GPIO_AF_6 },
+        { GPIOA, LL_GPIO_PIN_4, LL_AHB1_GRP1_PERIPH_GPIOA, LL_GPIO_AF_6 }
+    },
+    .tx_dma = {
+        .dma = DMA1,
+        .stream = LL_DMA_STREAM_5,
+        .channel = LL_DMA_CHANNEL_0,
+        .irqn = DMA1_Stream5_IRQn
+    },
+    .ext = I2S3ext,
+    .rx_dma = {
+        .dma = DMA1,
+        .stream = LL_DMA_STREAM_0,
+        .channel = LL_DMA_CHANNEL_3,
+        .irqn = DMA1_Stream0_IRQn
+    },
+    .ext_pins = { GPIOC, LL_GPIO_PIN_11, LL_AHB1_GRP1_PERIPH_GPIOC, LL_GPIO_AF_5 },
+    .index = 1
 };
 
 const struct i2s_device i2s3 = {
-    .i2s_ops = &i2s3_ops,
+    .i2s_ops = &i2s_ops,
     .priv = &i2s3_priv
 };
+
+/**
+ * @brief Accounts one callback that refilled half second (0 or 1) and took the cycles since start
+ */
+static void i2s_account(const struct i2s_priv * const priv, struct i2s_state * const state, uint32_t second,
+    uint32_t start)
+{
+    struct i2s_stats *stats = &state->stats;
+    uint32_t cycles = dwt_cycles() - start;
+    uint32_t half = (state->frames / 2) * state->frame_size;
+    uint32_t remaining = LL_DMA_GetDataLength(priv->tx_dma.dma, priv->tx_dma.stream);
+    int32_t bin = 31 - (int32_t)__CLZ(cycles | 1) - I2S_HISTOGRAM_SHIFT;
+
+    stats->callbacks++;
+    stats->histogram[bin < 0 ? 0 : bin >= I2S_HISTOGRAM_BINS ? I2S_HISTOGRAM_BINS - 1 : bin]++;
+    if (cycles > stats->max_cycles) stats->max_cycles = cycles;
+
+    // The DMA must still be in the other half, otherwise it already played part of the old samples
+    uint32_t headroom;
+    if (second == 0) {
+        if (remaining > half) goto underrun;
+        headroom = remaining;
+    } else {
+        if (remaining <= half) goto underrun;
+        headroom = remaining - half;
+    }
+
+    headroom /= state->frame_size;
+    if (headroom < stats->min_headroom) stats->min_headroom = headroom;
+    return;
+
+    underrun:
+    stats->underruns++;
+    stats->min_headroom = 0;
+}
+
+static void i2s_stream_dma_handler(void *arg, uint32_t flags)
+{
+    const struct i2s_device *i2s = (const struct i2s_device *)arg;
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_state *state = &i2s_state[priv->index];
+    uint32_t half = state->frames / 2;
+    uint32_t start;
+
+    if (flags & DMA_FLAG_ERRORS) state->stats.dma_errors++;
+    // Both halves done at once: one of them was played again before being refilled
+    if ((flags & (DMA_FLAG_HT | DMA_FLAG_TC)) == (DMA_FLAG_HT | DMA_FLAG_TC)) state->stats.underruns++;
+
+    if (flags & DMA_FLAG_HT) {
+        start = dwt_cycles();
+        state->callback(state->arg, state->buffer, half);
+        i2s_account(priv, state, 0, start);
+    }
+
+    if (flags & DMA_FLAG_TC) {
+        start = dwt_cycles();
+        state->callback(state->arg, &state->buffer[half * state->frame_size], half);
+        i2s_account(priv, state, 1, start);
+    }
+}
+
+int32_t stm32f4xx_i2s_stream_start(const struct i2s_device * const i2s, void *buffer, uint32_t frames,
+    i2s_stream_callback callback, void *arg)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_state *state = &i2s_state[priv->index];
+    const struct dma_stream *dma = &priv->tx_dma;
+    int32_t ret;
+
+    if (state->frame_size == 0) {
+        ret = E_NOT_INITIALIZED;
+        goto exit;
+    }
+
+    if (buffer == NULL || callback == NULL || frames < 2 || (frames & 0x01) ||
+        frames * state->frame_size > 0xffff) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (state->streaming) {
+        ret = E_DEVICE_BUSY;
+        goto exit;
+    }
+
+    // Claims the stream before anything is touched
+    if ((ret = dma_set_handler(dma, i2s_stream_dma_handler, (void *)i2s)) != E_SUCCESS) goto exit;
+
+    state->buffer = (uint16_t *)buffer;
+    state->frames = frames;
+    state->callback = callback;
+    state->arg = arg;
+
+    // Nothing must be played before the producer had a chance to fill the buffer
+    callback(arg, state->buffer, frames / 2);
+    callback(arg, &state->buffer[(frames / 2) * state->frame_size], frames / 2);
+
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+    if (dma_stop_stream(dma->dma, dma->stream, DMA_STOP_TIMEOUT) != E_SUCCESS) {
+        dma_clear_handler(dma);
+        ret = E_TIMEOUT;
+        goto exit;
+    }
+    LL_DMA_SetChannelSelection(dma->dma, dma->stream, dma->channel);
+    LL_DMA_ConfigTransfer(dma->dma, dma->stream, LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_MODE_CIRCULAR |
+        LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_HALFWORD |
+        LL_DMA_MDATAALIGN_HALFWORD | LL_DMA_PRIORITY_VERYHIGH);
+    LL_DMA_DisableFifoMode(dma->dma, dma->stream);
+    LL_DMA_ConfigAddresses(dma->dma, dma->stream, (uint32_t)buffer, LL_SPI_DMA_GetRegAddr(priv->i2s),
+        LL_DMA_DIRECTION_MEMORY_TO_PERIPH);
+    LL_DMA_SetDataLength(dma->dma, dma->stream, frames * state->frame_size);
+    LL_DMA_EnableIT_HT(dma->dma, dma->stream);
+    LL_DMA_EnableIT_TC(dma->dma, dma->stream);
+    LL_DMA_EnableIT_TE(dma->dma, dma->stream);
+    LL_DMA_EnableIT_DME(dma->dma, dma->stream);
+
+    state->streaming = 1;
+    LL_I2S_EnableDMAReq_TX(priv->i2s);
+    LL_DMA_EnableStream(dma->dma, dma->stream);
+    LL_I2S_Enable(priv->i2s);
+
+    exit:
+    return ret;
+}
+
+int32_t stm32f4xx_i2s_stream_stop(const struct i2s_device * const i2s)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+
+    if (i2s_state[priv->index].rx_buffer != NULL) return stm32f4xx_i2s_duplex_stop(i2s);
+
+    LL_I2S_DisableDMAReq_TX(priv->i2s);
+    dma_stop_stream(priv->tx_dma.dma, priv->tx_dma.stream, DMA_STOP_TIMEOUT);
+    dma_clear_handler(&priv->tx_dma);
+    i2s_state[priv->index].streaming = 0;
+
+    if (i2s_state[priv->index].block_mode) {
+        i2s_state[priv->index].block_mode = 0;
+        i2s_state[priv->index].block_busy = 0;
+        xQueueReset(i2s_state[priv->index].block_queue);
+    }
+
+    return E_SUCCESS;
+}
+
+int32_t stm32f4xx_i2s_configure(const struct i2s_device * const i2s, const struct i2s_config * const config)
+{
+    int32_t ret;
+
+    if (config == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    // PLLI2S feeds every instance, so none of them may be running from it
+    for (int i = 0; i < AVAILABLE_I2S; i++) {
+        if (i2s_state[i].streaming) {
+            ret = E_DEVICE_BUSY;
+            goto exit;
+        }
+    }
+
+    ret = i2s_apply_config(i2s, config);
+
+    exit:
+    return ret;
+}
+
+int32_t stm32f4xx_i2s_get_config(const struct i2s_device * const i2s, struct i2s_config * const config)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+
+    if (config == NULL) return E_INVALID_PARAMETER;
+    *config = i2s_state[priv->index].config;
+
+    return E_SUCCESS;
+}
+
+int32_t stm32f4xx_i2s_stop(const struct i2s_device * const i2s)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+
+    if (i2s_state[priv->index].streaming) return E_DEVICE_BUSY;
+
+    // Let the last frame go out before the clock stops
+    while (LL_I2S_IsActiveFlag_TXE(priv->i2s) == 0);
+    while (LL_I2S_IsActiveFlag_BSY(priv->i2s) == 1);
+    LL_I2S_Disable(priv->i2s);
+
+    return E_SUCCESS;
+}
+
+int32_t stm32f4xx_i2s_start(const struct i2s_device * const i2s)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+
+    LL_I2S_Enable(priv->i2s);
+
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Stream callback of stm32f4xx_i2s_write_block(). Copies queued blocks into the DMA
+ * buffer and plays silence when there is nothing left
+ */
+static void i2s_block_callback(void *arg, void *block, uint32_t frames)
+{
+    struct i2s_state *state = (struct i2s_state *)arg;
+    BaseType_t context_switch = pdFALSE;
+    uint16_t *out = (uint16_t *)block;
+    uint32_t i = 0;
+    uint32_t size = frames * state->frame_size;
+
+    while (i < size) {
+        if (state->block_busy == 0) {
+            if (xQueueReceiveFromISR(state->block_queue, &state->block, &context_switch) == pdFAIL) break;
+            state->block_offset = 0;
+            state->block_busy = 1;
+        }
+
+        const uint16_t *in = &state->block.data[state->block_offset * state->frame_size];
+        uint32_t count = (state->block.frames - state->block_offset) * state->frame_size;
+        if (count > size - i) count = size - i;
+
+        for (uint32_t j = 0; j < count; j++) out[i + j] = in[j];
+        i += count;
+        state->block_offset += count / state->frame_size;
+
+        if (state->block_offset == state->block.frames) {
+            state->block_busy = 0;
+            state->blocks_done++;
+        }
+    }
+
+    for (; i < size; i++) out[i] = 0;
+
+    portYIELD_FROM_ISR(context_switch);
+}
+
+int32_t stm32f4xx_i2s_write_block(const struct i2s_device * const i2s, const void *data, uint32_t frames,
+    uint32_t timeout)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_state *state = &i2s_state[priv->index];
+    const struct i2s_block block = {
+        .data = (const uint16_t *)data,
+        .frames = frames
+    };
+    int32_t ret;
+
+    if (state->block_queue == NULL) {
+        ret = E_NOT_INITIALIZED;
+        goto exit;
+    }
+
+    if (data == NULL || frames == 0) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (state->streaming && state->block_mode == 0) {
+        ret = E_DEVICE_BUSY;
+        goto exit;
+    }
+
+    if (xQueueSend(state->block_queue, &block, timeout) == pdFAIL) {
+        ret = E_TIMEOUT;
+        goto exit;
+    }
+
+    // The first block starts the stream. Its first half is filled right away from the queue
+    if (state->streaming == 0) {
+        state->block_mode = 1;
+        ret = stm32f4xx_i2s_stream_start(i2s, i2s_block_dma[priv->index], I2S_BLOCK_DMA_SIZE / state->frame_size,
+            i2s_block_callback, state);
+        if (ret != E_SUCCESS) {
+            state->block_mode = 0;
+            xQueueReset(state->block_queue);
+            goto exit;
+        }
+    }
+
+    ret = frames;
+
+    exit:
+    return ret;
+}
+
+int32_t stm32f4xx_i2s_flush(const struct i2s_device * const i2s, uint32_t timeout)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_state *state = &i2s_state[priv->index];
+
+    if (state->block_mode == 0) return E_SUCCESS;
+
+    while (uxQueueMessagesWaiting(state->block_queue) != 0 || state->block_busy) {
+        if (timeout == 0) return E_TIMEOUT;
+        vTaskDelay(1);
+        if (timeout != portMAX_DELAY) timeout--;
+    }
+
+    return E_SUCCESS;
+}
+
+uint32_t stm32f4xx_i2s_blocks_done(const struct i2s_device * const i2s)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+
+    return i2s_state[priv->index].blocks_done;
+}
+
+static void i2s_duplex_dma_handler(void *arg, uint32_t flags)
+{
+    const struct i2s_device *i2s = (const struct i2s_device *)arg;
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_state *state = &i2s_state[priv->index];
+    uint32_t half = state->frames / 2;
+    uint32_t offset = half * state->frame_size;
+
+    uint32_t start;
+
+    if (flags & DMA_FLAG_ERRORS) state->stats.dma_errors++;
+    if ((flags & (DMA_FLAG_HT | DMA_FLAG_TC)) == (DMA_FLAG_HT | DMA_FLAG_TC)) state->stats.underruns++;
+
+    // TX runs one half ahead of RX, so the half just captured is also the next one to be played
+    if (flags & DMA_FLAG_HT) {
+        start = dwt_cycles();
+        state->process(state->arg, state->rx_buffer, state->buffer, half);
+        i2s_account(priv, state, 0, start);
+    }
+
+    if (flags & DMA_FLAG_TC) {
+        start = dwt_cycles();
+        state->process(state->arg, &state->rx_buffer[offset], &state->buffer[offset], half);
+        i2s_account(priv, state, 1, start);
+    }
+}
+
+static int32_t i2s_duplex_dma_config(const struct dma_stream * const dma, uint32_t direction, void *buffer,
+    uint32_t periph, uint32_t size)
+{
+    if (dma_stop_stream(dma->dma, dma->stream, DMA_STOP_TIMEOUT) != E_SUCCESS) return E_TIMEOUT;
+    LL_DMA_SetChannelSelection(dma->dma, dma->stream, dma->channel);
+    LL_DMA_ConfigTransfer(dma->dma, dma->stream, direction | LL_DMA_MODE_CIRCULAR |
+        LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_HALFWORD |
+        LL_DMA_MDATAALIGN_HALFWORD | LL_DMA_PRIORITY_VERYHIGH);
+    LL_DMA_DisableFifoMode(dma->dma, dma->stream);
+    LL_DMA_ConfigAddresses(dma->dma, dma->stream, (uint32_t)buffer, periph, direction);
+    LL_DMA_SetDataLength(dma->dma, dma->stream, size);
+
+    return E_SUCCESS;
+}
+
+int32_t stm32f4xx_i2s_duplex_start(const struct i2s_device * const i2s, void *tx_buffer, void *rx_buffer,
+    uint32_t frames, i2s_process_callback callback, void *arg)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_state *state = &i2s_state[priv->index];
+    LL_I2S_InitTypeDef ll_config;
+    int32_t ret;
+
+    if (state->frame_size == 0) {
+        ret = E_NOT_INITIALIZED;
+        goto exit;
+    }
+
+    if (tx_buffer == NULL || rx_buffer == NULL || callback == NULL || frames < 2 || (frames & 0x01) ||
+        frames * state->frame_size > 0xffff) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (state->streaming) {
+        ret = E_DEVICE_BUSY;
+        goto exit;
+    }
+
+    // Fails while the SPI2 slave, which shares the stream with I2S2ext, is running
+    if ((ret = dma_set_handler(&priv->rx_dma, i2s_duplex_dma_handler, (void *)i2s)) != E_SUCCESS) goto exit;
+    // TX raises no interrupt, its handler only claims the stream against stream_start
+    if ((ret = dma_set_handler(&priv->tx_dma, i2s_duplex_dma_handler, (void *)i2s)) != E_SUCCESS) {
+        dma_clear_handler(&priv->rx_dma);
+        goto exit;
+    }
+
+    i2s_gpio_init(&priv->ext_pins);
+
+    state->buffer = (uint16_t *)tx_buffer;
+    state->rx_buffer = (uint16_t *)rx_buffer;
+    state->frames = frames;
+    state->process = callback;
+    state->arg = arg;
+
+    // Nothing has been captured yet, so the first two halves are silence
+    for (uint32_t i = 0; i < frames * state->frame_size; i++) state->buffer[i] = 0;
+
+    // Both blocks must start on the same frame, so the master clock is stopped while arming
+    while (LL_I2S_IsActiveFlag_BSY(priv->i2s) == 1);
+    LL_I2S_Disable(priv->i2s);
+    LL_I2S_Disable(priv->ext);
+
+    i2s_ll_config(&state->config, &ll_config);
+    if (LL_I2S_InitFullDuplex(priv->ext, &ll_config) == ERROR) {
+        ret = E_HARDWARE_CONFIG_FAILED;
+        goto release;
+    }
+
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+    if ((ret = i2s_duplex_dma_config(&priv->tx_dma, LL_DMA_DIRECTION_MEMORY_TO_PERIPH, tx_buffer,
+        LL_SPI_DMA_GetRegAddr(priv->i2s), frames * state->frame_size)) != E_SUCCESS) goto release;
+    if ((ret = i2s_duplex_dma_config(&priv->rx_dma, LL_DMA_DIRECTION_PERIPH_TO_MEMORY, rx_buffer,
+        LL_SPI_DMA_GetRegAddr(priv->ext), frames * state->frame_size)) != E_SUCCESS) goto release;
+    LL_DMA_EnableIT_HT(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_DMA_EnableIT_TC(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_DMA_EnableIT_TE(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_DMA_EnableIT_DME(priv->rx_dma.dma, priv->rx_dma.stream);
+
+    state->streaming = 1;
+    LL_I2S_EnableDMAReq_RX(priv->ext);
+    LL_I2S_EnableDMAReq_TX(priv->i2s);
+    LL_DMA_EnableStream(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_DMA_EnableStream(priv->tx_dma.dma, priv->tx_dma.stream);
+    // The slave must be enabled before the master that clocks it
+    LL_I2S_Enable(priv->ext);
+    LL_I2S_Enable(priv->i2s);
+
+    return E_SUCCESS;
+
+    release:
+    dma_clear_handler(&priv->tx_dma);
+    dma_clear_handler(&priv->rx_dma);
+    state->rx_buffer = NULL;
+
+    exit:
+    return ret;
+}
+
+int32_t stm32f4xx_i2s_duplex_stop(const struct i2s_device * const i2s)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+
+    // Not running: the RX stream may belong to the SPI2 slave
+    if (i2s_state[priv->index].rx_buffer == NULL) return E_SUCCESS;
+
+    LL_I2S_DisableDMAReq_TX(priv->i2s);
+    LL_I2S_DisableDMAReq_RX(priv->ext);
+    dma_clear_handler(&priv->rx_dma);
+    dma_stop_stream(priv->rx_dma.dma, priv->rx_dma.stream, DMA_STOP_TIMEOUT);
+    dma_stop_stream(priv->tx_dma.dma, priv->tx_dma.stream, DMA_STOP_TIMEOUT);
+    dma_clear_handler(&priv->tx_dma);
+    LL_I2S_Disable(priv->ext);
+    i2s_state[priv->index].streaming = 0;
+    i2s_state[priv->index].rx_buffer = NULL;
+
+    return E_SUCCESS;
+}
+
+int32_t stm32f4xx_i2s_poll(const struct i2s_device * const i2s, enum i2s_poll_op op, void *answer)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    const struct i2s_stats *stats = &i2s_state[priv->index].stats;
+    int32_t ret = E_SUCCESS;
+
+    if (answer == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    switch (op) {
+    case I2S_POLL_UNDERRUNS:
+        *((uint32_t *)answer) = stats->underruns;
+        break;
+
+    case I2S_POLL_MIN_HEADROOM:
+        *((uint32_t *)answer) = stats->min_headroom;
+        break;
+
+    case I2S_POLL_DMA_ERRORS:
+        *((uint32_t *)answer) = stats->dma_errors;
+        break;
+
+    case I2S_POLL_STATS:
+        // Counters are updated from the DMA interrupt, so copy them all at once
+        taskENTER_CRITICAL();
+        *((struct i2s_stats *)answer) = *stats;
+        taskEXIT_CRITICAL();
+        break;
+
+    default:
+        ret = E_POLLOP_INVALID;
+        goto exit;
+    }
+
+    exit:
+    return ret;
+}
+
+void stm32f4xx_i2s_reset_stats(const struct i2s_device * const i2s)
+{
+    const struct i2s_priv *priv = (const struct i2s_priv *)i2s->priv;
+    struct i2s_stats *stats = &i2s_state[priv->index].stats;
+
+    taskENTER_CRITICAL();
+    *stats = (struct i2s_stats){ 0 };
+    stats->min_headroom = UINT32_MAX;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,191 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/rtc.h"
+
+#include "include/errors.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_bus.h"
+#include "stm32f4xx_ll_pwr.h"
+#include "stm32f4xx_ll_rcc.h"
+#include "stm32f4xx_ll_rtc.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// 32768 Hz / (127 + 1) / (255 + 1) = 1 Hz
+#define RTC_ASYNCH_PREDIV   127
+#define RTC_SYNCH_PREDIV    255
+
+// Unix timestamps of 2000-01-01 and 2100-01-01
+#define RTC_MIN_TIMESTAMP   946684800UL
+#define RTC_MAX_TIMESTAMP   4102444800UL
+
+#define SECONDS_PER_DAY     86400UL
+
+static volatile uint32_t rtc_running;
+
+/**
+ * @brief Days since 1970-01-01 of a date of the proleptic Gregorian calendar
+ */
+static uint32_t rtc_days_from_civil(uint32_t year, uint32_t month, uint32_t day)
+{
+    // Years start in March so the leap day is the last one
+    year -= month <= 2;
+    uint32_t era = year / 400;
+    uint32_t yoe = year - era * 400;
+    uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+static void rtc_civil_from_days(uint32_t days, uint32_t * const year, uint32_t * const month,
+    uint32_t * const day)
+{
+    days += 719468;
+    uint32_t era = days / 146097;
+    uint32_t doe = days - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = yoe + era * 400 + (*month <= 2);
+}
+
+void rtc_start(void)
+{
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_PWR);
+    LL_PWR_EnableBkUpAccess();
+
+    if (LL_RCC_IsEnabledRTC() && LL_RCC_GetRTCClockSource() == LL_RCC_RTC_CLKSOURCE_LSE) return;
+
+    // The RTC clock source can only be changed by resetting the backup domain
+    if (LL_RCC_GetRTCClockSource() != LL_RCC_RTC_CLKSOURCE_NONE) {
+        LL_RCC_ForceBackupDomainReset();
+        LL_RCC_ReleaseBackupDomainReset();
+    }
+
+    LL_RCC_LSE_Enable();
+}
+
+/**
+ * @brief Finishes what rtc_start began once the LSE runs. Returns 1 when the RTC is usable
+ */
+static uint32_t rtc_ready(void)
+{
+    uint32_t mask;
+
+    if (rtc_running) return 1;
+    if (!LL_RCC_LSE_IsReady()) return 0;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    if (!rtc_running) {
+        if (!LL_RCC_IsEnabledRTC()) {
+            LL_RCC_SetRTCClockSource(LL_RCC_RTC_CLKSOURCE_LSE);
+            LL_RCC_EnableRTC();
+        }
+
+        LL_RTC_DisableWriteProtection(RTC);
+        LL_RTC_EnableShadowRegBypass(RTC);
+        if (!LL_RTC_IsActiveFlag_INITS(RTC) && LL_RTC_EnterInitMode(RTC) == SUCCESS) {
+            LL_RTC_SetAsynchPrescaler(RTC, RTC_ASYNCH_PREDIV);
+            LL_RTC_SetSynchPrescaler(RTC, RTC_SYNCH_PREDIV);
+            LL_RTC_ExitInitMode(RTC);
+        }
+        LL_RTC_EnableWriteProtection(RTC);
+        rtc_running = 1;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    return 1;
+}
+
+int32_t rtc_get_timestamp(uint32_t * const seconds, uint32_t * const micros)
+{
+    uint32_t tr, dr, ssr;
+    int32_t ret = E_SUCCESS;
+
+    if (seconds == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (!rtc_ready() || !LL_RTC_IsActiveFlag_INITS(RTC)) {
+        ret = E_NOT_INITIALIZED;
+        goto exit;
+    }
+
+    // Without shadow registers the three reads are only coherent if the second did not change
+    // meanwhile. The date only changes along with the time
+    do {
+        tr = RTC->TR;
+        dr = RTC->DR;
+        ssr = RTC->SSR;
+    } while (tr != RTC->TR);
+
+    uint32_t year = 2000 + __LL_RTC_CONVERT_BCD2BIN((dr >> RTC_DR_YU_Pos) & 0xff);
+    uint32_t month = __LL_RTC_CONVERT_BCD2BIN((dr >> RTC_DR_MU_Pos) & 0x1f);
+    uint32_t day = __LL_RTC_CONVERT_BCD2BIN((dr >> RTC_DR_DU_Pos) & 0x3f);
+    uint32_t hour = __LL_RTC_CONVERT_BCD2BIN((tr >> RTC_TR_HU_Pos) & 0x3f);
+    uint32_t minute = __LL_RTC_CONVERT_BCD2BIN((tr >> RTC_TR_MNU_Pos) & 0x7f);
+    uint32_t second = __LL_RTC_CONVERT_BCD2BIN((tr >> RTC_TR_SU_Pos) & 0x7f);
+
+    *seconds = rtc_days_from_civil(year, month, day) * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+    // SSR counts down from RTC_SYNCH_PREDIV during the second
+    if (micros != NULL) *micros = ((RTC_SYNCH_PREDIV - (ssr & 0xffff)) * 1000000UL) / (RTC_SYNCH_PREDIV + 1);
+
+    exit:
+    return ret;
+}
+
+int32_t rtc_set_timestamp(uint32_t seconds)
+{
+    uint32_t year, month, day;
+    int32_t ret = E_SUCCESS;
+
+    if (seconds < RTC_MIN_TIMESTAMP || seconds >= RTC_MAX_TIMESTAMP) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (!rtc_ready()) {
+        ret = E_NOT_INITIALIZED;
+        goto exit;
+    }
+
+    uint32_t days = seconds / SECONDS_PER_DAY;
+    uint32_t time = seconds % SECONDS_PER_DAY;
+    // 1970-01-01 was a Thursday. The RTC counts week days from Monday = 1
+    uint32_t weekday = (days + 3) % 7 + 1;
+    rtc_civil_from_days(days, &year, &month, &day);
+
+    LL_RTC_DisableWriteProtection(RTC);
+    if (LL_RTC_EnterInitMode(RTC) != SUCCESS) {
+        ret = E_TIMEOUT;
+    } else {
+        RTC->TR = (uint32_t)__LL_RTC_CONVERT_BIN2BCD(time / 3600) << RTC_TR_HU_Pos |
+            (uint32_t)__LL_RTC_CONVERT_BIN2BCD((time / 60) % 60) << RTC_TR_MNU_Pos |
+            (uint32_t)__LL_RTC_CONVERT_BIN2BCD(time % 60) << RTC_TR_SU_Pos;
+        RTC->DR = (uint32_t)__LL_RTC_CONVERT_BIN2BCD(year - 2000) << RTC_DR_YU_Pos |
+            weekday << RTC_DR_WDU_Pos |
+            (uint32_t)__LL_RTC_CONVERT_BIN2BCD(month) << RTC_DR_MU_Pos |
+            (uint32_t)__LL_RTC_CONVERT_BIN2BCD(day) << RTC_DR_DU_Pos;
+        LL_RTC_ExitInitMode(RTC);
+    }
+    LL_RTC_EnableWriteProtection(RTC);
+
+    exit:
+    return ret;
+}
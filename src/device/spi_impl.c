@@ -13,19 +13,59 @@
 
 #include "include/errors.h"
 #include "include/device/pool_op.h"
+#include "include/stm32f4xx/spi.h"
+#include "include/stm32f4xx/dma.h"
+#include "include/stm32f4xx/dwt.h"
 #include "ulibc/include/utils.h"
 
 #include "stm32f4xx.h"
 #include "stm32f4xx_ll_gpio.h"
 #include "stm32f4xx_ll_bus.h"
 #include "stm32f4xx_ll_spi.h"
+#include "stm32f4xx_ll_dma.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+// Number of SPIs available
+#define AVAILABLE_SPIS  2
+
+struct spi_state {
+    SemaphoreHandle_t   mutex;
+    uint32_t            lock_cycles;    // When the bus was taken
+    struct spi_stats    stats;
+    uint8_t             *slave_buffer;
+    uint32_t            slave_size;
+    spi_slave_callback  slave_callback;
+    void                *slave_arg;
+    volatile uint32_t   slave_overruns;
+};
 
 struct spi_priv {
-    SPI_TypeDef *spi;
+    SPI_TypeDef         *spi;
+    struct dma_stream   rx_dma;
+    struct dma_stream   tx_dma;
+    int                 index;
 };
 
+static struct spi_state spi_state[AVAILABLE_SPIS];
+
 static const struct spi_priv spi1_priv = {
     .spi = SPI1,
+    .rx_dma = {
+        .dma = DMA2,
+        .stream = LL_DMA_STREAM_2,
+        .channel = LL_DMA_CHANNEL_3,
+        .irqn = DMA2_Stream2_IRQn
+    },
+    .tx_dma = {
+        .dma = DMA2,
+        .stream = LL_DMA_STREAM_3,
+        .channel = LL_DMA_CHANNEL_3,
+        .irqn = DMA2_Stream3_IRQn
+    },
+    .index = 0
 };
 
 static int32_t stm32f4xx_spi1_init(const struct spi_device * const spi);
@@ -46,16 +86,99 @@ const struct spi_device spi1 = {
     .priv = &spi1_priv
 };
 
+// SPI2 as a receive-only slave. Shares the peripheral with i2s2, so only one of them can be used
+static const struct spi_priv spi2_slave_priv = {
+    .spi = SPI2,
+    .rx_dma = {
+        .dma = DMA1,
+        .stream = LL_DMA_STREAM_3,
+        .channel = LL_DMA_CHANNEL_0,
+        .irqn = DMA1_Stream3_IRQn
+    },
+    .index = 1
+};
+
+static int32_t stm32f4xx_spi2_slave_init(const struct spi_device * const spi);
+static int32_t stm32f4xx_spi_slave_write(const struct spi_device * const spi, const void *data, uint32_t size,
+    uint32_t timeout);
+static int32_t stm32f4xx_spi_slave_read(const struct spi_device * const spi, void *data, uint32_t size,
+    uint32_t timeout);
+static int32_t stm32f4xx_spi_slave_transact(const struct spi_device * const spi,
+    struct spi_transaction * const transaction, uint32_t timeout);
+
+static const struct spi_operations spi2_slave_ops = {
+    .spi_init = stm32f4xx_spi2_slave_init,
+    .spi_write_op = stm32f4xx_spi_slave_write,
+    .spi_read_op = stm32f4xx_spi_slave_read,
+    .spi_transact_op = stm32f4xx_spi_slave_transact
+};
+
+const struct spi_device spi2_slave = {
+    .ops = &spi2_slave_ops,
+    .priv = &spi2_slave_priv
+};
+
 // Implementation
 
+static int32_t spi_bus_lock(const struct spi_priv * const priv, uint32_t timeout)
+{
+    struct spi_state *state = &spi_state[priv->index];
+    uint32_t start;
+    int32_t ret = E_SUCCESS;
+
+    if (state->mutex == NULL) {
+        ret = E_NOT_INITIALIZED;
+        goto exit;
+    }
+
+    taskENTER_CRITICAL();
+    if (++state->stats.queue_depth > state->stats.queue_depth_max) {
+        state->stats.queue_depth_max = state->stats.queue_depth;
+    }
+    taskEXIT_CRITICAL();
+
+    start = dwt_cycles();
+    if (xSemaphoreTake(state->mutex, timeout) == pdFAIL) ret = E_TIMEOUT;
+
+    taskENTER_CRITICAL();
+    state->stats.queue_depth--;
+    taskEXIT_CRITICAL();
+
+    if (ret == E_SUCCESS) {
+        state->lock_cycles = dwt_cycles();
+        state->stats.wait_cycles += state->lock_cycles - start;
+    }
+
+    exit:
+    return ret;
+}
+
+static void spi_bus_unlock(const struct spi_priv * const priv)
+{
+    struct spi_state *state = &spi_state[priv->index];
+
+    state->stats.bus_cycles += dwt_cycles() - state->lock_cycles;
+    xSemaphoreGive(state->mutex);
+}
+
+static void spi_account(const struct spi_priv * const priv, uint32_t bytes)
+{
+    struct spi_state *state = &spi_state[priv->index];
+
+    state->stats.transactions++;
+    state->stats.bytes += bytes;
+}
+
 static int32_t stm32f4xx_spi1_init(const struct spi_device * const spi)
 {
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
     LL_SPI_InitTypeDef SPI_InitStruct = {0};
 
     LL_GPIO_InitTypeDef GPIO_InitStruct = {0};
 
     /* Peripheral clock enable */
     LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_SPI1);
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
 
     LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOA);
     /**SPI1 GPIO Configuration  
@@ -84,64 +207,101 @@ static int32_t stm32f4xx_spi1_init(const struct spi_device * const spi)
     LL_SPI_Init(SPI1, &SPI_InitStruct);
     LL_SPI_SetStandard(SPI1, LL_SPI_PROTOCOL_MOTOROLA);
 
+    dwt_init();
+    if (spi_state[priv->index].mutex == NULL) spi_state[priv->index].mutex = xSemaphoreCreateMutex();
+
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Busy-waits until flag reads active
+ *
+ * @param spi SPI peripheral
+ * @param flag one of LL_SPI_IsActiveFlag_x
+ * @param active 1 to wait for the flag to be set, 0 to wait for it to be cleared
+ * @param timeout in busy-wait iterations
+ * @return int32_t E_SUCCESS or E_TIMEOUT
+ */
+static int32_t spi_wait_flag(SPI_TypeDef *spi, uint32_t (*flag)(SPI_TypeDef *), uint32_t active, uint32_t timeout)
+{
+    uint32_t t = timeout;
+
+    while (flag(spi) != active) {
+        if (t-- == 0) return E_TIMEOUT;
+    }
+
     return E_SUCCESS;
 }
 
 static int32_t stm32f4xx_spi_write(const struct spi_device * const spi, const void *data, uint32_t size, uint32_t timeout)
 {
-    (void)timeout;
-    int32_t i;
     const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
     const uint8_t *udata = (const uint8_t *)data;
+    uint32_t i;
+    int32_t ret;
 
     if (udata == NULL) {
-        i = E_INVALID_PARAMETER;
+        ret = E_INVALID_PARAMETER;
         goto exit;
     }
 
+    if ((ret = spi_bus_lock(priv, portMAX_DELAY)) != E_SUCCESS) goto exit;
+    LL_SPI_Enable(priv->spi); // Init and the DMA paths leave it disabled
     for (i = 0; i < size; i++) {
-        while (!LL_SPI_IsActiveFlag_TXE(priv->spi));
+        if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_TXE, 1, timeout)) != E_SUCCESS) goto unlock;
         LL_SPI_TransmitData8(priv->spi, udata[i]);
     }
-    while (LL_SPI_IsActiveFlag_BSY(priv->spi));
+    if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_BSY, 0, timeout)) != E_SUCCESS) goto unlock;
+    spi_account(priv, size);
+    ret = size;
+
+    unlock:
+    spi_bus_unlock(priv);
 
     exit:
-    return i;
+    return ret;
 }
 
 static int32_t stm32f4xx_spi_read(const struct spi_device * spi, void *data, uint32_t size, uint32_t timeout)
 {
-    (void)timeout;
-    int32_t i;
     const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
     uint8_t *udata = (uint8_t *)data;
+    uint32_t i;
+    int32_t ret;
 
     if (udata == NULL) {
-        i = E_INVALID_PARAMETER;
+        ret = E_INVALID_PARAMETER;
         goto exit;
     }
 
+    if ((ret = spi_bus_lock(priv, portMAX_DELAY)) != E_SUCCESS) goto exit;
+    LL_SPI_Enable(priv->spi); // Init and the DMA paths leave it disabled
     // Clears the RX buffer
     LL_SPI_ReceiveData8(priv->spi);
     for (i = 0; i < size; i++) {
-        while (LL_SPI_IsActiveFlag_TXE(priv->spi) == 0);
+        if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_TXE, 1, timeout)) != E_SUCCESS) goto unlock;
         LL_SPI_TransmitData8(priv->spi, 0xff);
-        while (LL_SPI_IsActiveFlag_RXNE(priv->spi) == 0);
+        if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_RXNE, 1, timeout)) != E_SUCCESS) goto unlock;
         udata[i] = LL_SPI_ReceiveData8(priv->spi);
     }
-    while (LL_SPI_IsActiveFlag_BSY(priv->spi));
+    if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_BSY, 0, timeout)) != E_SUCCESS) goto unlock;
+    spi_account(priv, size);
+    ret = size;
+
+    unlock:
+    spi_bus_unlock(priv);
 
     exit:
-    return i;
+    return ret;
 }
 
 static int32_t stm32f4xx_spi_transact(const struct spi_device * const spi, struct spi_transaction * const transaction,
     uint32_t timeout)
 {
-    (void)timeout;
     struct spi_priv *priv = (struct spi_priv *)spi->priv;
-    const uint8_t *uwrite_data = (const uint8_t *)transaction->write_data;
-    uint8_t *uread_data = (uint8_t *)transaction->read_data;
+    const uint8_t *uwrite_data;
+    uint8_t *uread_data;
+    uint32_t i, j;
     int32_t ret = E_SUCCESS;
 
     if (transaction == NULL) {
@@ -154,19 +314,506 @@ static int32_t stm32f4xx_spi_transact(const struct spi_device * const spi, struc
         goto exit;
     }
 
+    uwrite_data = (const uint8_t *)transaction->write_data;
+    uread_data = (uint8_t *)transaction->read_data;
+
+    if ((ret = spi_bus_lock(priv, portMAX_DELAY)) != E_SUCCESS) goto exit;
+    LL_SPI_Enable(priv->spi); // Init and the DMA paths leave it disabled
     // Clears SPI RX buffer
     LL_SPI_ReceiveData8(priv->spi);
-    for (uint32_t i = 0, j = 0; i < transaction->write_size || j < transaction->read_size; i++) {
-        while (!LL_SPI_IsActiveFlag_TXE(priv->spi));
-        LL_SPI_TransmitData8(priv->spi, uwrite_data[i]);
+    for (i = 0, j = 0; i < transaction->write_size || j < transaction->read_size; i++) {
+        if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_TXE, 1, timeout)) != E_SUCCESS) goto unlock;
+        // 0xff is clocked out once write data runs out
+        LL_SPI_TransmitData8(priv->spi, i < transaction->write_size ? uwrite_data[i] : 0xff);
         if (j < transaction->read_size) {
-            while (!LL_SPI_IsActiveFlag_RXNE(priv->spi));
+            if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_RXNE, 1, timeout)) != E_SUCCESS) goto unlock;
             uread_data[j++] = LL_SPI_ReceiveData8(priv->spi);
         }
+    }
+    if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_BSY, 0, timeout)) != E_SUCCESS) goto unlock;
+    spi_account(priv, i);
+
+    unlock:
+    spi_bus_unlock(priv);
 
+    exit:
+    return ret;
+}
+
+static int32_t spi_dma_config(const struct dma_stream * const dma, uint32_t direction, uint32_t periph_addr,
+    uint32_t mem_addr, uint32_t frames, uint32_t config, uint32_t timeout)
+{
+    if (dma_stop_stream(dma->dma, dma->stream, timeout) != E_SUCCESS) return E_TIMEOUT;
+    LL_DMA_SetChannelSelection(dma->dma, dma->stream, dma->channel);
+    LL_DMA_ConfigTransfer(dma->dma, dma->stream, direction | LL_DMA_MODE_NORMAL | LL_DMA_PERIPH_NOINCREMENT |
+        LL_DMA_PRIORITY_HIGH | config);
+    LL_DMA_DisableFifoMode(dma->dma, dma->stream);
+    if (direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH) {
+        LL_DMA_ConfigAddresses(dma->dma, dma->stream, mem_addr, periph_addr, direction);
+    } else {
+        LL_DMA_ConfigAddresses(dma->dma, dma->stream, periph_addr, mem_addr, direction);
     }
-    while (LL_SPI_IsActiveFlag_BSY(priv->spi));
+    LL_DMA_SetDataLength(dma->dma, dma->stream, frames);
+
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Arms both DMA streams for a full-duplex transfer and starts it. A NULL buffer is replaced
+ * by a dummy one that is not incremented. Fails with E_DEVICE_BUSY while DMA2 serves GPIO
+ */
+static int32_t spi_dma_arm(const struct spi_priv * const priv, const void *write_data, void *read_data,
+    uint32_t frames, uint32_t align, uint32_t timeout)
+{
+    static const uint16_t dummy_tx = 0xffff;
+    static uint16_t dummy_rx;
+    int32_t ret;
+
+    if (priv->rx_dma.dma == DMA2 && dma2_port_acquire(DMA2_PORT_APB2) != E_SUCCESS) return E_DEVICE_BUSY;
+
+    if ((ret = spi_dma_config(&priv->rx_dma, LL_DMA_DIRECTION_PERIPH_TO_MEMORY, LL_SPI_DMA_GetRegAddr(priv->spi),
+        read_data != NULL ? (uint32_t)read_data : (uint32_t)&dummy_rx, frames,
+        align | (read_data != NULL ? LL_DMA_MEMORY_INCREMENT : LL_DMA_MEMORY_NOINCREMENT), timeout)) != E_SUCCESS) {
+        goto release;
+    }
+    if ((ret = spi_dma_config(&priv->tx_dma, LL_DMA_DIRECTION_MEMORY_TO_PERIPH, LL_SPI_DMA_GetRegAddr(priv->spi),
+        write_data != NULL ? (uint32_t)write_data : (uint32_t)&dummy_tx, frames,
+        align | (write_data != NULL ? LL_DMA_MEMORY_INCREMENT : LL_DMA_MEMORY_NOINCREMENT), timeout)) != E_SUCCESS) {
+        goto release;
+    }
+
+    // RX must be armed before TX so no frame is lost
+    LL_SPI_EnableDMAReq_RX(priv->spi);
+    LL_DMA_EnableStream(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_DMA_EnableStream(priv->tx_dma.dma, priv->tx_dma.stream);
+    LL_SPI_Enable(priv->spi);
+    LL_SPI_EnableDMAReq_TX(priv->spi);
+
+    return E_SUCCESS;
+
+    release:
+    if (priv->rx_dma.dma == DMA2) dma2_port_release(DMA2_PORT_APB2);
+    return ret;
+}
+
+static int32_t spi_dma_wait(const struct spi_priv * const priv, uint32_t timeout)
+{
+    uint32_t t = timeout;
+    while ((dma_get_flags(priv->rx_dma.dma, priv->rx_dma.stream) & (DMA_FLAG_TC | DMA_FLAG_TE)) == 0) {
+        if (t-- == 0) return E_TIMEOUT;
+    }
+
+    if ((dma_get_flags(priv->rx_dma.dma, priv->rx_dma.stream) & DMA_FLAG_TE) ||
+        (dma_get_flags(priv->tx_dma.dma, priv->tx_dma.stream) & DMA_FLAG_TE)) {
+        taskENTER_CRITICAL();
+        spi_state[priv->index].stats.dma_errors++;
+        taskEXIT_CRITICAL();
+        return E_DMA_ERROR;
+    }
+
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Stops both streams and the SPI. Everything is released even when a wait times out
+ *
+ * @return int32_t E_SUCCESS or E_TIMEOUT
+ */
+static int32_t spi_dma_disarm(const struct spi_priv * const priv, uint32_t timeout)
+{
+    int32_t ret = E_SUCCESS;
+
+    LL_SPI_DisableDMAReq_RX(priv->spi);
+    LL_SPI_DisableDMAReq_TX(priv->spi);
+    if (dma_stop_stream(priv->tx_dma.dma, priv->tx_dma.stream, timeout) != E_SUCCESS) ret = E_TIMEOUT;
+    if (dma_stop_stream(priv->rx_dma.dma, priv->rx_dma.stream, timeout) != E_SUCCESS) ret = E_TIMEOUT;
+    if (spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_BSY, 0, timeout) != E_SUCCESS) ret = E_TIMEOUT;
+    LL_SPI_Disable(priv->spi);
+    if (priv->rx_dma.dma == DMA2) dma2_port_release(DMA2_PORT_APB2);
+
+    return ret;
+}
+
+int32_t stm32f4xx_spi_set_prescaler(const struct spi_device * const spi, uint32_t prescaler, uint32_t timeout)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    uint32_t was_enabled = LL_SPI_IsEnabled(priv->spi);
+
+    if (spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_BSY, 0, timeout) != E_SUCCESS) return E_TIMEOUT;
+    LL_SPI_Disable(priv->spi);
+    LL_SPI_SetBaudRatePrescaler(priv->spi, prescaler);
+    if (was_enabled) LL_SPI_Enable(priv->spi);
+
+    return E_SUCCESS;
+}
+
+uint32_t stm32f4xx_spi_get_prescaler(const struct spi_device * const spi)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    return LL_SPI_GetBaudRatePrescaler(priv->spi);
+}
+
+int32_t stm32f4xx_spi_dma_start(const struct spi_device * const spi, struct spi_transaction * const transaction)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    uint32_t size;
+    int32_t ret = E_SUCCESS;
+
+    if (transaction == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (transaction->write_data != NULL && transaction->read_data != NULL &&
+        transaction->write_size != transaction->read_size) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    size = transaction->write_data != NULL ? transaction->write_size : transaction->read_size;
+    if (size == 0 || size > 0xffff) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = spi_wait_flag(priv->spi, LL_SPI_IsActiveFlag_BSY, 0, SPI_IDLE_TIMEOUT)) != E_SUCCESS) goto exit;
+    LL_SPI_Disable(priv->spi);
+    (void)LL_SPI_ReceiveData8(priv->spi);
+    if ((ret = spi_dma_arm(priv, transaction->write_data, transaction->read_data, size,
+        LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE, SPI_IDLE_TIMEOUT)) != E_SUCCESS) goto exit;
+    spi_account(priv, size);
 
     exit:
     return ret;
-}
\ No newline at end of file
+}
+
+int32_t stm32f4xx_spi_dma_wait(const struct spi_device * const spi, uint32_t timeout)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    int32_t ret, disarm;
+
+    if (!LL_DMA_IsEnabledStream(priv->rx_dma.dma, priv->rx_dma.stream) &&
+        (dma_get_flags(priv->rx_dma.dma, priv->rx_dma.stream) & (DMA_FLAG_TC | DMA_FLAG_TE)) == 0) {
+        ret = E_SUCCESS; // Nothing in flight
+        goto exit;
+    }
+
+    ret = spi_dma_wait(priv, timeout);
+    disarm = spi_dma_disarm(priv, timeout);
+    if (ret == E_SUCCESS) ret = disarm;
+
+    exit:
+    return ret;
+}
+
+int32_t stm32f4xx_spi_dma_busy(const struct spi_device * const spi)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    return (dma_get_flags(priv->rx_dma.dma, priv->rx_dma.stream) & (DMA_FLAG_TC | DMA_FLAG_TE)) == 0 &&
+        LL_DMA_IsEnabledStream(priv->rx_dma.dma, priv->rx_dma.stream);
+}
+
+int32_t stm32f4xx_spi_transact_crc(const struct spi_device * const spi, struct spi_transaction * const transaction,
+    const struct spi_crc_config * const crc, uint32_t timeout)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    uint32_t size, frames, align, was_enabled, t;
+    int32_t ret = E_SUCCESS, disarm;
+
+    if (transaction == NULL || crc == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (transaction->write_data == NULL && transaction->read_data == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (transaction->write_data != NULL && transaction->read_data != NULL &&
+        transaction->write_size != transaction->read_size) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    size = transaction->write_data != NULL ? transaction->write_size : transaction->read_size;
+    if (crc->width == SPI_CRC_16BIT) {
+        frames = size / sizeof(uint16_t);
+        align = LL_DMA_PDATAALIGN_HALFWORD | LL_DMA_MDATAALIGN_HALFWORD;
+    } else {
+        frames = size;
+        align = LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE;
+    }
+
+    if (frames == 0 || frames > 0xffff || (crc->width == SPI_CRC_16BIT && (size & 0x01))) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = spi_bus_lock(priv, timeout)) != E_SUCCESS) goto exit;
+
+    // CRC registers are only reset by toggling CRCEN while the SPI is disabled
+    was_enabled = LL_SPI_IsEnabled(priv->spi);
+    t = timeout;
+    while (LL_SPI_IsActiveFlag_BSY(priv->spi)) {
+        if (t-- == 0) {
+            spi_bus_unlock(priv);
+            ret = E_TIMEOUT;
+            goto exit;
+        }
+    }
+    LL_SPI_Disable(priv->spi);
+    LL_SPI_SetDataWidth(priv->spi, crc->width == SPI_CRC_16BIT ? LL_SPI_DATAWIDTH_16BIT : LL_SPI_DATAWIDTH_8BIT);
+    LL_SPI_DisableCRC(priv->spi);
+    LL_SPI_SetCRCPolynomial(priv->spi, crc->polynomial);
+    LL_SPI_EnableCRC(priv->spi);
+    LL_SPI_ClearFlag_CRCERR(priv->spi);
+    LL_SPI_ClearFlag_OVR(priv->spi);
+
+    // The TX CRC is appended by hardware when the TX stream is exhausted
+    if ((ret = spi_dma_arm(priv, transaction->write_data, transaction->read_data, frames, align,
+        timeout)) != E_SUCCESS) goto restore;
+    spi_account(priv, size);
+
+    if ((ret = spi_dma_wait(priv, timeout)) != E_SUCCESS) goto cleanup;
+
+    // The received CRC is not counted by the RX stream and is left in DR
+    LL_SPI_DisableDMAReq_RX(priv->spi);
+    LL_SPI_DisableDMAReq_TX(priv->spi);
+    t = timeout;
+    while (!LL_SPI_IsActiveFlag_RXNE(priv->spi)) {
+        if (t-- == 0) {
+            ret = E_TIMEOUT;
+            goto cleanup;
+        }
+    }
+    (void)LL_SPI_ReceiveData16(priv->spi);
+
+    t = timeout;
+    while (!LL_SPI_IsActiveFlag_TXE(priv->spi) || LL_SPI_IsActiveFlag_BSY(priv->spi)) {
+        if (t-- == 0) {
+            ret = E_TIMEOUT;
+            goto cleanup;
+        }
+    }
+
+    if (LL_SPI_IsActiveFlag_CRCERR(priv->spi)) {
+        LL_SPI_ClearFlag_CRCERR(priv->spi);
+        if (transaction->read_data != NULL) ret = E_CRC_MISMATCH;
+    }
+
+    cleanup:
+    disarm = spi_dma_disarm(priv, timeout);
+    if (ret == E_SUCCESS) ret = disarm;
+    restore:
+    LL_SPI_DisableCRC(priv->spi);
+    LL_SPI_SetDataWidth(priv->spi, LL_SPI_DATAWIDTH_8BIT);
+    if (was_enabled) LL_SPI_Enable(priv->spi);
+    spi_bus_unlock(priv);
+
+    exit:
+    return ret;
+}
+
+static int32_t stm32f4xx_spi2_slave_init(const struct spi_device * const spi)
+{
+    const LL_GPIO_InitTypeDef gpio_config = {
+        .Pin = LL_GPIO_PIN_12 | LL_GPIO_PIN_13 | LL_GPIO_PIN_15,
+        .Mode = LL_GPIO_MODE_ALTERNATE,
+        .Speed = LL_GPIO_SPEED_FREQ_VERY_HIGH,
+        .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
+        .Pull = LL_GPIO_PULL_NO,
+        .Alternate = LL_GPIO_AF_5
+    };
+
+    /**SPI2 GPIO Configuration
+    PB12   ------> SPI2_NSS
+    PB13   ------> SPI2_SCK
+    PB15   ------> SPI2_MOSI
+    */
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPIOB);
+    LL_GPIO_Init(GPIOB, (LL_GPIO_InitTypeDef *)&gpio_config);
+
+    const LL_SPI_InitTypeDef spi_config = {
+        .TransferDirection = LL_SPI_SIMPLEX_RX,
+        .Mode = LL_SPI_MODE_SLAVE,
+        .DataWidth = LL_SPI_DATAWIDTH_8BIT,
+        .ClockPolarity = LL_SPI_POLARITY_LOW,
+        .ClockPhase = LL_SPI_PHASE_1EDGE,
+        .NSS = LL_SPI_NSS_HARD_INPUT,
+        .BaudRate = LL_SPI_BAUDRATEPRESCALER_DIV2,
+        .BitOrder = LL_SPI_MSB_FIRST,
+        .CRCCalculation = LL_SPI_CRCCALCULATION_DISABLE,
+        .CRCPoly = 7
+    };
+
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_SPI2);
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+    LL_SPI_Disable(SPI2);
+    if (LL_SPI_Init(SPI2, (LL_SPI_InitTypeDef *)&spi_config) != SUCCESS) return E_HARDWARE_CONFIG_FAILED;
+    LL_SPI_SetStandard(SPI2, LL_SPI_PROTOCOL_MOTOROLA);
+
+    return E_SUCCESS;
+}
+
+// The slave is receive-only: data is delivered through the stm32f4xx_spi_slave_start() callback
+static int32_t stm32f4xx_spi_slave_write(const struct spi_device * const spi, const void *data, uint32_t size,
+    uint32_t timeout)
+{
+    return E_INVALID_PARAMETER;
+}
+
+static int32_t stm32f4xx_spi_slave_read(const struct spi_device * const spi, void *data, uint32_t size,
+    uint32_t timeout)
+{
+    return E_INVALID_PARAMETER;
+}
+
+static int32_t stm32f4xx_spi_slave_transact(const struct spi_device * const spi,
+    struct spi_transaction * const transaction, uint32_t timeout)
+{
+    return E_INVALID_PARAMETER;
+}
+
+static void spi_slave_dma_handler(void *arg, uint32_t flags)
+{
+    const struct spi_device *spi = (const struct spi_device *)arg;
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    struct spi_state *state = &spi_state[priv->index];
+    uint32_t half = state->slave_size / 2;
+    uint32_t mask;
+
+    if (flags & DMA_FLAG_TE) {
+        mask = taskENTER_CRITICAL_FROM_ISR();
+        state->stats.dma_errors++;
+        taskEXIT_CRITICAL_FROM_ISR(mask);
+    }
+
+    // Both halves completed since the last interrupt: the older one was already overwritten
+    if ((flags & (DMA_FLAG_HT | DMA_FLAG_TC)) == (DMA_FLAG_HT | DMA_FLAG_TC)) state->slave_overruns++;
+
+    if (LL_SPI_IsActiveFlag_OVR(priv->spi)) {
+        LL_SPI_ClearFlag_OVR(priv->spi);
+        state->slave_overruns++;
+    }
+
+    if (flags & DMA_FLAG_TC)        state->slave_callback(state->slave_arg, &state->slave_buffer[half], half);
+    else if (flags & DMA_FLAG_HT)   state->slave_callback(state->slave_arg, state->slave_buffer, half);
+}
+
+int32_t stm32f4xx_spi_slave_start(const struct spi_device * const spi, void *buffer, uint32_t size,
+    spi_slave_callback callback, void *arg)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    struct spi_state *state = &spi_state[priv->index];
+    int32_t ret;
+
+    if (buffer == NULL || callback == NULL || size < 2 || size > 0xffff || (size & 0x01)) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    // Fails while the slave or I2S2 full-duplex, which shares the stream, is running
+    if ((ret = dma_set_handler(&priv->rx_dma, spi_slave_dma_handler, (void *)spi)) != E_SUCCESS) goto exit;
+
+    state->slave_buffer = (uint8_t *)buffer;
+    state->slave_size = size;
+    state->slave_callback = callback;
+    state->slave_arg = arg;
+    state->slave_overruns = 0;
+
+    dma_stop_stream(priv->rx_dma.dma, priv->rx_dma.stream, DMA_STOP_TIMEOUT);
+    LL_DMA_SetChannelSelection(priv->rx_dma.dma, priv->rx_dma.stream, priv->rx_dma.channel);
+    LL_DMA_ConfigTransfer(priv->rx_dma.dma, priv->rx_dma.stream, LL_DMA_DIRECTION_PERIPH_TO_MEMORY |
+        LL_DMA_MODE_CIRCULAR | LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_BYTE |
+        LL_DMA_MDATAALIGN_BYTE | LL_DMA_PRIORITY_VERYHIGH);
+    LL_DMA_DisableFifoMode(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_DMA_ConfigAddresses(priv->rx_dma.dma, priv->rx_dma.stream, LL_SPI_DMA_GetRegAddr(priv->spi),
+        (uint32_t)buffer, LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+    LL_DMA_SetDataLength(priv->rx_dma.dma, priv->rx_dma.stream, size);
+    LL_DMA_EnableIT_HT(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_DMA_EnableIT_TC(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_DMA_EnableIT_TE(priv->rx_dma.dma, priv->rx_dma.stream);
+
+    (void)LL_SPI_ReceiveData8(priv->spi);
+    LL_SPI_ClearFlag_OVR(priv->spi);
+    LL_SPI_EnableDMAReq_RX(priv->spi);
+    LL_DMA_EnableStream(priv->rx_dma.dma, priv->rx_dma.stream);
+    LL_SPI_Enable(priv->spi);
+
+    exit:
+    return ret;
+}
+
+int32_t stm32f4xx_spi_slave_stop(const struct spi_device * const spi)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    struct spi_state *state = &spi_state[priv->index];
+
+    // Not running: the stream may belong to I2S2 full-duplex
+    if (state->slave_callback == NULL) return E_SUCCESS;
+
+    LL_SPI_Disable(priv->spi);
+    LL_SPI_DisableDMAReq_RX(priv->spi);
+    dma_stop_stream(priv->rx_dma.dma, priv->rx_dma.stream, DMA_STOP_TIMEOUT);
+    dma_clear_handler(&priv->rx_dma);
+    state->slave_callback = NULL;
+
+    return E_SUCCESS;
+}
+
+uint32_t stm32f4xx_spi_slave_overruns(const struct spi_device * const spi)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    return spi_state[priv->index].slave_overruns;
+}
+
+int32_t stm32f4xx_spi_lock(const struct spi_device * const spi, uint32_t timeout)
+{
+    return spi_bus_lock((const struct spi_priv *)spi->priv, timeout);
+}
+
+void stm32f4xx_spi_unlock(const struct spi_device * const spi)
+{
+    spi_bus_unlock((const struct spi_priv *)spi->priv);
+}
+
+int32_t stm32f4xx_spi_get_stats(const struct spi_device * const spi, struct spi_stats * const stats)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+
+    if (stats == NULL) return E_INVALID_PARAMETER;
+
+    taskENTER_CRITICAL();
+    *stats = spi_state[priv->index].stats;
+    taskEXIT_CRITICAL();
+
+    return E_SUCCESS;
+}
+
+int32_t stm32f4xx_spi_reset_stats(const struct spi_device * const spi, uint32_t timeout)
+{
+    const struct spi_priv *priv = (const struct spi_priv *)spi->priv;
+    struct spi_state *state = &spi_state[priv->index];
+    // Counters other than dma_errors and queue_depth are only touched by the bus owner.
+    // Without a mutex the bus was never initialized and nobody can be updating them
+    int32_t ret = spi_bus_lock(priv, timeout);
+
+    if (ret == E_TIMEOUT) return ret;
+
+    taskENTER_CRITICAL();
+    state->stats.transactions = 0;
+    state->stats.bytes = 0;
+    state->stats.bus_cycles = 0;
+    state->stats.wait_cycles = 0;
+    state->stats.queue_depth_max = state->stats.queue_depth;
+    state->stats.dma_errors = 0;
+    taskEXIT_CRITICAL();
+
+    if (ret == E_SUCCESS) {
+        state->lock_cycles = dwt_cycles(); // Do not account this call as bus time
+        spi_bus_unlock(priv);
+    }
+
+    return E_SUCCESS;
+}
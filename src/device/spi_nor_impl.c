@@ -0,0 +1,489 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/spi_nor.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "include/errors.h"
+#include "include/device/spi.h"
+#include "include/stm32f4xx/spi.h"
+#include "include/stm32f4xx/dwt.h"
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_gpio.h"
+#include "stm32f4xx_ll_bus.h"
+#include "stm32f4xx_ll_spi.h"
+
+#include "FreeRTOS.h"
+
+// Number of NOR flashes available
+#define AVAILABLE_NORS  1
+
+#define CMD_WRITE_ENABLE    0x06
+#define CMD_READ_STATUS     0x05
+#define CMD_FAST_READ       0x0b
+#define CMD_PAGE_PROGRAM    0x02
+#define CMD_ERASE_4K        0x20
+#define CMD_ERASE_64K       0xd8
+#define CMD_ERASE_CHIP      0xc7
+#define CMD_READ_ID         0x9f
+#define CMD_RELEASE_PD      0xab
+
+#define STATUS_WIP          0x01
+
+// Time the flash needs after release from power-down before it accepts commands
+#define NOR_TRES1_US        3
+
+struct spi_nor_priv {
+    GPIO_TypeDef    *cs_gpio;
+    uint32_t        cs_pin;
+    uint32_t        cs_ahb1_grp1_periph;
+    uint32_t        prescaler;
+    uint32_t        size;
+    int             index;
+};
+
+struct spi_nor_state {
+    uint8_t     readahead[2][SPI_NOR_READAHEAD_SIZE];
+    uint8_t     cmd[5];
+    uint32_t    stream_addr;    // Address of the next block to fetch
+    uint32_t    fetch_size;     // Size of the block being fetched
+    uint8_t     fetch_buffer;   // Read-ahead buffer being filled by DMA
+    uint8_t     streaming;
+    uint8_t     busy;           // A program or erase may still be running
+    uint32_t    bus_prescaler;  // Prescaler of the bus before it was selected
+};
+
+static struct spi_nor_state nor_state[AVAILABLE_NORS];
+
+extern const struct spi_device spi1;
+
+static const struct spi_nor_priv spi_nor1_priv = {
+    .cs_gpio = GPIOC,
+    .cs_pin = LL_GPIO_PIN_4,
+    .cs_ahb1_grp1_periph = LL_AHB1_GRP1_PERIPH_GPIOC,
+    .prescaler = LL_SPI_BAUDRATEPRESCALER_DIV2,
+    .size = 16 * 1024 * 1024,
+    .index = 0
+};
+
+const struct spi_nor_device spi_nor1 = {
+    .spi = &spi1,
+    .priv = &spi_nor1_priv
+};
+
+// Implementation
+
+// The bus is held for as long as chip select is asserted
+static int32_t nor_select(const struct spi_nor_device * const nor)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    int32_t ret;
+
+    if ((ret = stm32f4xx_spi_lock(nor->spi, portMAX_DELAY)) != E_SUCCESS) goto exit;
+    nor_state[priv->index].bus_prescaler = stm32f4xx_spi_get_prescaler(nor->spi);
+    if ((ret = stm32f4xx_spi_set_prescaler(nor->spi, priv->prescaler, SPI_IDLE_TIMEOUT)) != E_SUCCESS) {
+        stm32f4xx_spi_unlock(nor->spi);
+        goto exit;
+    }
+    LL_GPIO_ResetOutputPin(priv->cs_gpio, priv->cs_pin);
+
+    exit:
+    return ret;
+}
+
+static void nor_deselect(const struct spi_nor_device * const nor)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    LL_GPIO_SetOutputPin(priv->cs_gpio, priv->cs_pin);
+    // Other users of the bus keep their own clock
+    stm32f4xx_spi_set_prescaler(nor->spi, nor_state[priv->index].bus_prescaler, SPI_IDLE_TIMEOUT);
+    stm32f4xx_spi_unlock(nor->spi);
+}
+
+static int32_t nor_xfer(const struct spi_nor_device * const nor, const void *write_data, void *read_data,
+    uint32_t size, uint32_t timeout)
+{
+    int32_t ret;
+    struct spi_transaction transaction = {
+        .write_data = write_data,
+        .write_size = size,
+        .read_data = read_data,
+        .read_size = size
+    };
+
+    if ((ret = stm32f4xx_spi_dma_start(nor->spi, &transaction)) != E_SUCCESS) goto exit;
+    ret = stm32f4xx_spi_dma_wait(nor->spi, timeout);
+
+    exit:
+    return ret;
+}
+
+static int32_t nor_command(const struct spi_nor_device * const nor, uint8_t cmd, uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    int32_t ret;
+
+    state->cmd[0] = cmd;
+    if ((ret = nor_select(nor)) != E_SUCCESS) goto exit;
+    ret = nor_xfer(nor, state->cmd, NULL, 1, timeout);
+    nor_deselect(nor);
+
+    exit:
+    return ret;
+}
+
+static int32_t nor_address_command(const struct spi_nor_device * const nor, uint8_t cmd, uint32_t addr,
+    uint32_t size, uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+
+    state->cmd[0] = cmd;
+    state->cmd[1] = (uint8_t)(addr >> 16);
+    state->cmd[2] = (uint8_t)(addr >> 8);
+    state->cmd[3] = (uint8_t)(addr);
+    state->cmd[4] = 0xff; // Dummy byte, only sent for fast-read
+
+    return nor_xfer(nor, state->cmd, NULL, size, timeout);
+}
+
+// Starts fetching one block into the idle read-ahead buffer. Chip select is left asserted
+static int32_t nor_fetch_start(const struct spi_nor_device * const nor, uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    int32_t ret;
+
+    state->fetch_size = priv->size - state->stream_addr;
+    if (state->fetch_size > SPI_NOR_READAHEAD_SIZE) state->fetch_size = SPI_NOR_READAHEAD_SIZE;
+    if (state->fetch_size == 0) {
+        ret = E_SUCCESS;
+        goto exit;
+    }
+
+    if ((ret = nor_select(nor)) != E_SUCCESS) goto exit;
+    if ((ret = nor_address_command(nor, CMD_FAST_READ, state->stream_addr, 5, timeout)) != E_SUCCESS) {
+        nor_deselect(nor);
+        goto exit;
+    }
+
+    struct spi_transaction transaction = {
+        .write_data = NULL,
+        .read_data = state->readahead[state->fetch_buffer],
+        .read_size = state->fetch_size
+    };
+    if ((ret = stm32f4xx_spi_dma_start(nor->spi, &transaction)) != E_SUCCESS) {
+        nor_deselect(nor);
+        goto exit;
+    }
+    state->stream_addr += state->fetch_size;
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_wait_ready(const struct spi_nor_device * const nor, uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    uint32_t t = timeout;
+    int32_t ret;
+
+    if (!state->busy) return E_SUCCESS;
+
+    while ((ret = spi_nor_is_busy(nor)) == 1) {
+        if (t-- == 0) {
+            ret = E_TIMEOUT;
+            goto exit;
+        }
+    }
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_is_busy(const struct spi_nor_device * const nor)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    uint8_t status[2];
+    int32_t ret;
+
+    if (!state->busy) {
+        ret = 0;
+        goto exit;
+    }
+
+    state->cmd[0] = CMD_READ_STATUS;
+    state->cmd[1] = 0xff;
+    if ((ret = nor_select(nor)) != E_SUCCESS) goto exit;
+    ret = nor_xfer(nor, state->cmd, status, sizeof(status), UINT32_MAX);
+    nor_deselect(nor);
+    if (ret != E_SUCCESS) goto exit;
+
+    state->busy = (status[1] & STATUS_WIP) != 0;
+    ret = state->busy;
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_init(const struct spi_nor_device * const nor)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+
+    const LL_GPIO_InitTypeDef cs_config = {
+        .Pin = priv->cs_pin,
+        .Mode = LL_GPIO_MODE_OUTPUT,
+        .Speed = LL_GPIO_SPEED_FREQ_VERY_HIGH,
+        .OutputType = LL_GPIO_OUTPUT_PUSHPULL,
+        .Pull = LL_GPIO_PULL_UP,
+    };
+
+    LL_AHB1_GRP1_EnableClock(priv->cs_ahb1_grp1_periph);
+    LL_GPIO_SetOutputPin(priv->cs_gpio, priv->cs_pin);
+    LL_GPIO_Init(priv->cs_gpio, (LL_GPIO_InitTypeDef *)&cs_config);
+
+    nor_state[priv->index].streaming = 0;
+    nor_state[priv->index].busy = 1; // Unknown until the status register says otherwise
+
+    // Flash may have been left in deep power-down
+    int32_t ret = nor_command(nor, CMD_RELEASE_PD, UINT32_MAX);
+    if (ret == E_SUCCESS) {
+        dwt_init();
+        uint32_t start = dwt_cycles();
+        while (dwt_cycles() - start < NOR_TRES1_US * (SystemCoreClock / 1000000));
+    }
+
+    return ret;
+}
+
+int32_t spi_nor_read_id(const struct spi_nor_device * const nor, uint8_t id[3], uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    uint8_t answer[4];
+    int32_t ret;
+
+    if (id == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    state->cmd[0] = CMD_READ_ID;
+    state->cmd[1] = state->cmd[2] = state->cmd[3] = 0xff;
+    if ((ret = nor_select(nor)) != E_SUCCESS) goto exit;
+    ret = nor_xfer(nor, state->cmd, answer, sizeof(answer), timeout);
+    nor_deselect(nor);
+    if (ret != E_SUCCESS) goto exit;
+
+    id[0] = answer[1];
+    id[1] = answer[2];
+    id[2] = answer[3];
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_read(const struct spi_nor_device * const nor, uint32_t addr, void *data, uint32_t size,
+    uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    uint8_t *udata = (uint8_t *)data;
+    uint32_t done = 0;
+    int32_t ret;
+
+    if (data == NULL || addr >= priv->size || size > priv->size - addr || state->streaming) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = spi_nor_wait_ready(nor, timeout)) != E_SUCCESS) goto exit;
+
+    if ((ret = nor_select(nor)) != E_SUCCESS) goto exit;
+    if ((ret = nor_address_command(nor, CMD_FAST_READ, addr, 5, timeout)) != E_SUCCESS) goto deselect;
+
+    // A single fast-read can go on forever, only the DMA counter is limited
+    while (done < size) {
+        uint32_t chunk = size - done;
+        if (chunk > 0xffff) chunk = 0xffff;
+        if ((ret = nor_xfer(nor, NULL, &udata[done], chunk, timeout)) != E_SUCCESS) goto deselect;
+        done += chunk;
+    }
+    ret = done;
+
+    deselect:
+    nor_deselect(nor);
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_stream_open(const struct spi_nor_device * const nor, uint32_t addr, uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    int32_t ret;
+
+    if (addr >= priv->size || state->streaming) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = spi_nor_wait_ready(nor, timeout)) != E_SUCCESS) goto exit;
+
+    state->stream_addr = addr;
+    state->fetch_buffer = 0;
+    if ((ret = nor_fetch_start(nor, timeout)) != E_SUCCESS) goto exit;
+    state->streaming = 1;
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_stream_next(const struct spi_nor_device * const nor, const void **data, uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    uint32_t ready_buffer, ready_size;
+    int32_t ret;
+
+    if (data == NULL || !state->streaming) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (state->fetch_size == 0) {
+        ret = 0; // End of flash
+        goto exit;
+    }
+
+    ret = stm32f4xx_spi_dma_wait(nor->spi, timeout);
+    nor_deselect(nor);
+    if (ret != E_SUCCESS) {
+        state->streaming = 0;
+        goto exit;
+    }
+
+    ready_buffer = state->fetch_buffer;
+    ready_size = state->fetch_size;
+
+    // Fetch the next block while the caller consumes this one
+    state->fetch_buffer ^= 1;
+    if ((ret = nor_fetch_start(nor, timeout)) != E_SUCCESS) {
+        state->streaming = 0;
+        goto exit;
+    }
+
+    *data = state->readahead[ready_buffer];
+    ret = ready_size;
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_stream_close(const struct spi_nor_device * const nor, uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    int32_t ret = E_SUCCESS;
+
+    if (!state->streaming) goto exit;
+
+    // Past the end of the flash nothing is fetched and the bus is not held
+    if (state->fetch_size != 0) {
+        ret = stm32f4xx_spi_dma_wait(nor->spi, timeout);
+        nor_deselect(nor);
+    }
+    state->streaming = 0;
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_program(const struct spi_nor_device * const nor, uint32_t addr, const void *data, uint32_t size,
+    uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    const uint8_t *udata = (const uint8_t *)data;
+    uint32_t done = 0;
+    int32_t ret;
+
+    if (data == NULL || addr >= priv->size || size > priv->size - addr || state->streaming) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    while (done < size) {
+        // A page program wraps around inside the page, so never cross its boundary
+        uint32_t chunk = SPI_NOR_PAGE_SIZE - ((addr + done) % SPI_NOR_PAGE_SIZE);
+        if (chunk > size - done) chunk = size - done;
+
+        // The WIP poll for the previous page is deferred to here, so the last one is left programming
+        if ((ret = spi_nor_wait_ready(nor, timeout)) != E_SUCCESS) goto exit;
+        if ((ret = nor_command(nor, CMD_WRITE_ENABLE, timeout)) != E_SUCCESS) goto exit;
+
+        if ((ret = nor_select(nor)) != E_SUCCESS) goto exit;
+        if ((ret = nor_address_command(nor, CMD_PAGE_PROGRAM, addr + done, 4, timeout)) == E_SUCCESS) {
+            ret = nor_xfer(nor, &udata[done], NULL, chunk, timeout);
+        }
+        nor_deselect(nor);
+        if (ret != E_SUCCESS) goto exit;
+
+        state->busy = 1;
+        done += chunk;
+    }
+    ret = done;
+
+    exit:
+    return ret;
+}
+
+int32_t spi_nor_erase(const struct spi_nor_device * const nor, uint32_t addr, enum spi_nor_erase type,
+    uint32_t timeout)
+{
+    const struct spi_nor_priv *priv = (const struct spi_nor_priv *)nor->priv;
+    struct spi_nor_state *state = &nor_state[priv->index];
+    int32_t ret;
+
+    if (addr >= priv->size || state->streaming) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = spi_nor_wait_ready(nor, timeout)) != E_SUCCESS) goto exit;
+    if ((ret = nor_command(nor, CMD_WRITE_ENABLE, timeout)) != E_SUCCESS) goto exit;
+
+    switch (type) {
+    case SPI_NOR_ERASE_4K:
+    case SPI_NOR_ERASE_64K:
+        if ((ret = nor_select(nor)) != E_SUCCESS) goto exit;
+        ret = nor_address_command(nor, type == SPI_NOR_ERASE_4K ? CMD_ERASE_4K : CMD_ERASE_64K, addr, 4, timeout);
+        nor_deselect(nor);
+        break;
+
+    case SPI_NOR_ERASE_CHIP:
+        ret = nor_command(nor, CMD_ERASE_CHIP, timeout);
+        break;
+
+    default:
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (ret == E_SUCCESS) state->busy = 1;
+
+    exit:
+    return ret;
+}
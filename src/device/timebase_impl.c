@@ -0,0 +1,27 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/timebase.h"
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_tim.h"
+
+volatile uint32_t timebase_overflows;
+
+void TIM5_IRQHandler(void)
+{
+    if (LL_TIM_IsActiveFlag_UPDATE(TIMEBASE_TIM) == 0) return;
+
+    LL_TIM_ClearFlag_UPDATE(TIMEBASE_TIM);
+    // Readers can't run in between, see TIMEBASE_IRQ_PRIORITY
+    timebase_overflows++;
+    // The write to SR must reach TIM5 before returning or the IRQ is taken again
+    __DSB();
+}
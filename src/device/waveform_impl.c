@@ -0,0 +1,308 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/stm32f4xx/waveform.h"
+
+#include "include/errors.h"
+#include "include/stm32f4xx/dma.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_bus.h"
+#include "stm32f4xx_ll_dma.h"
+#include "stm32f4xx_ll_tim.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+// Only DMA2 reaches the GPIO ports, and TIM8_UP is on stream 1 channel 7
+#define WAVEFORM_TIM        TIM8
+#define WAVEFORM_MAX_WORDS  0xffff
+
+enum waveform_ending {
+    WAVEFORM_REFILLING,     // refill keeps being called
+    WAVEFORM_LAST_QUEUED,   // Buffer queued after the playing one has the last words
+    WAVEFORM_LAST_PLAYING,  // Playing buffer has the last words
+};
+
+struct waveform_state {
+    uint32_t                *buffers[2];
+    uint32_t                count;
+    waveform_refill         refill;     // NULL when playing a single buffer
+    void                    *arg;
+    enum waveform_ending    ending;
+    volatile uint32_t       running;
+    volatile int32_t        status;     // Outcome of the last waveform
+    SemaphoreHandle_t       done;       // Given when a waveform ends
+};
+
+static const struct dma_stream waveform_dma = {
+    .dma = DMA2,
+    .stream = LL_DMA_STREAM_1,
+    .channel = LL_DMA_CHANNEL_7,
+    .irqn = DMA2_Stream1_IRQn,
+};
+
+static struct waveform_state waveform;
+
+static void waveform_dma_handler(void *arg, uint32_t flags);
+
+static int32_t waveform_init(void)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (waveform.done == NULL) waveform.done = xSemaphoreCreateBinary();
+
+    if (waveform.done == NULL) {
+        ret = E_HARDWARE_CONFIG_FAILED;
+        goto exit;
+    }
+
+    LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM8);
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Gives the engine and its claim of DMA2 back
+ */
+static void waveform_release(void)
+{
+    waveform.running = 0;
+    dma2_port_release(DMA2_PORT_AHB);
+}
+
+/**
+ * @brief Takes the engine for a new waveform
+ */
+static int32_t waveform_claim(GPIO_TypeDef *port, uint32_t count, uint32_t period)
+{
+    int32_t ret;
+
+    if (port == NULL || count == 0 || count > WAVEFORM_MAX_WORDS || period < 2) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = waveform_init()) != E_SUCCESS) goto exit;
+
+    taskENTER_CRITICAL();
+    // DMA2 must not be serving SPI1 at the same time, see dma2_port
+    if (waveform.running) ret = E_DEVICE_BUSY;
+    else                  ret = dma2_port_acquire(DMA2_PORT_AHB);
+    if (ret == E_SUCCESS) waveform.running = 1;
+    taskEXIT_CRITICAL();
+    if (ret != E_SUCCESS) goto exit;
+
+    // Claims the stream before anything is touched
+    if ((ret = dma_set_handler(&waveform_dma, waveform_dma_handler, NULL)) != E_SUCCESS) {
+        waveform_release();
+        goto exit;
+    }
+
+    // Forget the end of the previous waveform if nobody waited for it
+    xSemaphoreTake(waveform.done, 0);
+    waveform.status = E_SUCCESS;
+
+    exit:
+    return ret;
+}
+
+static void waveform_timer_config(uint32_t period)
+{
+    // Largest prescaler step first so that ARR fits in 16 bits
+    uint32_t prescaler = (period - 1) >> 16;
+
+    LL_TIM_DisableCounter(WAVEFORM_TIM);
+    LL_TIM_DisableDMAReq_UPDATE(WAVEFORM_TIM);
+    LL_TIM_SetPrescaler(WAVEFORM_TIM, prescaler);
+    LL_TIM_SetAutoReload(WAVEFORM_TIM, period / (prescaler + 1) - 1);
+    LL_TIM_SetCounter(WAVEFORM_TIM, 0);
+    // Loads the prescaler. UDE is still clear so no word is sent
+    LL_TIM_GenerateEvent_UPDATE(WAVEFORM_TIM);
+    LL_TIM_ClearFlag_UPDATE(WAVEFORM_TIM);
+}
+
+static void waveform_dma_config(GPIO_TypeDef *port, const uint32_t *words, uint32_t count, uint32_t mode)
+{
+    LL_DMA_SetChannelSelection(waveform_dma.dma, waveform_dma.stream, waveform_dma.channel);
+    LL_DMA_ConfigTransfer(waveform_dma.dma, waveform_dma.stream, LL_DMA_DIRECTION_MEMORY_TO_PERIPH | mode |
+        LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_WORD | LL_DMA_MDATAALIGN_WORD |
+        LL_DMA_PRIORITY_VERYHIGH);
+    LL_DMA_DisableFifoMode(waveform_dma.dma, waveform_dma.stream);
+    LL_DMA_ConfigAddresses(waveform_dma.dma, waveform_dma.stream, (uint32_t)words, (uint32_t)&port->BSRR,
+        LL_DMA_DIRECTION_MEMORY_TO_PERIPH);
+    LL_DMA_SetDataLength(waveform_dma.dma, waveform_dma.stream, count);
+    LL_DMA_EnableIT_TC(waveform_dma.dma, waveform_dma.stream);
+    LL_DMA_EnableIT_TE(waveform_dma.dma, waveform_dma.stream);
+    LL_DMA_EnableIT_DME(waveform_dma.dma, waveform_dma.stream);
+}
+
+static void waveform_halt(void)
+{
+    LL_TIM_DisableCounter(WAVEFORM_TIM);
+    LL_TIM_DisableDMAReq_UPDATE(WAVEFORM_TIM);
+    dma_stop_stream(waveform_dma.dma, waveform_dma.stream, DMA_STOP_TIMEOUT);
+    LL_DMA_DisableDoubleBufferMode(waveform_dma.dma, waveform_dma.stream);
+    dma_clear_handler(&waveform_dma);
+}
+
+static void waveform_clear(uint32_t *buffer, uint32_t from, uint32_t count)
+{
+    // Zero words leave the port untouched
+    for (uint32_t i = from; i < count; i++) buffer[i] = 0;
+}
+
+/**
+ * @brief Refills buffer and tracks where the waveform ends
+ */
+static void waveform_fill(uint32_t *buffer)
+{
+    uint32_t words = waveform.refill(waveform.arg, buffer, waveform.count);
+
+    if (words >= waveform.count) return;
+
+    waveform_clear(buffer, words, waveform.count);
+    // With nothing in it, the buffer playing now is the last one
+    waveform.ending = words == 0 ? WAVEFORM_LAST_PLAYING : WAVEFORM_LAST_QUEUED;
+}
+
+static void waveform_finish(int32_t status, BaseType_t *context_switch)
+{
+    waveform_halt();
+    waveform.status = status;
+    waveform_release();
+    xSemaphoreGiveFromISR(waveform.done, context_switch);
+}
+
+static void waveform_dma_handler(void *arg, uint32_t flags)
+{
+    BaseType_t context_switch = pdFALSE;
+    (void)arg;
+
+    if (flags & DMA_FLAG_ERRORS) {
+        waveform_finish(E_DMA_ERROR, &context_switch);
+    } else if (flags & DMA_FLAG_TC) {
+        if (waveform.refill == NULL || waveform.ending == WAVEFORM_LAST_PLAYING) {
+            waveform_finish(E_SUCCESS, &context_switch);
+        } else {
+            // The stream already switched, the buffer that was played is the other one
+            uint32_t *played = waveform.buffers[LL_DMA_GetCurrentTargetMem(waveform_dma.dma, waveform_dma.stream) ==
+                LL_DMA_CURRENTTARGETMEM1 ? 0 : 1];
+
+            if (waveform.ending == WAVEFORM_LAST_QUEUED) {
+                // Played again after the last words, if the interrupt is late to stop the stream
+                waveform_clear(played, 0, waveform.count);
+                waveform.ending = WAVEFORM_LAST_PLAYING;
+            } else {
+                waveform_fill(played);
+            }
+        }
+    }
+
+    portYIELD_FROM_ISR(context_switch);
+}
+
+static void waveform_begin(void)
+{
+    LL_DMA_EnableStream(waveform_dma.dma, waveform_dma.stream);
+    LL_TIM_EnableDMAReq_UPDATE(WAVEFORM_TIM);
+    // First word is written one period from now
+    LL_TIM_EnableCounter(WAVEFORM_TIM);
+}
+
+int32_t waveform_play(GPIO_TypeDef *port, const uint32_t *words, uint32_t count, uint32_t period)
+{
+    int32_t ret;
+
+    if (words == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = waveform_claim(port, count, period)) != E_SUCCESS) goto exit;
+
+    waveform.refill = NULL;
+    waveform_timer_config(period);
+    waveform_dma_config(port, words, count, LL_DMA_MODE_NORMAL);
+    waveform_begin();
+
+    exit:
+    return ret;
+}
+
+int32_t waveform_stream(GPIO_TypeDef *port, uint32_t * const buffers[2], uint32_t count, uint32_t period,
+    waveform_refill refill, void *arg)
+{
+    int32_t ret;
+
+    if (buffers == NULL || buffers[0] == NULL || buffers[1] == NULL || refill == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = waveform_claim(port, count, period)) != E_SUCCESS) goto exit;
+
+    waveform.buffers[0] = buffers[0];
+    waveform.buffers[1] = buffers[1];
+    waveform.count = count;
+    waveform.refill = refill;
+    waveform.arg = arg;
+    waveform.ending = WAVEFORM_REFILLING;
+
+    waveform_fill(buffers[0]);
+    if (waveform.ending == WAVEFORM_LAST_PLAYING) {
+        // Nothing to play at all
+        dma_clear_handler(&waveform_dma);
+        waveform_release();
+        xSemaphoreGive(waveform.done);
+        goto exit;
+    }
+
+    if (waveform.ending == WAVEFORM_LAST_QUEUED) {
+        waveform_clear(buffers[1], 0, count);
+        waveform.ending = WAVEFORM_LAST_PLAYING;
+    } else {
+        waveform_fill(buffers[1]);
+    }
+
+    waveform_timer_config(period);
+    waveform_dma_config(port, buffers[0], count, LL_DMA_MODE_CIRCULAR);
+    LL_DMA_SetMemory1Address(waveform_dma.dma, waveform_dma.stream, (uint32_t)buffers[1]);
+    LL_DMA_SetCurrentTargetMem(waveform_dma.dma, waveform_dma.stream, LL_DMA_CURRENTTARGETMEM0);
+    LL_DMA_EnableDoubleBufferMode(waveform_dma.dma, waveform_dma.stream);
+    waveform_begin();
+
+    exit:
+    return ret;
+}
+
+int32_t waveform_wait(uint32_t timeout)
+{
+    if (waveform.done == NULL) return E_NOT_INITIALIZED;
+    if (xSemaphoreTake(waveform.done, timeout) == pdFAIL) return E_TIMEOUT;
+    return waveform.status;
+}
+
+void waveform_stop(void)
+{
+    if (waveform.done == NULL) return;
+
+    taskENTER_CRITICAL();
+    if (waveform.running) {
+        waveform_halt();
+        waveform_release();
+        xSemaphoreGive(waveform.done);
+    }
+    taskEXIT_CRITICAL();
+}
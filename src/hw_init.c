@@ -9,6 +9,13 @@
 #include "include/hw_init.h"
 #include "include/device/device.h"
 #include "include/errors.h"
+#include "include/stm32f4xx/hw_init.h"
+#include "include/stm32f4xx/device.h"
+#include "include/stm32f4xx/dwt.h"
+#include "include/stm32f4xx/rtc.h"
+#include "include/stm32f4xx/timebase.h"
+
+#include <stddef.h>
 
 #include "stm32f4xx.h"
 #include "stm32f4xx_ll_system.h"
@@ -16,6 +23,107 @@
 #include "stm32f4xx_ll_rcc.h"
 #include "stm32f4xx_ll_utils.h"
 
+// PLLI2S input is HSE / PLLM, shared with the main PLL
+#define PLLI2S_INPUT_HZ     (HSE_VALUE / 4)
+#define PLLI2S_N_MIN        50
+#define PLLI2S_N_MAX        432
+#define PLLI2S_R_MIN        2
+#define PLLI2S_R_MAX        7
+#define PLLI2S_VCO_MIN_HZ   100000000ULL
+#define PLLI2S_VCO_MAX_HZ   432000000ULL
+#define I2SCLK_MAX_HZ       192000000ULL
+#define I2S_PRESCALER_MIN   4
+#define I2S_PRESCALER_MAX   511
+
+struct plli2s_config {
+    uint32_t n;
+    uint32_t r;
+    uint32_t prescaler;
+};
+
+/**
+ * @brief Searches every valid N, R and I2S prescaler for the one closest to sample_rate.
+ * Fs = PLLI2S_INPUT_HZ * N / (R * divider * prescaler). Fails if even the closest one is further
+ * than HW_INIT_I2S_MAX_ERROR_PPM away
+ */
+static int32_t plli2s_search(uint32_t sample_rate, uint32_t divider, struct plli2s_config * const best)
+{
+    // Error is kept as a fraction err_num / err_den (Hz) so no floating point is needed
+    uint64_t best_num = UINT64_MAX, best_den = 1;
+
+    if (sample_rate == 0) return E_INVALID_PARAMETER;
+
+    for (uint32_t n = PLLI2S_N_MIN; n <= PLLI2S_N_MAX; n++) {
+        uint64_t vco = (uint64_t)PLLI2S_INPUT_HZ * n;
+        if (vco < PLLI2S_VCO_MIN_HZ || vco > PLLI2S_VCO_MAX_HZ) continue;
+
+        for (uint32_t r = PLLI2S_R_MIN; r <= PLLI2S_R_MAX; r++) {
+            if (vco / r > I2SCLK_MAX_HZ) continue;
+
+            uint64_t per_prescaler = (uint64_t)sample_rate * divider * r;
+            uint64_t p = (vco + per_prescaler / 2) / per_prescaler;
+            if (p < I2S_PRESCALER_MIN || p > I2S_PRESCALER_MAX) continue;
+
+            uint64_t target = per_prescaler * p;
+            uint64_t num = vco > target ? vco - target : target - vco;
+            uint64_t den = (uint64_t)divider * r * p;
+            if (num * best_den < best_num * den) {
+                best_num = num;
+                best_den = den;
+                best->n = n;
+                best->r = r;
+                best->prescaler = (uint32_t)p;
+            }
+        }
+    }
+
+    if (best_num == UINT64_MAX) return E_INVALID_PARAMETER;
+
+    // best_num / best_den / sample_rate > HW_INIT_I2S_MAX_ERROR_PPM / 1000000
+    if (best_num * 1000000 > (uint64_t)HW_INIT_I2S_MAX_ERROR_PPM * best_den * sample_rate) {
+        return E_INVALID_PARAMETER;
+    }
+
+    return E_SUCCESS;
+}
+
+int32_t hw_init_i2s_clock(uint32_t sample_rate, uint32_t mclk_output, uint32_t channel_bits,
+    uint32_t * const prescaler)
+{
+    struct plli2s_config config;
+    uint32_t t;
+    int32_t ret;
+
+    if (prescaler == NULL || (channel_bits != 16 && channel_bits != 32)) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    ret = plli2s_search(sample_rate, mclk_output ? 256 : 2 * channel_bits, &config);
+    if (ret != E_SUCCESS) goto exit;
+
+    if (LL_RCC_PLLI2S_GetN() != config.n || (LL_RCC_PLLI2S_GetR() >> RCC_PLLI2SCFGR_PLLI2SR_Pos) != config.r) {
+        LL_RCC_PLLI2S_Disable();
+        while (LL_RCC_PLLI2S_IsReady() != 0);
+        // PLLM is shared with the running main PLL, so only N and R are touched
+        MODIFY_REG(RCC->PLLI2SCFGR, RCC_PLLI2SCFGR_PLLI2SN | RCC_PLLI2SCFGR_PLLI2SR,
+            config.n << RCC_PLLI2SCFGR_PLLI2SN_Pos | config.r << RCC_PLLI2SCFGR_PLLI2SR_Pos);
+        LL_RCC_PLLI2S_Enable();
+
+        t = 0x100000;
+        while (LL_RCC_PLLI2S_IsReady() != 1 && --t);
+        if (t == 0) {
+            ret = E_TIMEOUT;
+            goto exit;
+        }
+    }
+
+    *prescaler = config.prescaler;
+
+    exit:
+    return ret;
+}
+
 int32_t hw_init_early_config(void)
 {
     NVIC_SetPriority(PendSV_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 15, 0));
@@ -39,16 +147,19 @@ int32_t hw_init(void)
     /* Wait till HSE is ready */
     while(LL_RCC_HSE_IsReady() != 1);
     LL_RCC_PLL_ConfigDomain_SYS(LL_RCC_PLLSOURCE_HSE, LL_RCC_PLLM_DIV_4, 168, LL_RCC_PLLP_DIV_2);
-    LL_RCC_PLLI2S_ConfigDomain_I2S(LL_RCC_PLLSOURCE_HSE, LL_RCC_PLLI2SM_DIV_4, 192, LL_RCC_PLLI2SR_DIV_2);
+
+    /* PLLI2S tuned for the default sample rate with master clock output */
+    struct plli2s_config i2s_config;
+    if ((ret = plli2s_search(HW_INIT_I2S_DEFAULT_SAMPLE_RATE, 256, &i2s_config)) != E_SUCCESS) goto exit;
+    LL_RCC_PLLI2S_ConfigDomain_I2S(LL_RCC_PLLSOURCE_HSE, LL_RCC_PLLI2SM_DIV_4, i2s_config.n,
+        i2s_config.r << RCC_PLLI2SCFGR_PLLI2SR_Pos);
     LL_RCC_PLL_Enable();
 
     /* Wait till PLL is ready */
     while(LL_RCC_PLL_IsReady() != 1);
+    // Locks while the rest of the system starts, hw_init_late_config waits for it
     LL_RCC_PLLI2S_Enable();
 
-    // /* Wait till PLL is ready */
-    while(LL_RCC_PLLI2S_IsReady() != 1);
-
     LL_RCC_SetAHBPrescaler(LL_RCC_SYSCLK_DIV_1);
     LL_RCC_SetAPB1Prescaler(LL_RCC_APB1_DIV_4);
     LL_RCC_SetAPB2Prescaler(LL_RCC_APB2_DIV_2);
@@ -58,26 +169,164 @@ int32_t hw_init(void)
     while(LL_RCC_GetSysClkSource() != LL_RCC_SYS_CLKSOURCE_STATUS_PLL);
     LL_SetSystemCoreClock(168000000);
 
+    timebase_init();
+    // LSE takes up to seconds to start, the RTC is usable once it runs
+    rtc_start();
+
     // LL_RCC_SetI2SClockSource(LL_RCC_I2S1_CLKSOURCE_PLLI2S);
 
     exit:
     return ret;
 }
 
-extern const struct usart_device usart2;
-extern const struct gpio_device led_gpio;
-extern const struct i2c_device i2c1;
-extern const struct i2s_device i2s2;
-extern const struct i2s_device i2s3;
+// Longest a step may take to become ready
+#define BOOT_SETTLE_TIMEOUT_US  10000
+
+enum boot_id {
+    BOOT_PLLI2S,
+    BOOT_LED,
+    BOOT_USART2,
+    BOOT_COUNT
+};
+
+#define BOOT_DEP(id_)   (1UL << (id_))
+#define BOOT_ALL        ((1UL << BOOT_COUNT) - 1)
+
+/**
+ * @brief One step of the late boot. Steps run once all their dependencies are ready, lowest
+ * priority value first. A step with a ready function keeps settling in the background while
+ * other steps run, and only its dependents wait for it
+ */
+struct boot_step {
+    const char  *name;
+    int32_t     (*init)(void);      // NULL if there is nothing to start
+    uint32_t    (*ready)(void);     // NULL if ready as soon as init returns
+    uint32_t    deps;               // BOOT_DEP() of the steps it needs
+    uint8_t     priority;
+    uint8_t     required;           // Failure makes hw_init_late_config fail
+};
+
+// Devices needed from boot are kept open for good. The others are initialized when first opened
+static int32_t boot_led(void)       { return device_open(DEVICE_ID_LED, NULL); }
+static int32_t boot_usart2(void)    { return device_open(DEVICE_ID_USART2, NULL); }
+
+static uint32_t boot_plli2s_ready(void)
+{
+    return LL_RCC_PLLI2S_IsReady();
+}
+
+static const struct boot_step boot_steps[BOOT_COUNT] = {
+    [BOOT_PLLI2S] = {"plli2s", NULL, boot_plli2s_ready, 0, 0, 1},
+    [BOOT_LED] = {"led", boot_led, NULL, 0, 0, 0},
+    [BOOT_USART2] = {"usart2", boot_usart2, NULL, 0, 0, 1},
+};
+
+static struct hw_init_boot_record boot_records[BOOT_COUNT];
+static uint32_t boot_record_count;
+
+/**
+ * @brief Picks the next step to start, BOOT_COUNT if none can start now
+ */
+static uint32_t boot_next(uint32_t started, uint32_t ready)
+{
+    uint32_t next = BOOT_COUNT;
+
+    for (uint32_t id = 0; id < BOOT_COUNT; id++) {
+        if (started & BOOT_DEP(id)) continue;
+        if ((boot_steps[id].deps & ~ready) != 0) continue;
+        if (next == BOOT_COUNT || boot_steps[id].priority < boot_steps[next].priority) next = id;
+    }
+
+    return next;
+}
+
+static struct hw_init_boot_record *boot_record(uint32_t id, uint32_t start)
+{
+    struct hw_init_boot_record *record = &boot_records[boot_record_count++];
+
+    record->name = boot_steps[id].name;
+    record->status = E_SUCCESS;
+    record->start = record->init = record->ready = start;
+
+    return record;
+}
 
 int32_t hw_init_late_config(void)
 {
-    int32_t ret;
-    if ((ret = device_init(&led_gpio)) != E_SUCCESS) goto exit;
-    if ((ret = device_init(&usart2)) != E_SUCCESS) goto exit;
-    if ((ret = device_init(&i2c1)) != E_SUCCESS) goto exit;
-    if ((ret = device_init(&i2s3)) != E_SUCCESS) goto exit;
+    struct hw_init_boot_record *record[BOOT_COUNT];
+    uint32_t started = 0, ready = 0, failed = 0, settling = 0;
+    uint32_t timeout = BOOT_SETTLE_TIMEOUT_US * (SystemCoreClock / 1000000);
+    int32_t ret = E_SUCCESS;
+
+    dwt_init();
+    uint32_t boot_start = dwt_cycles();
+    boot_record_count = 0;
+
+    while ((ready | failed) != BOOT_ALL) {
+        uint32_t now = dwt_cycles() - boot_start;
+        uint32_t skipped = 0;
+
+        for (uint32_t id = 0; id < BOOT_COUNT; id++) {
+            if ((settling & BOOT_DEP(id)) == 0) continue;
+
+            if (boot_steps[id].ready()) {
+                record[id]->ready = now;
+                ready |= BOOT_DEP(id);
+                settling &= ~BOOT_DEP(id);
+            } else if (now - record[id]->start > timeout) {
+                record[id]->status = E_TIMEOUT;
+                failed |= BOOT_DEP(id);
+                settling &= ~BOOT_DEP(id);
+            }
+        }
+
+        // Steps that will never start because something they need failed
+        for (uint32_t id = 0; id < BOOT_COUNT; id++) {
+            if ((started & BOOT_DEP(id)) == 0 && (boot_steps[id].deps & failed) != 0) {
+                record[id] = boot_record(id, 0);
+                record[id]->status = E_NOT_INITIALIZED;
+                started |= BOOT_DEP(id);
+                failed |= BOOT_DEP(id);
+                skipped++;
+            }
+        }
+
+        uint32_t id = boot_next(started, ready);
+        if (id == BOOT_COUNT) {
+            // Nothing started, settling or skipped means dependencies that can't be met
+            if (settling == 0 && skipped == 0) {
+                ret = E_INVALID_PARAMETER;
+                goto exit;
+            }
+            continue;
+        }
+
+        const struct boot_step *step = &boot_steps[id];
+        record[id] = boot_record(id, dwt_cycles() - boot_start);
+        if (step->init != NULL) record[id]->status = step->init();
+        record[id]->init = dwt_cycles() - boot_start - record[id]->start;
+        record[id]->ready = record[id]->start + record[id]->init;
+        started |= BOOT_DEP(id);
+
+        if (record[id]->status != E_SUCCESS)    failed |= BOOT_DEP(id);
+        else if (step->ready != NULL)           settling |= BOOT_DEP(id);
+        else                                    ready |= BOOT_DEP(id);
+    }
+
+    // Optional steps may fail. The first required one that did is reported
+    for (uint32_t id = 0; id < BOOT_COUNT; id++) {
+        if (boot_steps[id].required && record[id]->status != E_SUCCESS) {
+            ret = record[id]->status;
+            break;
+        }
+    }
 
     exit:
     return ret;
 }
+
+uint32_t hw_init_boot_report(const struct hw_init_boot_record ** const records)
+{
+    if (records != NULL) *records = boot_records;
+    return boot_record_count;
+}
@@ -0,0 +1,31 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_FREERTOS_H_
+#define TEST_STUB_FREERTOS_H_
+
+// Host stand-in for the FreeRTOS headers: a single task and no interrupts, so critical sections
+// are empty and a mutex that is held is never given back while waiting for it
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFAIL          0
+#define pdPASS          1
+#define portMAX_DELAY   0xffffffffUL
+
+#define configASSERT(x_)        do { if (!(x_)) for (;;); } while (0)
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskENTER_CRITICAL_FROM_ISR()       0
+#define taskEXIT_CRITICAL_FROM_ISR(mask_)   ((void)(mask_))
+
+#endif // TEST_STUB_FREERTOS_H_
@@ -0,0 +1,16 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_INCLUDE_DEVICE_POOL_OP_H_
+#define TEST_STUB_INCLUDE_DEVICE_POOL_OP_H_
+
+// Host stand-in for the polled operation codes of the parent project
+
+#define E_POLLOP_INVALID    -64
+
+#endif // TEST_STUB_INCLUDE_DEVICE_POOL_OP_H_
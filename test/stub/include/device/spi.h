@@ -0,0 +1,38 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_INCLUDE_DEVICE_SPI_H_
+#define TEST_STUB_INCLUDE_DEVICE_SPI_H_
+
+// Host stand-in for the generic SPI interface of the parent project
+
+#include <stdint.h>
+
+struct spi_device;
+
+struct spi_transaction {
+    const void  *write_data;
+    uint32_t    write_size;
+    void        *read_data;
+    uint32_t    read_size;
+};
+
+struct spi_operations {
+    int32_t (*spi_init)(const struct spi_device * const spi);
+    int32_t (*spi_write_op)(const struct spi_device * const spi, const void *data, uint32_t size, uint32_t timeout);
+    int32_t (*spi_read_op)(const struct spi_device * const spi, void *data, uint32_t size, uint32_t timeout);
+    int32_t (*spi_transact_op)(const struct spi_device * const spi, struct spi_transaction * const transaction,
+        uint32_t timeout);
+};
+
+struct spi_device {
+    const struct spi_operations *ops;
+    const void                  *priv;
+};
+
+#endif // TEST_STUB_INCLUDE_DEVICE_SPI_H_
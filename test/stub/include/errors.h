@@ -0,0 +1,22 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_INCLUDE_ERRORS_H_
+#define TEST_STUB_INCLUDE_ERRORS_H_
+
+// Host stand-in for the generic error codes of the parent project. Tests only compare codes by
+// name, so the values don't need to match
+
+#define E_SUCCESS                   0
+#define E_INVALID_PARAMETER         -1
+#define E_UNIMPEMENTED              -2
+#define E_HARDWARE_CONFIG_FAILED    -3
+#define E_TIMEOUT                   -4
+#define E_NOT_INITIALIZED           -5
+
+#endif // TEST_STUB_INCLUDE_ERRORS_H_
@@ -0,0 +1,44 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_SEMPHR_H_
+#define TEST_STUB_SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+// Mutexes only record whether they are held. With a single task, taking a held mutex fails at once
+// whatever the timeout, where the target would block or deadlock
+
+#define SIM_MUTEXES     4
+
+typedef uint8_t *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static uint8_t held[SIM_MUTEXES];
+    static uint32_t created;
+
+    return created < SIM_MUTEXES ? &held[created++] : NULL;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t timeout)
+{
+    (void)timeout;
+    if (*mutex) return pdFAIL;
+    *mutex = 1;
+    return pdPASS;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    if (!*mutex) return pdFAIL;
+    *mutex = 0;
+    return pdPASS;
+}
+
+#endif // TEST_STUB_SEMPHR_H_
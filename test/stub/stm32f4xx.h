@@ -0,0 +1,182 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_STM32F4XX_H_
+#define TEST_STUB_STM32F4XX_H_
+
+// Host stand-in for the CMSIS device header. Register blocks keep the STM32F407 layout and bit
+// positions, but live in host memory and are driven by the model in stm32f4xx_sim.c. Only what
+// the drivers built on the host use is declared
+
+#include <stdint.h>
+
+typedef enum {
+    DMA1_Stream0_IRQn = 11,
+    DMA1_Stream1_IRQn = 12,
+    DMA1_Stream2_IRQn = 13,
+    DMA1_Stream3_IRQn = 14,
+    DMA1_Stream4_IRQn = 15,
+    DMA1_Stream5_IRQn = 16,
+    DMA1_Stream6_IRQn = 17,
+    DMA1_Stream7_IRQn = 47,
+    DMA2_Stream0_IRQn = 56,
+    DMA2_Stream1_IRQn = 57,
+    DMA2_Stream2_IRQn = 58,
+    DMA2_Stream3_IRQn = 59,
+    DMA2_Stream4_IRQn = 60,
+    DMA2_Stream5_IRQn = 68,
+    DMA2_Stream6_IRQn = 69,
+    DMA2_Stream7_IRQn = 70,
+} IRQn_Type;
+
+typedef enum {
+    SUCCESS = 0,
+    ERROR = !SUCCESS
+} ErrorStatus;
+
+typedef struct {
+    volatile uint32_t CR1;
+    volatile uint32_t CR2;
+    volatile uint32_t SR;
+    volatile uint32_t DR;
+    volatile uint32_t CRCPR;
+    volatile uint32_t RXCRCR;
+    volatile uint32_t TXCRCR;
+    volatile uint32_t I2SCFGR;
+    volatile uint32_t I2SPR;
+} SPI_TypeDef;
+
+typedef struct {
+    volatile uint32_t CR;
+    volatile uint32_t NDTR;
+    volatile uint32_t PAR;
+    volatile uint32_t M0AR;
+    volatile uint32_t M1AR;
+    volatile uint32_t FCR;
+} DMA_Stream_TypeDef;
+
+// The streams follow the interrupt registers at offset 0x10, as on the device
+typedef struct {
+    volatile uint32_t   LISR;
+    volatile uint32_t   HISR;
+    volatile uint32_t   LIFCR;
+    volatile uint32_t   HIFCR;
+    DMA_Stream_TypeDef  S[8];
+} DMA_TypeDef;
+
+typedef struct {
+    volatile uint32_t MODER;
+    volatile uint32_t OTYPER;
+    volatile uint32_t OSPEEDR;
+    volatile uint32_t PUPDR;
+    volatile uint32_t IDR;
+    volatile uint32_t ODR;
+    volatile uint32_t BSRR;
+    volatile uint32_t LCKR;
+    volatile uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+#define SPI_CR1_CPHA        (1UL << 0)
+#define SPI_CR1_CPOL        (1UL << 1)
+#define SPI_CR1_MSTR        (1UL << 2)
+#define SPI_CR1_BR_Pos      3
+#define SPI_CR1_BR          (7UL << SPI_CR1_BR_Pos)
+#define SPI_CR1_SPE         (1UL << 6)
+#define SPI_CR1_LSBFIRST    (1UL << 7)
+#define SPI_CR1_SSI         (1UL << 8)
+#define SPI_CR1_SSM         (1UL << 9)
+#define SPI_CR1_RXONLY      (1UL << 10)
+#define SPI_CR1_DFF         (1UL << 11)
+#define SPI_CR1_CRCNEXT     (1UL << 12)
+#define SPI_CR1_CRCEN       (1UL << 13)
+#define SPI_CR1_BIDIOE      (1UL << 14)
+#define SPI_CR1_BIDIMODE    (1UL << 15)
+
+#define SPI_CR2_RXDMAEN     (1UL << 0)
+#define SPI_CR2_TXDMAEN     (1UL << 1)
+#define SPI_CR2_SSOE        (1UL << 2)
+#define SPI_CR2_FRF         (1UL << 4)
+
+#define SPI_SR_RXNE         (1UL << 0)
+#define SPI_SR_TXE          (1UL << 1)
+#define SPI_SR_CRCERR       (1UL << 4)
+#define SPI_SR_MODF         (1UL << 5)
+#define SPI_SR_OVR          (1UL << 6)
+#define SPI_SR_BSY          (1UL << 7)
+
+#define DMA_SxCR_EN         (1UL << 0)
+#define DMA_SxCR_DMEIE      (1UL << 1)
+#define DMA_SxCR_TEIE       (1UL << 2)
+#define DMA_SxCR_HTIE       (1UL << 3)
+#define DMA_SxCR_TCIE       (1UL << 4)
+#define DMA_SxCR_DIR_Pos    6
+#define DMA_SxCR_DIR        (3UL << DMA_SxCR_DIR_Pos)
+#define DMA_SxCR_CIRC       (1UL << 8)
+#define DMA_SxCR_PINC       (1UL << 9)
+#define DMA_SxCR_MINC       (1UL << 10)
+#define DMA_SxCR_PSIZE_Pos  11
+#define DMA_SxCR_PSIZE      (3UL << DMA_SxCR_PSIZE_Pos)
+#define DMA_SxCR_MSIZE_Pos  13
+#define DMA_SxCR_MSIZE      (3UL << DMA_SxCR_MSIZE_Pos)
+#define DMA_SxCR_PL_Pos     16
+#define DMA_SxCR_PL         (3UL << DMA_SxCR_PL_Pos)
+#define DMA_SxCR_CHSEL_Pos  25
+#define DMA_SxCR_CHSEL      (7UL << DMA_SxCR_CHSEL_Pos)
+
+#define DMA_SxFCR_DMDIS     (1UL << 2)
+
+extern SPI_TypeDef      sim_spi1, sim_spi2;
+extern DMA_TypeDef      sim_dma1, sim_dma2;
+extern GPIO_TypeDef     sim_gpioa, sim_gpiob, sim_gpioc;
+extern DWT_Type         sim_dwt;
+extern CoreDebug_Type   sim_core_debug;
+
+extern uint32_t SystemCoreClock;
+
+#define SPI1        (&sim_spi1)
+#define SPI2        (&sim_spi2)
+#define DMA1        (&sim_dma1)
+#define DMA2        (&sim_dma2)
+#define GPIOA       (&sim_gpioa)
+#define GPIOB       (&sim_gpiob)
+#define GPIOC       (&sim_gpioc)
+#define DWT         (&sim_dwt)
+#define CoreDebug   (&sim_core_debug)
+
+// Interrupts are not modelled: nothing preempts the code under test
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+
+static inline uint32_t NVIC_GetPriorityGrouping(void) { return 0; }
+static inline uint32_t NVIC_EncodePriority(uint32_t group, uint32_t preempt, uint32_t sub)
+{
+    (void)group;
+    (void)sub;
+    return preempt;
+}
+static inline void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority) { (void)irqn; (void)priority; }
+static inline void NVIC_EnableIRQ(IRQn_Type irqn) { (void)irqn; }
+static inline void NVIC_DisableIRQ(IRQn_Type irqn) { (void)irqn; }
+
+#include "stm32f4xx_sim.h"
+
+#endif // TEST_STUB_STM32F4XX_H_
@@ -0,0 +1,30 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_STM32F4XX_LL_BUS_H_
+#define TEST_STUB_STM32F4XX_LL_BUS_H_
+
+// Clocks are not modelled, peripherals always run
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+
+#define LL_AHB1_GRP1_PERIPH_GPIOA   (1UL << 0)
+#define LL_AHB1_GRP1_PERIPH_GPIOB   (1UL << 1)
+#define LL_AHB1_GRP1_PERIPH_GPIOC   (1UL << 2)
+#define LL_AHB1_GRP1_PERIPH_DMA1    (1UL << 21)
+#define LL_AHB1_GRP1_PERIPH_DMA2    (1UL << 22)
+#define LL_APB1_GRP1_PERIPH_SPI2    (1UL << 14)
+#define LL_APB2_GRP1_PERIPH_SPI1    (1UL << 12)
+
+static inline void LL_AHB1_GRP1_EnableClock(uint32_t periphs) { (void)periphs; }
+static inline void LL_APB1_GRP1_EnableClock(uint32_t periphs) { (void)periphs; }
+static inline void LL_APB2_GRP1_EnableClock(uint32_t periphs) { (void)periphs; }
+
+#endif // TEST_STUB_STM32F4XX_LL_BUS_H_
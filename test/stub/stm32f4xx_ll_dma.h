@@ -0,0 +1,111 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_STM32F4XX_LL_DMA_H_
+#define TEST_STUB_STM32F4XX_LL_DMA_H_
+
+// LL DMA functions on top of stm32f4xx_sim. Every call is one register access
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+
+#define LL_DMA_STREAM_0                     0UL
+#define LL_DMA_STREAM_1                     1UL
+#define LL_DMA_STREAM_2                     2UL
+#define LL_DMA_STREAM_3                     3UL
+#define LL_DMA_STREAM_4                     4UL
+#define LL_DMA_STREAM_5                     5UL
+#define LL_DMA_STREAM_6                     6UL
+#define LL_DMA_STREAM_7                     7UL
+
+#define LL_DMA_CHANNEL_0                    (0UL << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_3                    (3UL << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_6                    (6UL << DMA_SxCR_CHSEL_Pos)
+
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY   (0UL << DMA_SxCR_DIR_Pos)
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH   (1UL << DMA_SxCR_DIR_Pos)
+
+#define LL_DMA_MODE_NORMAL                  0UL
+#define LL_DMA_MODE_CIRCULAR                DMA_SxCR_CIRC
+
+#define LL_DMA_PERIPH_NOINCREMENT           0UL
+#define LL_DMA_PERIPH_INCREMENT             DMA_SxCR_PINC
+#define LL_DMA_MEMORY_NOINCREMENT           0UL
+#define LL_DMA_MEMORY_INCREMENT             DMA_SxCR_MINC
+
+#define LL_DMA_PDATAALIGN_BYTE              (0UL << DMA_SxCR_PSIZE_Pos)
+#define LL_DMA_PDATAALIGN_HALFWORD          (1UL << DMA_SxCR_PSIZE_Pos)
+#define LL_DMA_MDATAALIGN_BYTE              (0UL << DMA_SxCR_MSIZE_Pos)
+#define LL_DMA_MDATAALIGN_HALFWORD          (1UL << DMA_SxCR_MSIZE_Pos)
+
+#define LL_DMA_PRIORITY_HIGH                (2UL << DMA_SxCR_PL_Pos)
+#define LL_DMA_PRIORITY_VERYHIGH            (3UL << DMA_SxCR_PL_Pos)
+
+static inline void LL_DMA_SetChannelSelection(DMA_TypeDef *DMAx, uint32_t Stream, uint32_t Channel)
+{
+    sim_modify(&DMAx->S[Stream].CR, DMA_SxCR_CHSEL, Channel);
+}
+
+static inline void LL_DMA_ConfigTransfer(DMA_TypeDef *DMAx, uint32_t Stream, uint32_t Configuration)
+{
+    sim_modify(&DMAx->S[Stream].CR, DMA_SxCR_DIR | DMA_SxCR_CIRC | DMA_SxCR_PINC | DMA_SxCR_MINC |
+        DMA_SxCR_PSIZE | DMA_SxCR_MSIZE | DMA_SxCR_PL, Configuration);
+}
+
+static inline void LL_DMA_DisableFifoMode(DMA_TypeDef *DMAx, uint32_t Stream)
+{
+    sim_modify(&DMAx->S[Stream].FCR, DMA_SxFCR_DMDIS, 0);
+}
+
+static inline void LL_DMA_ConfigAddresses(DMA_TypeDef *DMAx, uint32_t Stream, uint32_t SrcAddress,
+    uint32_t DstAddress, uint32_t Direction)
+{
+    if (Direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH) {
+        DMAx->S[Stream].M0AR = SrcAddress;
+        sim_modify(&DMAx->S[Stream].PAR, 0xffffffff, DstAddress);
+    } else {
+        DMAx->S[Stream].PAR = SrcAddress;
+        sim_modify(&DMAx->S[Stream].M0AR, 0xffffffff, DstAddress);
+    }
+}
+
+static inline void LL_DMA_SetDataLength(DMA_TypeDef *DMAx, uint32_t Stream, uint32_t NbData)
+{
+    sim_modify(&DMAx->S[Stream].NDTR, 0xffff, NbData);
+}
+
+static inline void LL_DMA_EnableStream(DMA_TypeDef *DMAx, uint32_t Stream) { sim_dma_enable(DMAx, Stream); }
+
+static inline void LL_DMA_DisableStream(DMA_TypeDef *DMAx, uint32_t Stream)
+{
+    sim_modify(&DMAx->S[Stream].CR, DMA_SxCR_EN, 0);
+}
+
+static inline uint32_t LL_DMA_IsEnabledStream(DMA_TypeDef *DMAx, uint32_t Stream)
+{
+    sim_access();
+    return (DMAx->S[Stream].CR & DMA_SxCR_EN) != 0;
+}
+
+static inline void LL_DMA_EnableIT_HT(DMA_TypeDef *DMAx, uint32_t Stream)
+{
+    sim_modify(&DMAx->S[Stream].CR, 0, DMA_SxCR_HTIE);
+}
+
+static inline void LL_DMA_EnableIT_TC(DMA_TypeDef *DMAx, uint32_t Stream)
+{
+    sim_modify(&DMAx->S[Stream].CR, 0, DMA_SxCR_TCIE);
+}
+
+static inline void LL_DMA_EnableIT_TE(DMA_TypeDef *DMAx, uint32_t Stream)
+{
+    sim_modify(&DMAx->S[Stream].CR, 0, DMA_SxCR_TEIE);
+}
+
+#endif // TEST_STUB_STM32F4XX_LL_DMA_H_
@@ -0,0 +1,65 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_STM32F4XX_LL_GPIO_H_
+#define TEST_STUB_STM32F4XX_LL_GPIO_H_
+
+// Pins are not modelled: the SPI model loops MISO back to MOSI internally. Outputs only latch ODR
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+
+#define LL_GPIO_PIN_4                   (1UL << 4)
+#define LL_GPIO_PIN_5                   (1UL << 5)
+#define LL_GPIO_PIN_6                   (1UL << 6)
+#define LL_GPIO_PIN_7                   (1UL << 7)
+#define LL_GPIO_PIN_12                  (1UL << 12)
+#define LL_GPIO_PIN_13                  (1UL << 13)
+#define LL_GPIO_PIN_15                  (1UL << 15)
+
+#define LL_GPIO_MODE_OUTPUT             1UL
+#define LL_GPIO_MODE_ALTERNATE          2UL
+#define LL_GPIO_SPEED_FREQ_VERY_HIGH    3UL
+#define LL_GPIO_OUTPUT_PUSHPULL         0UL
+#define LL_GPIO_PULL_NO                 0UL
+#define LL_GPIO_PULL_UP                 1UL
+#define LL_GPIO_AF_5                    5UL
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Speed;
+    uint32_t OutputType;
+    uint32_t Pull;
+    uint32_t Alternate;
+} LL_GPIO_InitTypeDef;
+
+static inline ErrorStatus LL_GPIO_Init(GPIO_TypeDef *GPIOx, LL_GPIO_InitTypeDef *GPIO_InitStruct)
+{
+    (void)GPIOx;
+    (void)GPIO_InitStruct;
+    return SUCCESS;
+}
+
+static inline void LL_GPIO_SetOutputPin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    sim_modify(&GPIOx->ODR, 0, PinMask);
+}
+
+static inline void LL_GPIO_ResetOutputPin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    sim_modify(&GPIOx->ODR, PinMask, 0);
+}
+
+static inline uint32_t LL_GPIO_IsOutputPinSet(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    return sim_read(&GPIOx->ODR, PinMask) == PinMask;
+}
+
+#endif // TEST_STUB_STM32F4XX_LL_GPIO_H_
@@ -0,0 +1,127 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_STM32F4XX_LL_SPI_H_
+#define TEST_STUB_STM32F4XX_LL_SPI_H_
+
+// LL SPI functions on top of stm32f4xx_sim. Every call is one register access
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+
+#define LL_SPI_FULL_DUPLEX              0UL
+#define LL_SPI_SIMPLEX_RX               SPI_CR1_RXONLY
+
+#define LL_SPI_MODE_MASTER              (SPI_CR1_MSTR | SPI_CR1_SSI)
+#define LL_SPI_MODE_SLAVE               0UL
+
+#define LL_SPI_DATAWIDTH_8BIT           0UL
+#define LL_SPI_DATAWIDTH_16BIT          SPI_CR1_DFF
+
+#define LL_SPI_POLARITY_LOW             0UL
+#define LL_SPI_PHASE_1EDGE              0UL
+
+#define LL_SPI_NSS_SOFT                 SPI_CR1_SSM
+#define LL_SPI_NSS_HARD_INPUT           0UL
+
+#define LL_SPI_BAUDRATEPRESCALER_DIV2   (0UL << SPI_CR1_BR_Pos)
+#define LL_SPI_BAUDRATEPRESCALER_DIV4   (1UL << SPI_CR1_BR_Pos)
+#define LL_SPI_BAUDRATEPRESCALER_DIV8   (2UL << SPI_CR1_BR_Pos)
+#define LL_SPI_BAUDRATEPRESCALER_DIV16  (3UL << SPI_CR1_BR_Pos)
+#define LL_SPI_BAUDRATEPRESCALER_DIV32  (4UL << SPI_CR1_BR_Pos)
+#define LL_SPI_BAUDRATEPRESCALER_DIV64  (5UL << SPI_CR1_BR_Pos)
+#define LL_SPI_BAUDRATEPRESCALER_DIV128 (6UL << SPI_CR1_BR_Pos)
+#define LL_SPI_BAUDRATEPRESCALER_DIV256 (7UL << SPI_CR1_BR_Pos)
+
+#define LL_SPI_MSB_FIRST                0UL
+#define LL_SPI_CRCCALCULATION_DISABLE   0UL
+#define LL_SPI_CRCCALCULATION_ENABLE    SPI_CR1_CRCEN
+#define LL_SPI_PROTOCOL_MOTOROLA        0UL
+
+typedef struct {
+    uint32_t TransferDirection;
+    uint32_t Mode;
+    uint32_t DataWidth;
+    uint32_t ClockPolarity;
+    uint32_t ClockPhase;
+    uint32_t NSS;
+    uint32_t BaudRate;
+    uint32_t BitOrder;
+    uint32_t CRCCalculation;
+    uint32_t CRCPoly;
+} LL_SPI_InitTypeDef;
+
+static inline ErrorStatus LL_SPI_Init(SPI_TypeDef *SPIx, LL_SPI_InitTypeDef *SPI_InitStruct)
+{
+    if (sim_read(&SPIx->CR1, SPI_CR1_SPE)) return ERROR;
+
+    sim_modify(&SPIx->CR1, 0xffff, SPI_InitStruct->TransferDirection | SPI_InitStruct->Mode |
+        SPI_InitStruct->DataWidth | SPI_InitStruct->ClockPolarity | SPI_InitStruct->ClockPhase |
+        SPI_InitStruct->NSS | SPI_InitStruct->BaudRate | SPI_InitStruct->BitOrder |
+        SPI_InitStruct->CRCCalculation);
+    sim_modify(&SPIx->CRCPR, 0xffff, SPI_InitStruct->CRCPoly);
+
+    return SUCCESS;
+}
+
+static inline void LL_SPI_Enable(SPI_TypeDef *SPIx) { sim_modify(&SPIx->CR1, 0, SPI_CR1_SPE); }
+static inline void LL_SPI_Disable(SPI_TypeDef *SPIx) { sim_modify(&SPIx->CR1, SPI_CR1_SPE, 0); }
+static inline uint32_t LL_SPI_IsEnabled(SPI_TypeDef *SPIx) { return sim_read(&SPIx->CR1, SPI_CR1_SPE) != 0; }
+
+static inline void LL_SPI_SetStandard(SPI_TypeDef *SPIx, uint32_t Standard)
+{
+    sim_modify(&SPIx->CR2, SPI_CR2_FRF, Standard);
+}
+
+static inline void LL_SPI_SetDataWidth(SPI_TypeDef *SPIx, uint32_t DataWidth)
+{
+    sim_modify(&SPIx->CR1, SPI_CR1_DFF, DataWidth);
+}
+
+static inline void LL_SPI_SetBaudRatePrescaler(SPI_TypeDef *SPIx, uint32_t BaudRate)
+{
+    sim_modify(&SPIx->CR1, SPI_CR1_BR, BaudRate);
+}
+
+static inline uint32_t LL_SPI_GetBaudRatePrescaler(SPI_TypeDef *SPIx) { return sim_read(&SPIx->CR1, SPI_CR1_BR); }
+
+static inline void LL_SPI_EnableCRC(SPI_TypeDef *SPIx) { sim_modify(&SPIx->CR1, 0, SPI_CR1_CRCEN); }
+static inline void LL_SPI_DisableCRC(SPI_TypeDef *SPIx) { sim_modify(&SPIx->CR1, SPI_CR1_CRCEN, 0); }
+
+static inline void LL_SPI_SetCRCPolynomial(SPI_TypeDef *SPIx, uint32_t CRCPoly)
+{
+    sim_modify(&SPIx->CRCPR, 0xffff, CRCPoly);
+}
+
+static inline uint32_t LL_SPI_IsActiveFlag_RXNE(SPI_TypeDef *SPIx) { return sim_read(&SPIx->SR, SPI_SR_RXNE) != 0; }
+static inline uint32_t LL_SPI_IsActiveFlag_TXE(SPI_TypeDef *SPIx) { return sim_read(&SPIx->SR, SPI_SR_TXE) != 0; }
+static inline uint32_t LL_SPI_IsActiveFlag_BSY(SPI_TypeDef *SPIx) { return sim_read(&SPIx->SR, SPI_SR_BSY) != 0; }
+static inline uint32_t LL_SPI_IsActiveFlag_OVR(SPI_TypeDef *SPIx) { return sim_read(&SPIx->SR, SPI_SR_OVR) != 0; }
+
+static inline uint32_t LL_SPI_IsActiveFlag_CRCERR(SPI_TypeDef *SPIx)
+{
+    return sim_read(&SPIx->SR, SPI_SR_CRCERR) != 0;
+}
+
+static inline void LL_SPI_ClearFlag_CRCERR(SPI_TypeDef *SPIx) { sim_modify(&SPIx->SR, SPI_SR_CRCERR, 0); }
+static inline void LL_SPI_ClearFlag_OVR(SPI_TypeDef *SPIx) { sim_modify(&SPIx->SR, SPI_SR_OVR, 0); }
+
+static inline void LL_SPI_EnableDMAReq_RX(SPI_TypeDef *SPIx) { sim_modify(&SPIx->CR2, 0, SPI_CR2_RXDMAEN); }
+static inline void LL_SPI_DisableDMAReq_RX(SPI_TypeDef *SPIx) { sim_modify(&SPIx->CR2, SPI_CR2_RXDMAEN, 0); }
+static inline void LL_SPI_EnableDMAReq_TX(SPI_TypeDef *SPIx) { sim_modify(&SPIx->CR2, 0, SPI_CR2_TXDMAEN); }
+static inline void LL_SPI_DisableDMAReq_TX(SPI_TypeDef *SPIx) { sim_modify(&SPIx->CR2, SPI_CR2_TXDMAEN, 0); }
+
+static inline uint32_t LL_SPI_DMA_GetRegAddr(SPI_TypeDef *SPIx) { return (uint32_t)(uintptr_t)&SPIx->DR; }
+
+static inline uint8_t LL_SPI_ReceiveData8(SPI_TypeDef *SPIx) { return (uint8_t)sim_spi_read_dr(SPIx); }
+static inline uint16_t LL_SPI_ReceiveData16(SPI_TypeDef *SPIx) { return (uint16_t)sim_spi_read_dr(SPIx); }
+static inline void LL_SPI_TransmitData8(SPI_TypeDef *SPIx, uint8_t TxData) { sim_spi_write_dr(SPIx, TxData); }
+static inline void LL_SPI_TransmitData16(SPI_TypeDef *SPIx, uint16_t TxData) { sim_spi_write_dr(SPIx, TxData); }
+
+#endif // TEST_STUB_STM32F4XX_LL_SPI_H_
@@ -0,0 +1,276 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "stm32f4xx.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define SIM_SPIS    2
+#define SIM_STREAMS 8
+
+SPI_TypeDef     sim_spi1, sim_spi2;
+DMA_TypeDef     sim_dma1, sim_dma2;
+GPIO_TypeDef    sim_gpioa, sim_gpiob, sim_gpioc;
+DWT_Type        sim_dwt;
+CoreDebug_Type  sim_core_debug;
+
+uint32_t SystemCoreClock = 168000000;
+
+struct sim_spi_state {
+    SPI_TypeDef *regs;
+    uint32_t    pclk_div;       // CPU cycles per APB cycle
+    uint64_t    time;           // How far the model has run
+    uint64_t    frame_end;      // End of the frame being shifted
+    uint64_t    idle_at;        // End of the last frame shifted
+    uint64_t    wire_cycles;
+    uint32_t    tx_data;
+    uint32_t    shift_data;
+    uint32_t    rx_data;
+    uint8_t     tx_full;
+    uint8_t     shifting;
+    uint8_t     rx_full;
+};
+
+struct sim_stream_state {
+    uint32_t    ndtr;           // NDTR when the stream was enabled
+    uint32_t    done;           // Items moved since then
+};
+
+static uint64_t sim_now;
+static struct sim_spi_state spi_states[SIM_SPIS];
+static struct sim_stream_state stream_states[2][SIM_STREAMS];
+static DMA_TypeDef * const dmas[2] = {&sim_dma1, &sim_dma2};
+
+static struct sim_spi_state *spi_state_of(SPI_TypeDef *spi)
+{
+    return &spi_states[spi == SPI2];
+}
+
+static void dma_set_flag(DMA_TypeDef *dma, uint32_t stream, uint32_t flag)
+{
+    static const uint8_t shift[4] = {0, 6, 16, 22};
+
+    if (stream < 4) dma->LISR |= flag << shift[stream];
+    else            dma->HISR |= flag << shift[stream - 4];
+}
+
+/**
+ * @brief Moves one item between memory and the data register of the peripheral, held in data
+ */
+static void dma_move(DMA_TypeDef *dma, uint32_t stream, uint32_t *data)
+{
+    DMA_Stream_TypeDef *s = &dma->S[stream];
+    struct sim_stream_state *state = &stream_states[dma == DMA2][stream];
+    uint32_t size = 1U << ((s->CR & DMA_SxCR_MSIZE) >> DMA_SxCR_MSIZE_Pos);
+    uintptr_t mem = (uintptr_t)s->M0AR + ((s->CR & DMA_SxCR_MINC) ? state->done * size : 0);
+
+    if ((s->CR & DMA_SxCR_DIR) == 0) {
+        if (size == 1)  *(uint8_t *)mem = (uint8_t)*data;
+        else            *(uint16_t *)mem = (uint16_t)*data;
+    } else {
+        *data = size == 1 ? *(const uint8_t *)mem : *(const uint16_t *)mem;
+    }
+
+    state->done++;
+    s->NDTR--;
+    if (s->NDTR == state->ndtr / 2) dma_set_flag(dma, stream, 1UL << 4);
+    if (s->NDTR == 0) {
+        dma_set_flag(dma, stream, 1UL << 5);
+        if (s->CR & DMA_SxCR_CIRC) {
+            s->NDTR = state->ndtr;
+            state->done = 0;
+        } else {
+            s->CR &= ~DMA_SxCR_EN;
+        }
+    }
+}
+
+/**
+ * @brief Finds the enabled stream moving data in direction dir to or from the DR of spi
+ */
+static int32_t dma_find(const struct sim_spi_state *s, uint32_t dir, DMA_TypeDef **dma, uint32_t *stream)
+{
+    for (uint32_t d = 0; d < 2; d++) {
+        for (uint32_t n = 0; n < SIM_STREAMS; n++) {
+            const DMA_Stream_TypeDef *st = &dmas[d]->S[n];
+            if ((st->CR & DMA_SxCR_EN) && st->PAR == (uint32_t)(uintptr_t)&s->regs->DR &&
+                ((st->CR & DMA_SxCR_DIR) >> DMA_SxCR_DIR_Pos) == dir) {
+                *dma = dmas[d];
+                *stream = n;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void dma_service(struct sim_spi_state *s)
+{
+    DMA_TypeDef *dma;
+    uint32_t stream;
+
+    if (s->rx_full && (s->regs->CR2 & SPI_CR2_RXDMAEN) && dma_find(s, 0, &dma, &stream)) {
+        dma_move(dma, stream, &s->rx_data);
+        s->rx_full = 0;
+    }
+    if (!s->tx_full && (s->regs->CR2 & SPI_CR2_TXDMAEN) && dma_find(s, 1, &dma, &stream)) {
+        dma_move(dma, stream, &s->tx_data);
+        s->tx_full = 1;
+    }
+}
+
+static uint32_t frame_cycles(const struct sim_spi_state *s)
+{
+    uint32_t bits = (s->regs->CR1 & SPI_CR1_DFF) ? 16 : 8;
+    uint32_t prescaler = 2U << ((s->regs->CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos);
+
+    return bits * prescaler * s->pclk_div;
+}
+
+/**
+ * @brief Shifts frames until the time until. Only a master clocks frames
+ */
+static void spi_run(struct sim_spi_state *s, uint64_t until)
+{
+    for (;;) {
+        dma_service(s);
+        if (!s->shifting && s->tx_full && (s->regs->CR1 & SPI_CR1_SPE) && (s->regs->CR1 & SPI_CR1_MSTR)) {
+            s->shifting = 1;
+            s->shift_data = s->tx_data;
+            s->tx_full = 0;
+            s->frame_end = s->time + frame_cycles(s);
+            s->wire_cycles += frame_cycles(s);
+            continue; // The TX buffer is free for the next frame
+        }
+        if (!s->shifting || s->frame_end > until) break;
+
+        s->time = s->idle_at = s->frame_end;
+        s->shifting = 0;
+        // MISO is looped back. An unread frame makes the new one be lost
+        if (s->rx_full) {
+            s->regs->SR |= SPI_SR_OVR;
+        } else {
+            s->rx_data = s->shift_data;
+            s->rx_full = 1;
+        }
+    }
+
+    if (until != UINT64_MAX && until > s->time) s->time = until;
+}
+
+static void spi_update_flags(struct sim_spi_state *s)
+{
+    uint32_t sr = s->regs->SR & ~(SPI_SR_RXNE | SPI_SR_TXE | SPI_SR_BSY);
+
+    if (s->rx_full)                             sr |= SPI_SR_RXNE;
+    if (!s->tx_full)                            sr |= SPI_SR_TXE;
+    if (s->shifting || s->idle_at > sim_now)    sr |= SPI_SR_BSY;
+    s->regs->SR = sr;
+}
+
+static void sim_update(void)
+{
+    for (uint32_t d = 0; d < 2; d++) {
+        dmas[d]->LISR &= ~dmas[d]->LIFCR;
+        dmas[d]->HISR &= ~dmas[d]->HIFCR;
+        dmas[d]->LIFCR = 0;
+        dmas[d]->HIFCR = 0;
+    }
+
+    for (uint32_t i = 0; i < SIM_SPIS; i++) {
+        struct sim_spi_state *s = &spi_states[i];
+        DMA_TypeDef *dma;
+        uint32_t stream;
+        // Once DMA feeds the transmitter nothing else is needed from the CPU
+        int32_t fed = (s->regs->CR2 & SPI_CR2_TXDMAEN) && dma_find(s, 1, &dma, &stream);
+
+        spi_run(s, fed ? UINT64_MAX : sim_now);
+        spi_update_flags(s);
+    }
+
+    sim_dwt.CYCCNT = (uint32_t)sim_now;
+}
+
+void sim_reset(void)
+{
+    memset(&sim_spi1, 0, sizeof(sim_spi1));
+    memset(&sim_spi2, 0, sizeof(sim_spi2));
+    memset(&sim_dma1, 0, sizeof(sim_dma1));
+    memset(&sim_dma2, 0, sizeof(sim_dma2));
+    memset(&sim_gpioa, 0, sizeof(sim_gpioa));
+    memset(&sim_gpiob, 0, sizeof(sim_gpiob));
+    memset(&sim_gpioc, 0, sizeof(sim_gpioc));
+    memset(spi_states, 0, sizeof(spi_states));
+    memset(stream_states, 0, sizeof(stream_states));
+
+    spi_states[0].regs = SPI1;
+    spi_states[0].pclk_div = 2; // APB2 at 84 MHz
+    spi_states[1].regs = SPI2;
+    spi_states[1].pclk_div = 4; // APB1 at 42 MHz
+
+    sim_now = 0;
+    sim_update();
+}
+
+void sim_access(void)
+{
+    sim_now += SIM_ACCESS_CYCLES;
+    sim_update();
+}
+
+uint64_t sim_cycles(void)
+{
+    return sim_now;
+}
+
+void sim_spi_idle(SPI_TypeDef *spi)
+{
+    struct sim_spi_state *s = spi_state_of(spi);
+
+    spi_run(s, UINT64_MAX);
+    if (s->idle_at > sim_now) sim_now = s->idle_at;
+    sim_update();
+}
+
+uint64_t sim_spi_wire_cycles(SPI_TypeDef *spi)
+{
+    return spi_state_of(spi)->wire_cycles;
+}
+
+void sim_spi_write_dr(SPI_TypeDef *spi, uint32_t data)
+{
+    struct sim_spi_state *s = spi_state_of(spi);
+
+    sim_access();
+    s->tx_data = data;
+    s->tx_full = 1;
+    sim_update();
+}
+
+uint32_t sim_spi_read_dr(SPI_TypeDef *spi)
+{
+    struct sim_spi_state *s = spi_state_of(spi);
+
+    sim_access();
+    s->rx_full = 0;
+    sim_update();
+
+    return s->rx_data;
+}
+
+void sim_dma_enable(DMA_TypeDef *dma, uint32_t stream)
+{
+    struct sim_stream_state *state = &stream_states[dma == DMA2][stream];
+
+    state->ndtr = dma->S[stream].NDTR;
+    state->done = 0;
+    dma->S[stream].CR |= DMA_SxCR_EN;
+    sim_access();
+}
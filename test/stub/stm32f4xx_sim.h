@@ -0,0 +1,80 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_STM32F4XX_SIM_H_
+#define TEST_STUB_STM32F4XX_SIM_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Cycle model of the SPI and DMA peripherals behind the LL stubs
+ *
+ * Time is counted in CPU cycles at 168 MHz. Every register access made through an LL function
+ * costs SIM_ACCESS_CYCLES and lets the peripherals catch up with the CPU, so busy-wait loops on
+ * LL flags see time pass. The instructions around the accesses are not counted.
+ *
+ * SPI masters send a frame every 2 * prescaler APB cycles and MISO is looped back to MOSI. A
+ * transfer fed by a DMA stream needs no CPU, so it is run to its end as soon as it is armed: the
+ * DMA flags and the received data show up at once, while BSY stays set until the CPU clock
+ * reaches the end of the last frame. GPIO outputs only latch ODR. The CRC unit and interrupts are
+ * not modelled.
+ *
+ * DMA addresses are 32 bits, so buffers given to the model must be static and the program linked
+ * without PIE.
+ */
+
+// Rough cost of an APB register access from the core
+#define SIM_ACCESS_CYCLES   3
+
+/**
+ * @brief Clears the registers of every peripheral and the clock
+ */
+void sim_reset(void);
+
+/**
+ * @brief Charges a register access and brings the peripherals up to the current time
+ */
+void sim_access(void);
+
+/**
+ * @brief CPU cycles since sim_reset(). DWT->CYCCNT follows it
+ */
+uint64_t sim_cycles(void);
+
+/**
+ * @brief Lets the CPU clock run until spi has sent its last frame, as if the CPU was busy
+ * elsewhere
+ */
+void sim_spi_idle(SPI_TypeDef *spi);
+
+/**
+ * @brief Cycles spent shifting frames on spi since sim_reset()
+ */
+uint64_t sim_spi_wire_cycles(SPI_TypeDef *spi);
+
+/**
+ * @brief Read-modify-write of a register, as done by the LL setters
+ */
+static inline void sim_modify(volatile uint32_t *reg, uint32_t clear, uint32_t set)
+{
+    *reg = (*reg & ~clear) | set;
+    sim_access();
+}
+
+static inline uint32_t sim_read(const volatile uint32_t *reg, uint32_t mask)
+{
+    sim_access();
+    return *reg & mask;
+}
+
+// Data register accesses and stream enables, which have side effects in the model
+void sim_spi_write_dr(SPI_TypeDef *spi, uint32_t data);
+uint32_t sim_spi_read_dr(SPI_TypeDef *spi);
+void sim_dma_enable(DMA_TypeDef *dma, uint32_t stream);
+
+#endif // TEST_STUB_STM32F4XX_SIM_H_
@@ -0,0 +1,14 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_TASK_H_
+#define TEST_STUB_TASK_H_
+
+#include "FreeRTOS.h"
+
+#endif // TEST_STUB_TASK_H_
@@ -0,0 +1,14 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_STUB_ULIBC_INCLUDE_UTILS_H_
+#define TEST_STUB_ULIBC_INCLUDE_UTILS_H_
+
+#define ARRAY_SIZE(a_)  (sizeof(a_) / sizeof((a_)[0]))
+
+#endif // TEST_STUB_ULIBC_INCLUDE_UTILS_H_
@@ -0,0 +1,97 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TEST_TEST_H_
+#define TEST_TEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Helpers shared by the host tests
+ *
+ * Checks only count and report failures so a run shows all of them. main() returns
+ * test_result() to make the Makefile stop on the first failing program.
+ */
+
+static uint32_t test_checks;
+static uint32_t test_failures;
+
+#define TEST_CHECK(cond_, ...) do {                                                 \
+        test_checks++;                                                              \
+        if (!(cond_)) {                                                             \
+            test_failures++;                                                        \
+            printf("%s:%d: FAILED %s: ", __FILE__, __LINE__, #cond_);               \
+            printf(__VA_ARGS__);                                                    \
+            printf("\n");                                                           \
+        }                                                                           \
+    } while (0)
+
+static inline int test_result(const char *name)
+{
+    printf("%s: %u checks, %u failed\n", name, test_checks, test_failures);
+    return test_failures != 0;
+}
+
+/**
+ * @brief Tells if the program was asked to run its benchmarks
+ */
+static inline int test_bench_requested(int argc, char **argv)
+{
+    return argc > 1 && strcmp(argv[1], "--bench") == 0;
+}
+
+/**
+ * @brief Same sequence on every run, so failures can be reproduced
+ */
+static inline uint32_t test_random(uint32_t * const seed)
+{
+    // xorshift32
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *seed = x;
+}
+
+static inline int16_t test_random_q15(uint32_t * const seed)
+{
+    return (int16_t)(test_random(seed) >> 16);
+}
+
+/**
+ * @brief Time stamp for benchmarks: the TSC on x86, nanoseconds elsewhere. Host figures are only
+ * good to compare two implementations, on target use CPU_PROF_SCOPE
+ */
+static inline uint64_t test_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TEST_TICKS_UNIT "TSC cycles"
+#else
+#define TEST_TICKS_UNIT "ns"
+#endif
+
+// Keeps the compiler from dropping work whose result is not used
+#define TEST_KEEP(var_) __asm__ volatile("" : : "g"(var_) : "memory")
+
+#endif // TEST_TEST_H_
@@ -0,0 +1,380 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+// Checks the portable C path of dsp.c bit by bit against known answers and against plain scalar
+// models of what the Armv7E-M instructions compute. With --bench also reports ticks per sample.
+
+#include "include/stm32f4xx/dsp.h"
+
+#include "test.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define RANDOM_SAMPLES  4099    // Odd, so the unpaired tail of the packed loops runs too
+#define BENCH_SAMPLES   4096
+#define BENCH_ROUNDS    2000
+
+static int16_t sat16(int64_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return (int16_t)x;
+}
+
+// Scalar models
+
+static void ref_mix(int16_t *dst, const int16_t *src, uint32_t samples)
+{
+    for (uint32_t i = 0; i < samples; i++) dst[i] = sat16((int32_t)dst[i] + src[i]);
+}
+
+static void ref_mix_gain(int16_t *dst, const int16_t *src, uint32_t samples, int16_t gain)
+{
+    for (uint32_t i = 0; i < samples; i++) dst[i] = sat16((int32_t)dst[i] + sat16((src[i] * gain) >> 15));
+}
+
+static void ref_gain(int16_t *buf, uint32_t samples, int16_t gain)
+{
+    for (uint32_t i = 0; i < samples; i++) buf[i] = sat16((buf[i] * gain) >> 15);
+}
+
+static void ref_biquad(const struct dsp_biquad_coeffs *c, struct dsp_biquad_state *st, uint32_t stages,
+    int16_t *buf, uint32_t frames, uint32_t stride)
+{
+    for (uint32_t s = 0; s < stages; s++) {
+        for (uint32_t i = 0; i < frames; i++) {
+            int16_t x0 = buf[i * stride];
+            int64_t acc = (int64_t)c[s].b0 * x0 + (int64_t)c[s].b1 * st[s].x1 + (int64_t)c[s].b2 * st[s].x2 +
+                (int64_t)c[s].a1 * st[s].y1 + (int64_t)c[s].a2 * st[s].y2;
+
+            st[s].x2 = st[s].x1;
+            st[s].x1 = x0;
+            st[s].y2 = st[s].y1;
+            st[s].y1 = sat16(acc >> 14);
+            buf[i * stride] = st[s].y1;
+        }
+    }
+}
+
+static int16_t ref_dot(const int16_t *a, const int16_t *b, uint32_t length)
+{
+    int64_t acc = 0;
+    for (uint32_t i = 0; i < length; i++) acc += a[i] * b[i];
+    return sat16(acc >> 15);
+}
+
+/**
+ * @brief taps are in the reverse order expected by dsp_fir_q15. x has num_taps - 1 zeros before
+ * the first input
+ */
+static int16_t ref_fir(const int16_t *taps, uint32_t num_taps, const int16_t *x, uint32_t n)
+{
+    int64_t acc = 0;
+    for (uint32_t k = 0; k < num_taps; k++) acc += taps[k] * x[n + k];
+    return sat16(acc >> 15);
+}
+
+// Known answers
+
+static void test_mix_known(void)
+{
+    int16_t dst[] = {32767, -32768, 100, -5, 7};
+    const int16_t src[] = {1, -1, -200, 5, 0};
+    const int16_t expected[] = {32767, -32768, -100, 0, 7};
+
+    dsp_mix_q15(dst, src, 5);
+    TEST_CHECK(memcmp(dst, expected, sizeof(dst)) == 0, "%d %d %d %d %d", dst[0], dst[1], dst[2], dst[3], dst[4]);
+}
+
+static void test_mix_gain_known(void)
+{
+    int16_t dst[] = {0, 32767, -100};
+    const int16_t src[] = {1000, 1000, -32768};
+    const int16_t expected[] = {500, 32767, -16484};
+
+    dsp_mix_gain_q15(dst, src, 3, 16384);
+    TEST_CHECK(memcmp(dst, expected, sizeof(dst)) == 0, "%d %d %d", dst[0], dst[1], dst[2]);
+}
+
+static void test_gain_known(void)
+{
+    int16_t half[] = {32767, -32768, 3};
+    const int16_t half_expected[] = {16383, -16384, 1};
+    int16_t invert[] = {32767, -32768};
+    const int16_t invert_expected[] = {-32767, 32767};
+
+    dsp_gain_q15(half, 3, 16384);
+    TEST_CHECK(memcmp(half, half_expected, sizeof(half)) == 0, "%d %d %d", half[0], half[1], half[2]);
+    dsp_gain_q15(invert, 2, INT16_MIN);
+    TEST_CHECK(memcmp(invert, invert_expected, sizeof(invert)) == 0, "%d %d", invert[0], invert[1]);
+}
+
+static void test_biquad_known(void)
+{
+    // Unity and one sample of delay, on the left channel of an interleaved buffer
+    const struct dsp_biquad_coeffs coeffs[] = {
+        {.b0 = 16384},
+        {.b1 = 16384},
+    };
+    struct dsp_biquad_state state[2] = {0};
+    const struct dsp_biquad bq = {coeffs, state, 2};
+    int16_t buf[] = {100, 1, -200, 2, 32767, 3, -32768, 4};
+    const int16_t expected[] = {0, 1, 100, 2, -200, 3, 32767, 4};
+
+    dsp_biquad_q15(&bq, buf, 4, 2);
+    TEST_CHECK(memcmp(buf, expected, sizeof(buf)) == 0, "%d %d %d %d", buf[0], buf[2], buf[4], buf[6]);
+
+    // Five full-scale products add up past 2^32: must saturate, not wrap
+    const struct dsp_biquad_coeffs loud = {32767, 32767, 32767, 32767, 32767};
+    struct dsp_biquad_state loud_state = {0};
+    const struct dsp_biquad loud_bq = {&loud, &loud_state, 1};
+    int16_t loud_buf[4] = {32767, 32767, 32767, 32767};
+
+    dsp_biquad_q15(&loud_bq, loud_buf, 4, 1);
+    for (int i = 0; i < 4; i++) TEST_CHECK(loud_buf[i] == INT16_MAX, "sample %d is %d", i, loud_buf[i]);
+}
+
+static void test_fir_known(void)
+{
+    // Reverse order: the second tap weights the newest sample
+    const int16_t half_now[] = {0, 16384};
+    const int16_t half_before[] = {16384, 0};
+    int16_t history_now[4] = {0}, history_before[4] = {0};
+    struct dsp_fir now = {half_now, 2, history_now, 0};
+    struct dsp_fir before = {half_before, 2, history_before, 0};
+    const int16_t in[] = {100, 200, -300};
+    int16_t out[3];
+
+    dsp_fir_q15(&now, in, out, 3, 1);
+    TEST_CHECK(out[0] == 50 && out[1] == 100 && out[2] == -150, "%d %d %d", out[0], out[1], out[2]);
+    dsp_fir_q15(&before, in, out, 3, 1);
+    TEST_CHECK(out[0] == 0 && out[1] == 50 && out[2] == 100, "%d %d %d", out[0], out[1], out[2]);
+}
+
+static void test_dot_known(void)
+{
+    const int16_t max[] = {32767, 32767};
+    const int16_t a[] = {16384, -16384};
+    const int16_t b[] = {16384, 16384};
+    const int16_t min[] = {-32768, -32768};
+    const int16_t min_zero[] = {-32768, 0};
+
+    TEST_CHECK(dsp_dot_q15(max, max, 2) == INT16_MAX, "%d", dsp_dot_q15(max, max, 2));
+    TEST_CHECK(dsp_dot_q15(a, b, 2) == 0, "%d", dsp_dot_q15(a, b, 2));
+    TEST_CHECK(dsp_dot_q15(min, min_zero, 2) == INT16_MAX, "%d", dsp_dot_q15(min, min_zero, 2));
+}
+
+static void test_meter_known(void)
+{
+    const int16_t buf[] = {3, 1000, -4, 1000, -32768, 1000};
+    struct dsp_meter meter;
+
+    dsp_meter_q15(buf, 2, 2, &meter);
+    TEST_CHECK(meter.peak == 4 && meter.rms == 3, "peak %d rms %d", meter.peak, meter.rms);
+    dsp_meter_q15(buf, 3, 2, &meter);
+    TEST_CHECK(meter.peak == INT16_MAX, "peak %d", meter.peak);
+    dsp_meter_q15(buf, 0, 2, &meter);
+    TEST_CHECK(meter.peak == 0 && meter.rms == 0, "peak %d rms %d", meter.peak, meter.rms);
+}
+
+static void test_i2s32_known(void)
+{
+    const int16_t in[] = {-2, 5};
+    const uint16_t expected[] = {0xfffe, 0, 5, 0};
+    uint16_t wide[4];
+    int16_t back[2];
+
+    dsp_q15_to_i2s32(in, wide, 2);
+    TEST_CHECK(memcmp(wide, expected, sizeof(wide)) == 0, "%04x %04x %04x %04x", wide[0], wide[1], wide[2],
+        wide[3]);
+    dsp_i2s32_to_q15(wide, back, 2);
+    TEST_CHECK(memcmp(back, in, sizeof(back)) == 0, "%d %d", back[0], back[1]);
+}
+
+// Random inputs against the models
+
+static void fill_random(int16_t *buf, uint32_t samples, uint32_t *seed)
+{
+    for (uint32_t i = 0; i < samples; i++) buf[i] = test_random_q15(seed);
+}
+
+static uint32_t first_difference(const int16_t *a, const int16_t *b, uint32_t samples)
+{
+    for (uint32_t i = 0; i < samples; i++) if (a[i] != b[i]) return i;
+    return samples;
+}
+
+static void test_mix_random(uint32_t seed)
+{
+    static int16_t dst[RANDOM_SAMPLES], ref[RANDOM_SAMPLES], src[RANDOM_SAMPLES];
+    int16_t gain = test_random_q15(&seed);
+    uint32_t i;
+
+    fill_random(dst, RANDOM_SAMPLES, &seed);
+    fill_random(src, RANDOM_SAMPLES, &seed);
+    memcpy(ref, dst, sizeof(ref));
+    dsp_mix_q15(dst, src, RANDOM_SAMPLES);
+    ref_mix(ref, src, RANDOM_SAMPLES);
+    i = first_difference(dst, ref, RANDOM_SAMPLES);
+    TEST_CHECK(i == RANDOM_SAMPLES, "mix sample %u: %d, expected %d", i, dst[i], ref[i]);
+
+    dsp_mix_gain_q15(dst, src, RANDOM_SAMPLES, gain);
+    ref_mix_gain(ref, src, RANDOM_SAMPLES, gain);
+    i = first_difference(dst, ref, RANDOM_SAMPLES);
+    TEST_CHECK(i == RANDOM_SAMPLES, "mix_gain %d sample %u: %d, expected %d", gain, i, dst[i], ref[i]);
+
+    dsp_gain_q15(dst, RANDOM_SAMPLES, gain);
+    ref_gain(ref, RANDOM_SAMPLES, gain);
+    i = first_difference(dst, ref, RANDOM_SAMPLES);
+    TEST_CHECK(i == RANDOM_SAMPLES, "gain %d sample %u: %d, expected %d", gain, i, dst[i], ref[i]);
+}
+
+static void test_biquad_random(uint32_t seed)
+{
+    static int16_t buf[2 * RANDOM_SAMPLES], ref[2 * RANDOM_SAMPLES];
+    struct dsp_biquad_coeffs coeffs[3];
+    struct dsp_biquad_state state[3] = {0}, ref_state[3] = {0};
+    const struct dsp_biquad bq = {coeffs, state, 3};
+    uint32_t i;
+
+    // Any coefficients, stable or not: saturation must match too
+    for (int s = 0; s < 3; s++) {
+        coeffs[s].b0 = test_random_q15(&seed);
+        coeffs[s].b1 = test_random_q15(&seed);
+        coeffs[s].b2 = test_random_q15(&seed);
+        coeffs[s].a1 = test_random_q15(&seed);
+        coeffs[s].a2 = test_random_q15(&seed);
+    }
+
+    fill_random(buf, 2 * RANDOM_SAMPLES, &seed);
+    memcpy(ref, buf, sizeof(ref));
+
+    // Two calls, so the state carried between blocks is checked as well
+    dsp_biquad_q15(&bq, buf + 1, RANDOM_SAMPLES / 2, 2);
+    dsp_biquad_q15(&bq, buf + 1 + 2 * (RANDOM_SAMPLES / 2), RANDOM_SAMPLES - RANDOM_SAMPLES / 2, 2);
+    ref_biquad(coeffs, ref_state, 3, ref + 1, RANDOM_SAMPLES / 2, 2);
+    ref_biquad(coeffs, ref_state, 3, ref + 1 + 2 * (RANDOM_SAMPLES / 2), RANDOM_SAMPLES - RANDOM_SAMPLES / 2, 2);
+
+    i = first_difference(buf, ref, 2 * RANDOM_SAMPLES);
+    TEST_CHECK(i == 2 * RANDOM_SAMPLES, "sample %u: %d, expected %d", i, buf[i], ref[i]);
+}
+
+static void test_fir_random(uint32_t seed)
+{
+    enum { TAPS = 32 };
+    static int16_t in[TAPS - 1 + RANDOM_SAMPLES], out[RANDOM_SAMPLES];
+    int16_t taps[TAPS], history[2 * TAPS] = {0};
+    struct dsp_fir fir = {taps, TAPS, history, 0};
+    uint32_t errors = 0, first = 0;
+
+    // Small taps keep most outputs unsaturated, so the sum itself is checked
+    for (int k = 0; k < TAPS; k++) taps[k] = test_random_q15(&seed) / 8;
+    memset(in, 0, sizeof(in));
+    fill_random(in + TAPS - 1, RANDOM_SAMPLES, &seed);
+
+    dsp_fir_q15(&fir, in + TAPS - 1, out, 1000, 1);
+    dsp_fir_q15(&fir, in + TAPS - 1 + 1000, out + 1000, RANDOM_SAMPLES - 1000, 1);
+
+    for (uint32_t n = 0; n < RANDOM_SAMPLES; n++) {
+        if (out[n] != ref_fir(taps, TAPS, in, n) && errors++ == 0) first = n;
+    }
+    TEST_CHECK(errors == 0, "%u samples differ, first %u: %d, expected %d", errors, first, out[first],
+        ref_fir(taps, TAPS, in, first));
+}
+
+static void test_dot_random(uint32_t seed)
+{
+    static int16_t a[RANDOM_SAMPLES + 1], b[RANDOM_SAMPLES + 1];
+
+    fill_random(a, RANDOM_SAMPLES + 1, &seed);
+    fill_random(b, RANDOM_SAMPLES + 1, &seed);
+    for (uint32_t length = 2; length <= 64; length += 2) {
+        int16_t got = dsp_dot_q15(a, b, length), expected = ref_dot(a, b, length);
+        TEST_CHECK(got == expected, "length %u: %d, expected %d", length, got, expected);
+    }
+    int16_t got = dsp_dot_q15(a, b, RANDOM_SAMPLES + 1), expected = ref_dot(a, b, RANDOM_SAMPLES + 1);
+    TEST_CHECK(got == expected, "length %u: %d, expected %d", RANDOM_SAMPLES + 1, got, expected);
+}
+
+// Benchmarks
+
+static void bench_report(const char *name, uint64_t ticks, uint32_t samples)
+{
+    printf("  %-12s %8.3f %s/sample\n", name, (double)ticks / ((double)samples * BENCH_ROUNDS), TEST_TICKS_UNIT);
+}
+
+static void bench(void)
+{
+    static int16_t a[2 * BENCH_SAMPLES], b[2 * BENCH_SAMPLES];
+    const struct dsp_biquad_coeffs coeffs[2] = {
+        // Second order low-pass at fs / 8 and its copy: a realistic load that does not saturate
+        {1608, 3216, 1608, 18530, -8578},
+        {1608, 3216, 1608, 18530, -8578},
+    };
+    struct dsp_biquad_state state[2] = {0};
+    const struct dsp_biquad bq = {coeffs, state, 2};
+    int16_t taps[32], history[64] = {0};
+    struct dsp_fir fir = {taps, 32, history, 0};
+    uint32_t seed = 1;
+    uint64_t start;
+    int16_t dot = 0;
+
+    fill_random(a, 2 * BENCH_SAMPLES, &seed);
+    fill_random(b, 2 * BENCH_SAMPLES, &seed);
+    for (int k = 0; k < 32; k++) taps[k] = 1024;
+
+    printf("dsp benchmark, %d samples per call, portable C path:\n", BENCH_SAMPLES);
+
+    start = test_ticks();
+    for (int r = 0; r < BENCH_ROUNDS; r++) { dsp_mix_q15(a, b, BENCH_SAMPLES); TEST_KEEP(a); }
+    bench_report("mix", test_ticks() - start, BENCH_SAMPLES);
+
+    start = test_ticks();
+    for (int r = 0; r < BENCH_ROUNDS; r++) { dsp_mix_gain_q15(a, b, BENCH_SAMPLES, 16384); TEST_KEEP(a); }
+    bench_report("mix_gain", test_ticks() - start, BENCH_SAMPLES);
+
+    start = test_ticks();
+    for (int r = 0; r < BENCH_ROUNDS; r++) { dsp_gain_q15(a, BENCH_SAMPLES, 32000); TEST_KEEP(a); }
+    bench_report("gain", test_ticks() - start, BENCH_SAMPLES);
+
+    start = test_ticks();
+    for (int r = 0; r < BENCH_ROUNDS; r++) { dsp_biquad_q15(&bq, b, BENCH_SAMPLES, 2); TEST_KEEP(b); }
+    bench_report("biquad x2", test_ticks() - start, BENCH_SAMPLES);
+
+    start = test_ticks();
+    for (int r = 0; r < BENCH_ROUNDS; r++) { dsp_fir_q15(&fir, a, b, BENCH_SAMPLES, 1); TEST_KEEP(b); }
+    bench_report("fir 32", test_ticks() - start, BENCH_SAMPLES);
+
+    start = test_ticks();
+    for (int r = 0; r < BENCH_ROUNDS; r++) { dot ^= dsp_dot_q15(a, b, BENCH_SAMPLES); TEST_KEEP(dot); }
+    bench_report("dot", test_ticks() - start, BENCH_SAMPLES);
+}
+
+int main(int argc, char **argv)
+{
+    test_mix_known();
+    test_mix_gain_known();
+    test_gain_known();
+    test_biquad_known();
+    test_fir_known();
+    test_dot_known();
+    test_meter_known();
+    test_i2s32_known();
+
+    for (uint32_t seed = 1; seed <= 16; seed++) {
+        test_mix_random(seed * 0x9e3779b9);
+        test_biquad_random(seed * 0x85ebca6b);
+        test_fir_random(seed * 0xc2b2ae35);
+        test_dot_random(seed * 0x27d4eb2f);
+    }
+
+    if (test_bench_requested(argc, argv)) bench();
+
+    return test_result("test_dsp");
+}
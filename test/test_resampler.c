@@ -0,0 +1,236 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+// Measures THD+N of resampled sines for every quality tier and checks that the filter phase is
+// the nearest one. With --bench also reports ticks per output frame.
+
+#include "include/stm32f4xx/resampler.h"
+
+#include "test.h"
+
+#include <stdint.h>
+#include <math.h>
+
+#define TONE_AMPLITUDE  29204.0 // -1 dBFS
+#define TONE_FRAMES     9600    // Input frames fed for each measurement
+#define SETTLE_FRAMES   64      // Output frames skipped while the filter fills
+#define CHUNK_FRAMES    37      // Odd block size, so state carried between calls is exercised
+
+#define BENCH_FRAMES    4800
+#define BENCH_ROUNDS    200
+
+static const char * const tier_names[] = {"low", "medium", "high"};
+
+static int16_t in_buf[2 * TONE_FRAMES];
+static int16_t out_buf[2 * 8 * TONE_FRAMES];
+
+/**
+ * @brief Runs the whole input through rs in small blocks, as a stream would
+ */
+static uint32_t resample(struct resampler * const rs, uint32_t in_frames, uint32_t out_room)
+{
+    uint32_t i = 0, o = 0;
+
+    while (i < in_frames && o < out_room) {
+        uint32_t consumed, chunk = in_frames - i < CHUNK_FRAMES ? in_frames - i : CHUNK_FRAMES;
+        uint32_t room = out_room - o < 2 * CHUNK_FRAMES ? out_room - o : 2 * CHUNK_FRAMES;
+
+        o += resampler_process(rs, &in_buf[2 * i], chunk, &consumed, &out_buf[2 * o], room);
+        i += consumed;
+    }
+
+    return o;
+}
+
+/**
+ * @brief THD+N in dB of one channel: power of what is left after removing the best fitting sine
+ * of frequency cycles per frame (and DC), relative to the power of that sine
+ */
+static double thd_n(const int16_t *buf, uint32_t frames, double cycles)
+{
+    // Least squares fit of a*sin + b*cos + c by the normal equations
+    double m[3][4] = {{0}};
+
+    for (uint32_t n = 0; n < frames; n++) {
+        double v[3] = {sin(2 * M_PI * cycles * n), cos(2 * M_PI * cycles * n), 1.0};
+        double y = buf[2 * n];
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) m[r][c] += v[r] * v[c];
+            m[r][3] += v[r] * y;
+        }
+    }
+
+    for (int p = 0; p < 3; p++) {
+        for (int r = p + 1; r < 3; r++) {
+            double f = m[r][p] / m[p][p];
+            for (int c = p; c < 4; c++) m[r][c] -= f * m[p][c];
+        }
+    }
+    double x[3];
+    for (int r = 2; r >= 0; r--) {
+        x[r] = m[r][3];
+        for (int c = r + 1; c < 3; c++) x[r] -= m[r][c] * x[c];
+        x[r] /= m[r][r];
+    }
+
+    double signal = 0, noise = 0;
+    for (uint32_t n = 0; n < frames; n++) {
+        double fit = x[0] * sin(2 * M_PI * cycles * n) + x[1] * cos(2 * M_PI * cycles * n);
+        double e = buf[2 * n] - fit - x[2];
+        signal += fit * fit;
+        noise += e * e;
+    }
+
+    return 10 * log10(noise / signal);
+}
+
+static double tone_thd_n(enum resampler_quality quality, uint32_t in_rate, uint32_t out_rate, double freq)
+{
+    struct resampler rs;
+    uint32_t frames;
+
+    for (uint32_t n = 0; n < TONE_FRAMES; n++) {
+        int16_t s = (int16_t)lrint(TONE_AMPLITUDE * sin(2 * M_PI * freq * n / in_rate));
+        in_buf[2 * n] = in_buf[2 * n + 1] = s;
+    }
+
+    TEST_CHECK(resampler_init(&rs, in_rate, out_rate, quality) == E_SUCCESS, "%u -> %u", in_rate, out_rate);
+    frames = resample(&rs, TONE_FRAMES, sizeof(out_buf) / (2 * sizeof(int16_t)));
+
+    // Both channels carry the same tone and go through the same arithmetic
+    uint32_t mismatch = 0;
+    for (uint32_t n = 0; n < frames; n++) mismatch += out_buf[2 * n] != out_buf[2 * n + 1];
+    TEST_CHECK(mismatch == 0, "%u frames differ between channels", mismatch);
+
+    return thd_n(&out_buf[2 * SETTLE_FRAMES], frames - 2 * SETTLE_FRAMES, freq / out_rate);
+}
+
+static void test_thd_n(void)
+{
+    static const struct {
+        uint32_t    in_rate;
+        uint32_t    out_rate;
+        double      freq;
+        double      limit[3];   // dB, per quality tier
+    } cases[] = {
+        // Measured figures less 3 dB. They are set by the drift of the table rows from their
+        // nominal phase more than by the number of phases
+        {44100, 48000, 1000, {-57, -59, -71}},
+        {44100, 48000, 10000, {-17, -46, -53}},
+        {32000, 48000, 1000, {-50, -56, -67}},
+        {16000, 48000, 5000, {-8, -40, -51}},
+        {8000, 48000, 1000, {-28, -46, -56}},
+        {48000, 48000, 1000, {-90, -90, -90}},
+        {48000, 44100, 1000, {-58, -59, -71}},
+    };
+
+    printf("THD+N, -1 dBFS tone:\n");
+    for (uint32_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        double db[3];
+
+        printf("  %5u -> %5u Hz, %5.0f Hz:", cases[c].in_rate, cases[c].out_rate, cases[c].freq);
+        for (int q = RESAMPLER_QUALITY_LOW; q <= RESAMPLER_QUALITY_HIGH; q++) {
+            db[q] = tone_thd_n(q, cases[c].in_rate, cases[c].out_rate, cases[c].freq);
+            printf("  %s %6.1f dB", tier_names[q], db[q]);
+        }
+        printf("\n");
+
+        for (int q = RESAMPLER_QUALITY_LOW; q <= RESAMPLER_QUALITY_HIGH; q++) {
+            TEST_CHECK(db[q] < cases[c].limit[q], "%u -> %u Hz, %.0f Hz, %s: %.1f dB, limit %.1f dB",
+                cases[c].in_rate, cases[c].out_rate, cases[c].freq, tier_names[q], db[q], cases[c].limit[q]);
+        }
+    }
+}
+
+/**
+ * @brief Linear interpolation of a sawtooth is exact away from the jumps, so what is left is the
+ * error of the phase that was picked. Picking the nearest of 64 phases keeps it within half a
+ * phase and centered on zero, truncating would make it up to a whole phase and always negative
+ */
+static void test_nearest_phase(void)
+{
+    enum { PERIOD = 32, SLOPE = 1024, FRAMES = 4000 };
+    static const uint32_t rates[][2] = {{44100, 48000}, {32000, 48000}, {47999, 48000}, {48000, 44100}};
+
+    for (uint32_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        struct resampler rs;
+        double sum = 0, worst = 0;
+        uint32_t count = 0, frames;
+
+        for (uint32_t n = 0; n < FRAMES; n++) {
+            in_buf[2 * n] = in_buf[2 * n + 1] = (int16_t)(SLOPE * ((int32_t)(n % PERIOD) - PERIOD / 2));
+        }
+
+        resampler_init(&rs, rates[r][0], rates[r][1], RESAMPLER_QUALITY_LOW);
+        frames = resample(&rs, FRAMES, sizeof(out_buf) / (2 * sizeof(int16_t)));
+
+        for (uint32_t o = 2; o < frames; o++) {
+            // Output o interpolates one frame behind o * step
+            double t = (double)o * rs.step / RESAMPLER_ONE - 1;
+            uint32_t n = (uint32_t)t;
+            if (n % PERIOD == PERIOD - 1) continue; // Across a jump
+
+            double expected = SLOPE * (t - (n / PERIOD) * PERIOD - PERIOD / 2);
+            double e = out_buf[2 * o] - expected;
+            sum += e;
+            if (fabs(e) > worst) worst = fabs(e);
+            count++;
+        }
+
+        // Half of 1/64 of a frame is 8 LSB of the ramp, Q15 rounding adds up to 2
+        TEST_CHECK(worst <= SLOPE / 128.0 + 2, "%u -> %u Hz: error up to %.1f", rates[r][0], rates[r][1], worst);
+        TEST_CHECK(fabs(sum / count) < 2, "%u -> %u Hz: mean error %.2f", rates[r][0], rates[r][1], sum / count);
+    }
+}
+
+static void test_invalid(void)
+{
+    struct resampler rs;
+
+    TEST_CHECK(resampler_init(&rs, 0, 48000, RESAMPLER_QUALITY_LOW) == E_INVALID_PARAMETER, "in_rate 0");
+    TEST_CHECK(resampler_init(&rs, 48000, 0, RESAMPLER_QUALITY_LOW) == E_INVALID_PARAMETER, "out_rate 0");
+    TEST_CHECK(resampler_init(&rs, 48000 * 9, 48000, RESAMPLER_QUALITY_LOW) == E_INVALID_PARAMETER, "ratio 9");
+    TEST_CHECK(resampler_init(&rs, 48000 * 8, 48000, RESAMPLER_QUALITY_HIGH) == E_SUCCESS, "ratio 8");
+    TEST_CHECK(resampler_set_step(&rs, 0) == E_INVALID_PARAMETER, "step 0");
+    TEST_CHECK(resampler_set_step(&rs, 8 * RESAMPLER_ONE + 1) == E_INVALID_PARAMETER, "step above 8");
+}
+
+static void bench(void)
+{
+    printf("resampler benchmark, 44100 -> 48000 Hz stereo:\n");
+
+    for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+        in_buf[2 * n] = in_buf[2 * n + 1] = (int16_t)lrint(TONE_AMPLITUDE * sin(2 * M_PI * 1000.0 * n / 44100));
+    }
+
+    for (int q = RESAMPLER_QUALITY_LOW; q <= RESAMPLER_QUALITY_HIGH; q++) {
+        struct resampler rs;
+        uint64_t frames = 0, start;
+
+        resampler_init(&rs, 44100, 48000, q);
+        start = test_ticks();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            uint32_t consumed;
+            frames += resampler_process(&rs, in_buf, BENCH_FRAMES, &consumed, out_buf, 2 * BENCH_FRAMES);
+            TEST_KEEP(out_buf);
+        }
+        printf("  %-8s %8.2f %s/output frame\n", tier_names[q], (double)(test_ticks() - start) / frames,
+            TEST_TICKS_UNIT);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    test_invalid();
+    test_nearest_phase();
+    test_thd_n();
+
+    if (test_bench_requested(argc, argv)) bench();
+
+    return test_result("test_resampler");
+}
@@ -0,0 +1,217 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+// Runs the SPI1 driver against the register model in stub/stm32f4xx_sim.c, which loops MISO back
+// to MOSI. Checks polled and DMA transfers and, with --bench, compares their cost in CPU cycles.
+
+#include "include/stm32f4xx/spi.h"
+#include "include/stm32f4xx/dma.h"
+
+#include "test.h"
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_spi.h"
+
+#include "FreeRTOS.h"
+
+#define MAX_SIZE    4096
+// Busy-wait iterations, each at least one register access. Covers MAX_SIZE bytes at the slowest
+// SCK of the benchmark
+#define TIMEOUT     1000000
+
+extern const struct spi_device spi1;
+
+static const uint32_t sizes[] = {1, 16, 256, MAX_SIZE};
+
+// Static, so DMA addresses fit the 32-bit registers of the model
+static uint8_t write_buf[MAX_SIZE];
+static uint8_t read_buf[MAX_SIZE];
+
+static void fill(uint32_t size, uint32_t seed)
+{
+    for (uint32_t i = 0; i < size; i++) write_buf[i] = (uint8_t)test_random(&seed);
+    memset(read_buf, 0, sizeof(read_buf));
+}
+
+static int32_t polled(uint32_t size)
+{
+    struct spi_transaction transaction = {
+        .write_data = write_buf,
+        .write_size = size,
+        .read_data = read_buf,
+        .read_size = size
+    };
+
+    return spi1.ops->spi_transact_op(&spi1, &transaction, TIMEOUT);
+}
+
+static int32_t dma(const void *write_data, void *read_data, uint32_t size)
+{
+    struct spi_transaction transaction = {
+        .write_data = write_data,
+        .write_size = size,
+        .read_data = read_data,
+        .read_size = size
+    };
+    int32_t ret;
+
+    if ((ret = stm32f4xx_spi_lock(&spi1, portMAX_DELAY)) != E_SUCCESS) return ret;
+    if ((ret = stm32f4xx_spi_dma_start(&spi1, &transaction)) == E_SUCCESS) {
+        ret = stm32f4xx_spi_dma_wait(&spi1, TIMEOUT);
+    }
+    stm32f4xx_spi_unlock(&spi1);
+
+    return ret;
+}
+
+static void test_transfers(void)
+{
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        fill(sizes[s], s + 1);
+        TEST_CHECK(polled(sizes[s]) == E_SUCCESS, "polled, %u bytes", sizes[s]);
+        TEST_CHECK(memcmp(read_buf, write_buf, sizes[s]) == 0, "polled, %u bytes", sizes[s]);
+
+        fill(sizes[s], s + 100);
+        TEST_CHECK(dma(write_buf, read_buf, sizes[s]) == E_SUCCESS, "DMA, %u bytes", sizes[s]);
+        TEST_CHECK(memcmp(read_buf, write_buf, sizes[s]) == 0, "DMA, %u bytes", sizes[s]);
+    }
+
+    // Past the end of the write data 0xff is clocked out
+    struct spi_transaction transaction = {
+        .write_data = write_buf,
+        .write_size = 8,
+        .read_data = read_buf,
+        .read_size = 64
+    };
+    fill(64, 3);
+    TEST_CHECK(spi1.ops->spi_transact_op(&spi1, &transaction, TIMEOUT) == E_SUCCESS, "polled, short write");
+    uint32_t not_ff = 0;
+    for (uint32_t i = 8; i < 64; i++) not_ff += read_buf[i] != 0xff;
+    TEST_CHECK(memcmp(read_buf, write_buf, 8) == 0 && not_ff == 0, "polled, short write");
+
+    // Without write data 0xff is clocked out
+    TEST_CHECK(dma(NULL, read_buf, 64) == E_SUCCESS, "DMA read only");
+    not_ff = 0;
+    for (uint32_t i = 0; i < 64; i++) not_ff += read_buf[i] != 0xff;
+    TEST_CHECK(not_ff == 0, "%u bytes read were not 0xff", not_ff);
+
+    TEST_CHECK(dma(write_buf, NULL, 64) == E_SUCCESS, "DMA write only");
+    TEST_CHECK(!LL_SPI_IsActiveFlag_BSY(SPI1), "bus left busy");
+    TEST_CHECK(!LL_DMA_IsEnabledStream(DMA2, LL_DMA_STREAM_2), "RX stream left enabled");
+}
+
+static void test_dma_refused(void)
+{
+    struct spi_transaction transaction = {
+        .write_data = write_buf,
+        .write_size = 16,
+        .read_data = read_buf,
+        .read_size = 8
+    };
+
+    TEST_CHECK(stm32f4xx_spi_dma_start(&spi1, &transaction) == E_INVALID_PARAMETER, "size mismatch");
+    transaction.read_size = transaction.write_size = 0;
+    TEST_CHECK(stm32f4xx_spi_dma_start(&spi1, &transaction) == E_INVALID_PARAMETER, "size 0");
+    transaction.read_size = transaction.write_size = 0x10000;
+    TEST_CHECK(stm32f4xx_spi_dma_start(&spi1, &transaction) == E_INVALID_PARAMETER, "size 65536");
+
+    // SPI1 is on DMA2, which must not serve APB2 and GPIO at the same time
+    TEST_CHECK(dma2_port_acquire(DMA2_PORT_AHB) == E_SUCCESS, "AHB port");
+    TEST_CHECK(dma(write_buf, read_buf, 16) == E_DEVICE_BUSY, "DMA2 serving GPIO");
+    dma2_port_release(DMA2_PORT_AHB);
+    TEST_CHECK(dma(write_buf, read_buf, 16) == E_SUCCESS, "DMA2 released");
+}
+
+static void test_stats(void)
+{
+    struct spi_stats stats;
+    uint64_t wire;
+
+    TEST_CHECK(stm32f4xx_spi_reset_stats(&spi1, portMAX_DELAY) == E_SUCCESS, "reset_stats");
+    fill(100, 7);
+    wire = sim_spi_wire_cycles(SPI1);
+    polled(100);
+    dma(write_buf, read_buf, 28);
+    wire = sim_spi_wire_cycles(SPI1) - wire;
+
+    TEST_CHECK(stm32f4xx_spi_get_stats(&spi1, &stats) == E_SUCCESS, "get_stats");
+    TEST_CHECK(stats.transactions == 2, "%u transactions", stats.transactions);
+    TEST_CHECK(stats.bytes == 128, "%u bytes", stats.bytes);
+    TEST_CHECK(stats.bus_cycles >= wire, "bus held %llu cycles, frames took %llu",
+        (unsigned long long)stats.bus_cycles, (unsigned long long)wire);
+    TEST_CHECK(stats.queue_depth == 0 && stats.dma_errors == 0, "queue %u, DMA errors %u", stats.queue_depth,
+        stats.dma_errors);
+}
+
+static void bench(void)
+{
+    static const struct {
+        uint32_t    prescaler;
+        const char  *sck;
+    } clocks[] = {
+        {LL_SPI_BAUDRATEPRESCALER_DIV2, "42 MHz"},
+        {LL_SPI_BAUDRATEPRESCALER_DIV16, "5.25 MHz"},
+    };
+
+    printf("SPI1 benchmark, simulated CPU cycles at 168 MHz, %u per register access:\n", SIM_ACCESS_CYCLES);
+
+    for (uint32_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++) {
+        stm32f4xx_spi_set_prescaler(&spi1, clocks[c].prescaler, TIMEOUT);
+        printf("  SCK %s\n  %8s %10s %10s %10s %10s\n", clocks[c].sck, "bytes", "wire", "polled", "DMA",
+            "DMA CPU");
+
+        for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            struct spi_transaction transaction = {
+                .write_data = write_buf,
+                .write_size = sizes[s],
+                .read_data = read_buf,
+                .read_size = sizes[s]
+            };
+            uint64_t wire, t0, t1, t2, t3, polled_cycles;
+
+            fill(sizes[s], s);
+            wire = sim_spi_wire_cycles(SPI1);
+            t0 = sim_cycles();
+            polled(sizes[s]);
+            polled_cycles = sim_cycles() - t0;
+            wire = sim_spi_wire_cycles(SPI1) - wire;
+
+            // The CPU is free from the return of dma_start until the last frame is out
+            t0 = sim_cycles();
+            stm32f4xx_spi_lock(&spi1, portMAX_DELAY);
+            stm32f4xx_spi_dma_start(&spi1, &transaction);
+            t1 = sim_cycles();
+            sim_spi_idle(SPI1);
+            t2 = sim_cycles();
+            stm32f4xx_spi_dma_wait(&spi1, TIMEOUT);
+            stm32f4xx_spi_unlock(&spi1);
+            t3 = sim_cycles();
+
+            printf("  %8u %10llu %10llu %10llu %10llu\n", sizes[s], (unsigned long long)wire,
+                (unsigned long long)polled_cycles, (unsigned long long)(t3 - t0),
+                (unsigned long long)(t1 - t0 + t3 - t2));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    sim_reset();
+    TEST_CHECK(spi1.ops->spi_init(&spi1) == E_SUCCESS, "init");
+    stm32f4xx_spi_set_prescaler(&spi1, LL_SPI_BAUDRATEPRESCALER_DIV2, TIMEOUT);
+
+    test_transfers();
+    test_dma_refused();
+    test_stats();
+
+    if (test_bench_requested(argc, argv)) bench();
+
+    return test_result("test_spi");
+}
@@ -0,0 +1,85 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+// Runs the NOR flash read stream on SPI1 against the register model in stub/stm32f4xx_sim.c. No
+// flash is modelled: with MISO looped back every byte read is 0xff. Checks who holds the bus and
+// its clock while a stream runs up to the end of the flash and is closed.
+
+#include "include/stm32f4xx/spi_nor.h"
+#include "include/stm32f4xx/spi.h"
+
+#include "test.h"
+
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_gpio.h"
+#include "stm32f4xx_ll_spi.h"
+
+// Busy-wait iterations, each at least one register access. Covers a read-ahead block
+#define TIMEOUT     1000000
+
+#define FLASH_SIZE  (16 * 1024 * 1024)
+// Not a multiple of the block size, so the last block is short
+#define TAIL_SIZE   (2 * SPI_NOR_READAHEAD_SIZE + 100)
+
+extern const struct spi_device spi1;
+extern const struct spi_nor_device spi_nor1;
+
+static void test_stream_to_end(void)
+{
+    const void *block;
+    uint32_t total = 0, not_ff = 0;
+    int32_t ret;
+
+    TEST_CHECK(spi_nor_stream_open(&spi_nor1, FLASH_SIZE - TAIL_SIZE, TIMEOUT) == E_SUCCESS, "open");
+    while ((ret = spi_nor_stream_next(&spi_nor1, &block, TIMEOUT)) > 0) {
+        // The read-ahead of the next block holds the bus, unless there is none
+        int32_t held = total + ret < TAIL_SIZE;
+        TEST_CHECK((stm32f4xx_spi_lock(&spi1, 0) == E_TIMEOUT) == held, "bus %s after %u bytes",
+            held ? "free" : "held", total + ret);
+        if (!held) stm32f4xx_spi_unlock(&spi1);
+
+        for (int32_t i = 0; i < ret; i++) not_ff += ((const uint8_t *)block)[i] != 0xff;
+        total += ret;
+    }
+    TEST_CHECK(ret == 0, "next returned %d", ret);
+    TEST_CHECK(total == TAIL_SIZE && not_ff == 0, "%u bytes read, %u not 0xff", total, not_ff);
+    TEST_CHECK(spi_nor_stream_next(&spi_nor1, &block, TIMEOUT) == 0, "next past the end");
+
+    // Another user takes the bus at its own clock before the stream is closed
+    TEST_CHECK(stm32f4xx_spi_lock(&spi1, 0) == E_SUCCESS, "bus not released at the end of the flash");
+    stm32f4xx_spi_set_prescaler(&spi1, LL_SPI_BAUDRATEPRESCALER_DIV16, TIMEOUT);
+
+    TEST_CHECK(spi_nor_stream_close(&spi_nor1, TIMEOUT) == E_SUCCESS, "close");
+    TEST_CHECK(stm32f4xx_spi_get_prescaler(&spi1) == LL_SPI_BAUDRATEPRESCALER_DIV16, "prescaler changed by close");
+    TEST_CHECK(stm32f4xx_spi_lock(&spi1, 0) == E_TIMEOUT, "bus released by close");
+    TEST_CHECK(LL_GPIO_IsOutputPinSet(GPIOC, LL_GPIO_PIN_4), "chip select asserted");
+    stm32f4xx_spi_unlock(&spi1);
+
+    // The stream can be opened again
+    TEST_CHECK(spi_nor_stream_open(&spi_nor1, 0, TIMEOUT) == E_SUCCESS, "reopen");
+    TEST_CHECK(spi_nor_stream_next(&spi_nor1, &block, TIMEOUT) == SPI_NOR_READAHEAD_SIZE, "next after reopen");
+    TEST_CHECK(spi_nor_stream_close(&spi_nor1, TIMEOUT) == E_SUCCESS, "close after reopen");
+    TEST_CHECK(stm32f4xx_spi_lock(&spi1, 0) == E_SUCCESS, "bus held after close");
+    TEST_CHECK(stm32f4xx_spi_get_prescaler(&spi1) == LL_SPI_BAUDRATEPRESCALER_DIV16, "prescaler not restored");
+    TEST_CHECK(LL_GPIO_IsOutputPinSet(GPIOC, LL_GPIO_PIN_4), "chip select asserted");
+    stm32f4xx_spi_unlock(&spi1);
+}
+
+int main(void)
+{
+    sim_reset();
+    TEST_CHECK(spi1.ops->spi_init(&spi1) == E_SUCCESS, "init");
+    // spi_nor_init() waits on DWT, which does not run in the model. Deselected, the flash is idle
+    LL_GPIO_SetOutputPin(GPIOC, LL_GPIO_PIN_4);
+
+    test_stream_to_end();
+
+    return test_result("test_spi_nor");
+}